@@ -18,9 +18,13 @@
  *
  */
 
+#include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <boost/program_options.hpp>
+#include <chrono>
 #include <filesystem>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <stdint.h>
@@ -28,7 +32,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
+#ifdef BBASM_ZLIB
+#include <zlib.h>
+#endif
 
 enum TokenType : int8_t
 {
@@ -54,27 +64,471 @@ std::vector<int> streamStack;
 
 std::vector<int> labels;
 std::vector<std::string> labelNames;
-std::map<std::string, int> labelIndex;
+std::unordered_map<std::string, int> labelIndex;
 
 std::vector<std::string> preText, postText;
 
-const char *skipWhitespace(const char *p)
+bool debug = false;
+int numThreads = 1;
+
+// Run fn(0) .. fn(count - 1) across numThreads threads
+void parallelFor(int count, const std::function<void(int)> &fn)
+{
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int i = next++; i < count; i = next++)
+            fn(i);
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < std::min(numThreads, count); t++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads)
+        t.join();
+}
+
+#ifdef BBASM_ZLIB
+// Compressed binary chipdb container. The blob is split into fixed size chunks, each compressed as an independent zlib
+// stream so that they can be decompressed in parallel; and relative pointers within the blob are unaffected, as it is
+// decompressed back into one contiguous buffer on load. All header fields are little endian:
+//   char     magic[8]                 "NPNRZDB1"
+//   uint64_t size                     uncompressed blob size
+//   uint32_t chunk_size               uncompressed size of every chunk but the last
+//   uint32_t num_chunks
+//   uint64_t offset[num_chunks + 1]   file offsets of the compressed chunks, followed by the end of the last one
+const uint32_t compressedChunkSize = 1 << 20;
+
+void writeLE(std::vector<uint8_t> &out, uint64_t value, int numBytes)
+{
+    for (int i = 0; i < numBytes; i++)
+        out.push_back(uint8_t(value >> (8 * i)));
+}
+
+void writeCompressed(FILE *fileOut, const std::vector<uint8_t> &data, bool verbose)
 {
-    if (p == nullptr)
-        return "";
-    while (*p == ' ' || *p == '\t')
-        p++;
-    return p;
+    uint32_t numChunks = (data.size() + compressedChunkSize - 1) / compressedChunkSize;
+    std::vector<uint8_t> header;
+    for (char c : std::string("NPNRZDB1"))
+        header.push_back(c);
+    writeLE(header, data.size(), 8);
+    writeLE(header, compressedChunkSize, 4);
+    writeLE(header, numChunks, 4);
+
+    std::vector<std::vector<uint8_t>> chunks(numChunks);
+    std::atomic<bool> failed{false};
+    parallelFor(numChunks, [&](int i) {
+        size_t start = size_t(i) * compressedChunkSize;
+        uLong rawSize = std::min<size_t>(compressedChunkSize, data.size() - start);
+        uLongf compSize = compressBound(rawSize);
+        chunks[i].resize(compSize);
+        int result = compress2(chunks[i].data(), &compSize, data.data() + start, rawSize, Z_BEST_COMPRESSION);
+        if (result != Z_OK)
+            failed = true;
+        chunks[i].resize(compSize);
+    });
+    if (failed) {
+        printf("Failed to compress output\n");
+        exit(-1);
+    }
+
+    uint64_t offset = header.size() + 8 * (numChunks + 1);
+    for (auto &chunk : chunks) {
+        writeLE(header, offset, 8);
+        offset += chunk.size();
+    }
+    writeLE(header, offset, 8);
+
+    if (verbose)
+        printf("compressed to %.2f MB in %d chunks\n", double(offset) / (1024 * 1024), int(numChunks));
+
+    fwrite(header.data(), header.size(), 1, fileOut);
+    for (auto &chunk : chunks)
+        fwrite(chunk.data(), chunk.size(), 1, fileOut);
+}
+#endif
+
+// Index of a label, allocating one on first use
+int getLabel(const std::string &name)
+{
+    auto found = labelIndex.find(name);
+    if (found != labelIndex.end())
+        return found->second;
+    int index = labels.size();
+    labelIndex.emplace(name, index);
+    if (debug)
+        labelNames.push_back(name);
+    labels.push_back(-1);
+    return index;
+}
+
+void pushStream(const std::string &name)
+{
+    if (streamIndex.count(name) == 0) {
+        streamIndex[name] = streams.size();
+        streams.resize(streams.size() + 1);
+        streams.back().name = name;
+    }
+    streamStack.push_back(streamIndex.at(name));
+}
+
+void popStream()
+{
+    assert(!streamStack.empty());
+    streamStack.pop_back();
+}
+
+void addToken(TokenType type, uint32_t value, std::string_view comment)
+{
+    assert(!streamStack.empty());
+    Stream &s = streams.at(streamStack.back());
+    s.tokenTypes.push_back(type);
+    s.tokenValues.push_back(value);
+    if (debug)
+        s.tokenComments.emplace_back(comment);
+}
+
+// Add a reference to a zero-terminated copy of a string, which is placed in the strings stream
+void addString(std::string_view value, std::string_view comment)
+{
+    int label = getLabel(std::string("str:").append(value));
+    addToken(TOK_REF, label, comment);
+    stringStream.tokenTypes.push_back(TOK_LABEL);
+    stringStream.tokenValues.push_back(label);
+    if (debug)
+        stringStream.tokenComments.push_back("");
+    for (size_t i = 0; i <= value.size(); i++) {
+        char c = (i < value.size()) ? value[i] : 0;
+        stringStream.tokenTypes.push_back(TOK_U8);
+        stringStream.tokenValues.push_back(c);
+        if (debug) {
+            char char_comment[4] = {'\'', c, '\'', 0};
+            if (c < 32 || c >= 127)
+                char_comment[0] = 0;
+            stringStream.tokenComments.push_back(char_comment);
+        }
+    }
+}
+
+std::vector<char> readFile(const std::string &filename)
+{
+    FILE *fileIn = fopen(filename.c_str(), "rb");
+    if (fileIn == nullptr) {
+        printf("Failed to open input file '%s'\n", filename.c_str());
+        exit(-1);
+    }
+    std::vector<char> data;
+    char buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), fileIn)) > 0)
+        data.insert(data.end(), buffer, buffer + count);
+    fclose(fileIn);
+    return data;
+}
+
+std::string_view skipWhitespace(std::string_view s)
+{
+    size_t start = s.find_first_not_of(" \t");
+    return (start == std::string_view::npos) ? std::string_view() : s.substr(start);
+}
+
+// Split off the first whitespace separated word of s, leaving the rest in s
+std::string_view nextWord(std::string_view &s)
+{
+    s = skipWhitespace(s);
+    size_t end = std::min(s.find_first_of(" \t"), s.size());
+    std::string_view word = s.substr(0, end);
+    s = s.substr(end);
+    return word;
+}
+
+// Parse the text form, as described in README.md
+void parseText(const std::vector<char> &input)
+{
+    std::string_view text(input.data(), input.size());
+    while (!text.empty()) {
+        size_t eol = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, eol);
+        text = text.substr(std::min(eol + 1, text.size()));
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        std::string_view cmd = nextWord(line);
+        if (cmd.empty())
+            continue;
+
+        if (cmd == "pre") {
+            preText.emplace_back(skipWhitespace(line));
+        } else if (cmd == "post") {
+            postText.emplace_back(skipWhitespace(line));
+        } else if (cmd == "push") {
+            pushStream(std::string(nextWord(line)));
+        } else if (cmd == "pop") {
+            popStream();
+        } else if (cmd == "label" || cmd == "ref") {
+            int label = getLabel(std::string(nextWord(line)));
+            addToken(cmd == "label" ? TOK_LABEL : TOK_REF, label, skipWhitespace(line));
+        } else if (cmd == "u8" || cmd == "u16" || cmd == "u32") {
+            uint32_t value = atoll(std::string(nextWord(line)).c_str());
+            addToken(cmd == "u8" ? TOK_U8 : cmd == "u16" ? TOK_U16 : TOK_U32, value, skipWhitespace(line));
+        } else if (cmd == "str") {
+            line = skipWhitespace(line);
+            assert(!line.empty());
+            size_t end = line.find(line.front(), 1);
+            assert(end != std::string_view::npos);
+            addString(line.substr(1, end - 1), skipWhitespace(line.substr(end + 1)));
+        } else {
+            assert(0);
+        }
+    }
+}
+
+// The binary form is a more compact alternative written by himbaechel_dbgen, which saves both writing and parsing the
+// text. After the magic, it is a sequence of records that each start with an opcode byte. Integers are encoded as
+// LEB128 and strings as their length followed by their bytes. Labels are numbered in the order of the BIN_NAME records
+// that give their names, and those numbers are used by BIN_LABEL and BIN_REF.
+const char binaryMagic[8] = {'\0', 'B', 'B', 'A', 'b', 'i', 'n', '1'};
+
+enum BinaryOp : uint8_t
+{
+    BIN_LABEL = 1, // label number
+    BIN_REF,       // label number
+    BIN_U8,        // value
+    BIN_U16,       // value
+    BIN_U32,       // value
+    BIN_STR,       // string
+    BIN_PUSH,      // stream name
+    BIN_POP,
+    BIN_PRE,  // string
+    BIN_POST, // string
+    BIN_NAME, // label name
+};
+
+bool isBinary(const std::vector<char> &input)
+{
+    return input.size() >= sizeof(binaryMagic) && memcmp(input.data(), binaryMagic, sizeof(binaryMagic)) == 0;
+}
+
+// Binary input is checked in full rather than with asserts, as a truncated or corrupt file must not be read past its
+// end in release builds
+[[noreturn]] void binaryError(size_t pos, const char *what)
+{
+    printf("Invalid binary input at offset %zu: %s\n", pos, what);
+    exit(-1);
+}
+
+void parseBinary(const std::vector<char> &input)
+{
+    if (!isBinary(input))
+        binaryError(0, "bad magic");
+    size_t pos = sizeof(binaryMagic);
+    auto readInt = [&]() {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            if (pos >= input.size())
+                binaryError(pos, "truncated integer");
+            if (shift >= 64)
+                binaryError(pos, "integer too long");
+            uint8_t byte = input[pos++];
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+    };
+    auto readString = [&]() {
+        uint64_t length = readInt();
+        if (length > input.size() - pos)
+            binaryError(pos, "truncated string");
+        std::string_view s(input.data() + pos, length);
+        pos += length;
+        return s;
+    };
+
+    std::vector<int> fileLabels;
+    while (pos < input.size()) {
+        uint8_t op = input[pos++];
+        if ((op >= BIN_LABEL && op <= BIN_STR) || op == BIN_POP) {
+            if (streamStack.empty())
+                binaryError(pos - 1, "record outside of any stream");
+        }
+        switch (op) {
+        case BIN_LABEL:
+        case BIN_REF: {
+            uint64_t label = readInt();
+            if (label >= fileLabels.size())
+                binaryError(pos, "undefined label number");
+            addToken(op == BIN_LABEL ? TOK_LABEL : TOK_REF, fileLabels[label], "");
+            break;
+        }
+        case BIN_U8:
+            addToken(TOK_U8, readInt(), "");
+            break;
+        case BIN_U16:
+            addToken(TOK_U16, readInt(), "");
+            break;
+        case BIN_U32:
+            addToken(TOK_U32, readInt(), "");
+            break;
+        case BIN_STR:
+            addString(readString(), "");
+            break;
+        case BIN_PUSH:
+            pushStream(std::string(readString()));
+            break;
+        case BIN_POP:
+            popStream();
+            break;
+        case BIN_PRE:
+            preText.emplace_back(readString());
+            break;
+        case BIN_POST:
+            postText.emplace_back(readString());
+            break;
+        case BIN_NAME:
+            fileLabels.push_back(getLabel(std::string(readString())));
+            break;
+        default:
+            binaryError(pos - 1, "unknown opcode");
+        }
+    }
+    if (!streamStack.empty())
+        binaryError(pos, "truncated input, a stream is still open");
+    if (streams.empty())
+        binaryError(pos, "no streams");
+}
+
+// A run of tokens within one stream. Streams are split into blocks so that the assembly passes can run in parallel
+struct Block
+{
+    int stream, begin, end;
+    int offset = 0, size = 0;
+    // positions of the labels in this block
+    std::vector<std::pair<int, int>> labelPositions;
+};
+
+int tokenSize(TokenType type)
+{
+    switch (type) {
+    case TOK_LABEL:
+        return 0;
+    case TOK_REF:
+        return 4;
+    case TOK_U8:
+        return 1;
+    case TOK_U16:
+        return 2;
+    case TOK_U32:
+        return 4;
+    default:
+        assert(0);
+        return 0;
+    }
+}
+
+void writeBlock(const Block &b, bool bigEndian, std::vector<uint8_t> &data)
+{
+    const Stream &s = streams.at(b.stream);
+    if (debug && b.begin == 0)
+        printf("-- %s --\n", s.name.c_str());
+
+    int cursor = b.offset;
+    for (int i = b.begin; i < b.end; i++) {
+        uint32_t value = s.tokenValues[i];
+        int numBytes = tokenSize(s.tokenTypes[i]);
+        if (s.tokenTypes[i] == TOK_REF)
+            value = labels[value] - cursor;
+
+        if (bigEndian) {
+            switch (numBytes) {
+            case 4:
+                data[cursor++] = value >> 24;
+                data[cursor++] = value >> 16;
+            /* fall-through */
+            case 2:
+                data[cursor++] = value >> 8;
+            /* fall-through */
+            case 1:
+                data[cursor++] = value;
+            /* fall-through */
+            case 0:
+                break;
+            default:
+                assert(0);
+            }
+        } else {
+            switch (numBytes) {
+            case 4:
+                data[cursor + 3] = value >> 24;
+                data[cursor + 2] = value >> 16;
+            /* fall-through */
+            case 2:
+                data[cursor + 1] = value >> 8;
+            /* fall-through */
+            case 1:
+                data[cursor] = value;
+            /* fall-through */
+            case 0:
+                break;
+            default:
+                assert(0);
+            }
+            cursor += numBytes;
+        }
+
+        if (debug) {
+            printf("%08x ", cursor - numBytes);
+            for (int k = cursor - numBytes; k < cursor; k++)
+                printf("%02x ", data[k]);
+            for (int k = numBytes; k < 4; k++)
+                printf("   ");
+
+            unsigned long long v = s.tokenValues[i];
+
+            switch (s.tokenTypes[i]) {
+            case TOK_LABEL:
+                if (s.tokenComments[i].empty())
+                    printf("label %s\n", labelNames[v].c_str());
+                else
+                    printf("label %-24s %s\n", labelNames[v].c_str(), s.tokenComments[i].c_str());
+                break;
+            case TOK_REF:
+                if (s.tokenComments[i].empty())
+                    printf("ref %s\n", labelNames[v].c_str());
+                else
+                    printf("ref %-26s %s\n", labelNames[v].c_str(), s.tokenComments[i].c_str());
+                break;
+            case TOK_U8:
+                if (s.tokenComments[i].empty())
+                    printf("u8 %llu\n", v);
+                else
+                    printf("u8 %-27llu %s\n", v, s.tokenComments[i].c_str());
+                break;
+            case TOK_U16:
+                if (s.tokenComments[i].empty())
+                    printf("u16 %-26llu\n", v);
+                else
+                    printf("u16 %-26llu %s\n", v, s.tokenComments[i].c_str());
+                break;
+            case TOK_U32:
+                if (s.tokenComments[i].empty())
+                    printf("u32 %-26llu\n", v);
+                else
+                    printf("u32 %-26llu %s\n", v, s.tokenComments[i].c_str());
+                break;
+            default:
+                assert(0);
+            }
+        }
+    }
+    assert(cursor == b.offset + b.size);
 }
 
 int main(int argc, char **argv)
 {
-    bool debug = false;
     bool verbose = false;
     bool bigEndian;
     bool writeC = false;
     bool writeE = false;
-    char buffer[512];
+    bool writeZ = false;
 
     namespace po = boost::program_options;
     po::positional_options_description pos;
@@ -86,6 +540,8 @@ int main(int argc, char **argv)
     options.add_options()("le,l", "little endian");
     options.add_options()("c,c", "write C strings");
     options.add_options()("e,e", "write #embed C");
+    options.add_options()("z,z", "write compressed binary");
+    options.add_options()("threads,j", po::value<int>(), "number of threads to use (default: all cores)");
     options.add_options()("files", po::value<std::vector<std::string>>(), "file parameters");
     pos.add("files", -1);
 
@@ -120,11 +576,25 @@ int main(int argc, char **argv)
         writeC = true;
     if (vm.count("e"))
         writeE = true;
-
-    if (writeC && writeE) {
+    if (vm.count("z"))
+        writeZ = true;
+    numThreads = std::max(1U, std::thread::hardware_concurrency());
+    if (vm.count("threads"))
+        numThreads = std::max(1, vm["threads"].as<int>());
+    // Debug output is printed as the data is written, so must be in order
+    if (debug)
+        numThreads = 1;
+
+    if (int(writeC) + int(writeE) + int(writeZ) > 1) {
         printf("Incompatible modes\n");
         exit(-1);
     }
+#ifndef BBASM_ZLIB
+    if (writeZ) {
+        printf("bbasm was built without zlib, compressed output is not supported\n");
+        exit(-1);
+    }
+#endif
     if (vm.count("files") == 0) {
         printf("File parameters are mandatory\n");
         exit(-1);
@@ -135,112 +605,17 @@ int main(int argc, char **argv)
         exit(-1);
     }
 
-    FILE *fileIn = fopen(files.at(0).c_str(), "rt");
-    assert(fileIn != nullptr);
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<char> input = readFile(files.at(0));
 
     FILE *fileOut = fopen(files.at(1).c_str(), writeC ? "wt" : "wb");
     assert(fileOut != nullptr);
 
-    while (fgets(buffer, 512, fileIn) != nullptr) {
-        std::string cmd = strtok(buffer, " \t\r\n");
-
-        if (cmd == "pre") {
-            const char *p = skipWhitespace(strtok(nullptr, "\r\n"));
-            preText.push_back(p);
-            continue;
-        }
-
-        if (cmd == "post") {
-            const char *p = skipWhitespace(strtok(nullptr, "\r\n"));
-            postText.push_back(p);
-            continue;
-        }
-
-        if (cmd == "push") {
-            const char *p = strtok(nullptr, " \t\r\n");
-            if (streamIndex.count(p) == 0) {
-                streamIndex[p] = streams.size();
-                streams.resize(streams.size() + 1);
-                streams.back().name = p;
-            }
-            streamStack.push_back(streamIndex.at(p));
-            continue;
-        }
-
-        if (cmd == "pop") {
-            streamStack.pop_back();
-            continue;
-        }
-
-        if (cmd == "label" || cmd == "ref") {
-            const char *label = strtok(nullptr, " \t\r\n");
-            const char *comment = skipWhitespace(strtok(nullptr, "\r\n"));
-            Stream &s = streams.at(streamStack.back());
-            if (labelIndex.count(label) == 0) {
-                labelIndex[label] = labels.size();
-                if (debug)
-                    labelNames.push_back(label);
-                labels.push_back(-1);
-            }
-            s.tokenTypes.push_back(cmd == "label" ? TOK_LABEL : TOK_REF);
-            s.tokenValues.push_back(labelIndex.at(label));
-            if (debug)
-                s.tokenComments.push_back(comment);
-            continue;
-        }
-
-        if (cmd == "u8" || cmd == "u16" || cmd == "u32") {
-            const char *value = strtok(nullptr, " \t\r\n");
-            const char *comment = skipWhitespace(strtok(nullptr, "\r\n"));
-            Stream &s = streams.at(streamStack.back());
-            s.tokenTypes.push_back(cmd == "u8" ? TOK_U8 : cmd == "u16" ? TOK_U16 : TOK_U32);
-            s.tokenValues.push_back(atoll(value));
-            if (debug)
-                s.tokenComments.push_back(comment);
-            continue;
-        }
-
-        if (cmd == "str") {
-            const char *value = skipWhitespace(strtok(nullptr, "\r\n"));
-            assert(*value != 0);
-            char *end = strchr((char *)value + 1, *value);
-            assert(end != nullptr);
-            *end = 0;
-            value += 1;
-            const char *comment = skipWhitespace(strtok(end + 1, "\r\n"));
-            std::string label = std::string("str:") + value;
-            Stream &s = streams.at(streamStack.back());
-            if (labelIndex.count(label) == 0) {
-                labelIndex[label] = labels.size();
-                if (debug)
-                    labelNames.push_back(label);
-                labels.push_back(-1);
-            }
-            s.tokenTypes.push_back(TOK_REF);
-            s.tokenValues.push_back(labelIndex.at(label));
-            if (debug)
-                s.tokenComments.push_back(comment);
-            stringStream.tokenTypes.push_back(TOK_LABEL);
-            stringStream.tokenValues.push_back(labelIndex.at(label));
-            stringStream.tokenComments.push_back("");
-            while (1) {
-                stringStream.tokenTypes.push_back(TOK_U8);
-                stringStream.tokenValues.push_back(*value);
-                if (debug) {
-                    char char_comment[4] = {'\'', *value, '\'', 0};
-                    if (*value < 32 || *value >= 127)
-                        char_comment[0] = 0;
-                    stringStream.tokenComments.push_back(char_comment);
-                }
-                if (*value == 0)
-                    break;
-                value++;
-            }
-            continue;
-        }
-
-        assert(0);
-    }
+    if (isBinary(input))
+        parseBinary(input);
+    else
+        parseText(input);
+    auto parsedTime = std::chrono::steady_clock::now();
 
     if (verbose) {
         printf("Constructed %d streams:\n", int(streams.size()));
@@ -256,155 +631,73 @@ int main(int argc, char **argv)
     streams.back().tokenValues.swap(stringStream.tokenValues);
     streams.back().tokenComments.swap(stringStream.tokenComments);
 
-    int cursor = 0;
-    for (auto &s : streams) {
-        for (int i = 0; i < int(s.tokenTypes.size()); i++) {
-            switch (s.tokenTypes[i]) {
-            case TOK_LABEL:
-                labels[s.tokenValues[i]] = cursor;
-                break;
-            case TOK_REF:
-                cursor += 4;
-                break;
-            case TOK_U8:
-                cursor += 1;
-                break;
-            case TOK_U16:
-                assert(cursor % 2 == 0);
-                cursor += 2;
-                break;
-            case TOK_U32:
-                assert(cursor % 4 == 0);
-                cursor += 4;
-                break;
-            default:
-                assert(0);
-            }
+    const int blockSize = 1 << 16;
+    std::vector<Block> blocks;
+    for (int i = 0; i < int(streams.size()); i++) {
+        int count = streams[i].tokenTypes.size();
+        for (int begin = 0; begin == 0 || begin < count; begin += blockSize) {
+            Block b;
+            b.stream = i;
+            b.begin = begin;
+            b.end = std::min(begin + blockSize, count);
+            blocks.push_back(b);
         }
     }
 
+    // The size of a block doesn't depend on its position, so all of them can be measured at once before being laid
+    // out one after the other
+    parallelFor(blocks.size(), [&](int i) {
+        Block &b = blocks[i];
+        const Stream &s = streams.at(b.stream);
+        for (int j = b.begin; j < b.end; j++)
+            b.size += tokenSize(s.tokenTypes[j]);
+    });
+
+    int cursor = 0;
+    for (auto &b : blocks) {
+        b.offset = cursor;
+        cursor += b.size;
+    }
+
+    parallelFor(blocks.size(), [&](int i) {
+        Block &b = blocks[i];
+        const Stream &s = streams.at(b.stream);
+        int pos = b.offset;
+        for (int j = b.begin; j < b.end; j++) {
+            TokenType type = s.tokenTypes[j];
+            if (type == TOK_LABEL)
+                b.labelPositions.emplace_back(s.tokenValues[j], pos);
+            else if (type == TOK_U16)
+                assert(pos % 2 == 0);
+            else if (type == TOK_U32)
+                assert(pos % 4 == 0);
+            pos += tokenSize(type);
+        }
+    });
+
+    // Strings that appear more than once are labelled each time, and the last one wins
+    for (auto &b : blocks)
+        for (auto &label : b.labelPositions)
+            labels[label.first] = label.second;
+
     if (verbose) {
         printf("resolved positions for %d labels.\n", int(labels.size()));
         printf("total data (including strings): %.2f MB\n", double(cursor) / (1024 * 1024));
     }
 
     std::vector<uint8_t> data(cursor);
+    parallelFor(blocks.size(), [&](int i) { writeBlock(blocks[i], bigEndian, data); });
 
-    cursor = 0;
-    for (auto &s : streams) {
-        if (debug)
-            printf("-- %s --\n", s.name.c_str());
-
-        for (int i = 0; i < int(s.tokenTypes.size()); i++) {
-            uint32_t value = s.tokenValues[i];
-            int numBytes = 0;
-
-            switch (s.tokenTypes[i]) {
-            case TOK_LABEL:
-                break;
-            case TOK_REF:
-                value = labels[value] - cursor;
-                numBytes = 4;
-                break;
-            case TOK_U8:
-                numBytes = 1;
-                break;
-            case TOK_U16:
-                numBytes = 2;
-                break;
-            case TOK_U32:
-                numBytes = 4;
-                break;
-            default:
-                assert(0);
-            }
-
-            if (bigEndian) {
-                switch (numBytes) {
-                case 4:
-                    data[cursor++] = value >> 24;
-                    data[cursor++] = value >> 16;
-                /* fall-through */
-                case 2:
-                    data[cursor++] = value >> 8;
-                /* fall-through */
-                case 1:
-                    data[cursor++] = value;
-                /* fall-through */
-                case 0:
-                    break;
-                default:
-                    assert(0);
-                }
-            } else {
-                switch (numBytes) {
-                case 4:
-                    data[cursor + 3] = value >> 24;
-                    data[cursor + 2] = value >> 16;
-                /* fall-through */
-                case 2:
-                    data[cursor + 1] = value >> 8;
-                /* fall-through */
-                case 1:
-                    data[cursor] = value;
-                /* fall-through */
-                case 0:
-                    break;
-                default:
-                    assert(0);
-                }
-                cursor += numBytes;
-            }
-
-            if (debug) {
-                printf("%08x ", cursor - numBytes);
-                for (int k = cursor - numBytes; k < cursor; k++)
-                    printf("%02x ", data[k]);
-                for (int k = numBytes; k < 4; k++)
-                    printf("   ");
-
-                unsigned long long v = s.tokenValues[i];
-
-                switch (s.tokenTypes[i]) {
-                case TOK_LABEL:
-                    if (s.tokenComments[i].empty())
-                        printf("label %s\n", labelNames[v].c_str());
-                    else
-                        printf("label %-24s %s\n", labelNames[v].c_str(), s.tokenComments[i].c_str());
-                    break;
-                case TOK_REF:
-                    if (s.tokenComments[i].empty())
-                        printf("ref %s\n", labelNames[v].c_str());
-                    else
-                        printf("ref %-26s %s\n", labelNames[v].c_str(), s.tokenComments[i].c_str());
-                    break;
-                case TOK_U8:
-                    if (s.tokenComments[i].empty())
-                        printf("u8 %llu\n", v);
-                    else
-                        printf("u8 %-27llu %s\n", v, s.tokenComments[i].c_str());
-                    break;
-                case TOK_U16:
-                    if (s.tokenComments[i].empty())
-                        printf("u16 %-26llu\n", v);
-                    else
-                        printf("u16 %-26llu %s\n", v, s.tokenComments[i].c_str());
-                    break;
-                case TOK_U32:
-                    if (s.tokenComments[i].empty())
-                        printf("u32 %-26llu\n", v);
-                    else
-                        printf("u32 %-26llu %s\n", v, s.tokenComments[i].c_str());
-                    break;
-                default:
-                    assert(0);
-                }
-            }
-        }
+    if (verbose) {
+        auto endTime = std::chrono::steady_clock::now();
+        double parseSecs = std::chrono::duration<double>(parsedTime - startTime).count();
+        double totalSecs = std::chrono::duration<double>(endTime - startTime).count();
+        printf("parsed %.2f MB of %s input in %.2fs, assembled %.2f MB in %.2fs total (%.1f MB/s) using %d threads\n",
+               double(input.size()) / (1024 * 1024), isBinary(input) ? "binary" : "text", parseSecs,
+               double(data.size()) / (1024 * 1024), totalSecs, double(data.size()) / (1024 * 1024) / totalSecs,
+               numThreads);
     }
 
-    assert(cursor == int(data.size()));
-
     if (writeC) {
         for (auto &s : preText)
             fprintf(fileOut, "%s\n", s.c_str());
@@ -457,6 +750,10 @@ int main(int argc, char **argv)
 
         for (auto &s : postText)
             fprintf(fileOut, "%s\n", s.c_str());
+    } else if (writeZ) {
+#ifdef BBASM_ZLIB
+        writeCompressed(fileOut, data, verbose);
+#endif
     } else {
         fwrite(data.data(), int(data.size()), 1, fileOut);
     }
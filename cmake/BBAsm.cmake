@@ -123,11 +123,16 @@ function(add_bba_compile_command)
 
     if (arg_MODE STREQUAL "binary" OR arg_MODE STREQUAL "resource")
 
+        # Compressed chipdbs must be loaded through a path that understands them, so this is opt-in per directory
+        if (arg_MODE STREQUAL "binary" AND BBASM_COMPRESS)
+            set(arg_COMPRESS_FLAG --z)
+        endif()
+
         add_custom_command(
             OUTPUT
                 ${CMAKE_CURRENT_BINARY_DIR}/${arg_OUTPUT_NAME}
             COMMAND
-                bbasm ${BBASM_ENDIAN_FLAG}
+                bbasm ${BBASM_ENDIAN_FLAG} ${arg_COMPRESS_FLAG}
                 ${arg_INPUT}
                 ${CMAKE_CURRENT_BINARY_DIR}/${arg_OUTPUT_NAME}
             DEPENDS
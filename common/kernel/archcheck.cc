@@ -17,17 +17,13 @@
  *
  */
 
+#include <algorithm>
 #include <list>
+#include <mutex>
 
 #include "log.h"
 #include "nextpnr.h"
 
-#if 0
-#define dbg(...) log(__VA_ARGS__)
-#else
-#define dbg(...)
-#endif
-
 USING_NEXTPNR_NAMESPACE
 
 #ifndef ARCH_MISTRAL
@@ -36,106 +32,253 @@ USING_NEXTPNR_NAMESPACE
 #define USING_LRU_CACHE
 #endif
 
+#ifdef ARCH_MACHXO2
+// getPipByName fills its cache one tile at a time, so may not be called from several threads at once
+#define SERIAL_PIP_NAMES
+#endif
+
 namespace {
 
-void archcheck_names(const Context *ctx)
+// Failures found by one shard of a check, keyed by the position of the shard so that they can be reported in a
+// deterministic order
+struct CheckFailures
+{
+    int64_t key = 0;
+    std::vector<std::string> messages;
+
+    void add(const char *cond, const std::string &what) { messages.push_back(stringf("%s: %s", what.c_str(), cond)); }
+};
+
+// Names for failure messages. The nameOf* functions share one unlocked ring buffer, so may not be used from the
+// worker threads that the checks run on
+std::string bel_name(const Context *ctx, BelId bel) { return ctx->getBelName(bel).str(ctx); }
+std::string wire_name(const Context *ctx, WireId wire) { return ctx->getWireName(wire).str(ctx); }
+std::string pip_name(const Context *ctx, PipId pip) { return ctx->getPipName(pip).str(ctx); }
+
+#define ARCHCHECK_ASSERT(failures, cond, ...)                                                                          \
+    do {                                                                                                               \
+        if (!(cond))                                                                                                   \
+            (failures).add(#cond, stringf(__VA_ARGS__));                                                               \
+    } while (0)
+
+// Runs checks over shards of a range of entities on the thread pool, optionally over a random sample of them only.
+// Failures are collected rather than stopping at the first one, and reported at the end of each check.
+class ArchChecker
 {
+  public:
+    ArchChecker(const Context *ctx, ThreadPool &pool, float sample, uint64_t seed)
+            : ctx(ctx), pool(pool), sample(sample)
+    {
+        rng.rngseed(seed);
+    }
+
+    const Context *ctx;
+    ThreadPool &pool;
+    // Fraction of entities that are checked
+    float sample;
+    DeterministicRNG rng;
+    int total_failures = 0;
+
+    // Items gathered and handed to the thread pool at once
+    static constexpr int block_size = 1 << 20;
+
+    bool sampled() const { return sample < 1.0f; }
+
+    // Call func(begin, end, failures) over contiguous shards of the items of range, or of the sample of them unless
+    // use_sample is false. The items are gathered in blocks, so that huge ranges such as all the pips of a large device
+    // are never held at once.
+    template <typename Trange, typename Tfunc>
+    void for_each_shard(const char *name, const Trange &range, int min_chunk, Tfunc func, bool use_sample = true)
+    {
+        using T = typename std::decay<decltype(*range.begin())>::type;
+        std::vector<T> block;
+        int64_t base = 0;
+        auto run_block = [&]() {
+            pool.run_ranges(name, int(block.size()), min_chunk, [&](int begin, int end) {
+                CheckFailures f;
+                f.key = base + begin;
+                func(block.data() + begin, block.data() + end, f);
+                if (!f.messages.empty()) {
+                    std::lock_guard<std::mutex> lock(failures_mutex);
+                    failures.push_back(std::move(f));
+                }
+            });
+            base += block.size();
+            block.clear();
+        };
+        for (const auto &item : range) {
+            if (use_sample && sampled() && rng.rngf(1.0f) >= sample)
+                continue;
+            block.push_back(item);
+            if (int(block.size()) == block_size)
+                run_block();
+        }
+        run_block();
+        checked = base;
+        checked_sample = use_sample;
+    }
+
+    // Call func(item, failures) for each item of range, or of the sample of them
+    template <typename Trange, typename Tfunc> void for_each(const char *name, const Trange &range, Tfunc func)
+    {
+        for_each_shard(name, range, 64, [&](const auto *begin, const auto *end, CheckFailures &f) {
+            for (auto it = begin; it != end; ++it)
+                func(*it, f);
+        });
+    }
+
+    // Log the failures of the last check, and the number of items checked if sampling
+    void report(const char *what)
+    {
+        const int max_logged = 10;
+        std::sort(failures.begin(), failures.end(),
+                  [](const CheckFailures &a, const CheckFailures &b) { return a.key < b.key; });
+        int count = 0;
+        for (const auto &f : failures)
+            for (const auto &msg : f.messages)
+                if (count++ < max_logged)
+                    log_nonfatal_error("%s\n", msg.c_str());
+        if (count > max_logged)
+            log_nonfatal_error("... and %d more %s failures\n", count - max_logged, what);
+        if (sampled() && checked_sample)
+            log_info("    checked %lld sampled %s\n", (long long)checked, what);
+        total_failures += count;
+        failures.clear();
+    }
+
+  private:
+    std::mutex failures_mutex;
+    std::vector<CheckFailures> failures;
+    int64_t checked = 0;
+    bool checked_sample = false;
+};
+
+// Some arches build their name and location lookup tables on first use, which must not happen from several threads
+// at once; so do one lookup of each kind up front
+void archcheck_warmup(const Context *ctx)
+{
+    for (BelId bel : ctx->getBels()) {
+        ctx->getBelByName(ctx->getBelName(bel));
+        ctx->getBelByLocation(ctx->getBelLocation(bel));
+        break;
+    }
+    for (WireId wire : ctx->getWires()) {
+        ctx->getWireByName(ctx->getWireName(wire));
+        break;
+    }
+#if !defined(ARCH_ECP5) && !defined(SERIAL_PIP_NAMES)
+    for (PipId pip : ctx->getPips()) {
+        ctx->getPipByName(ctx->getPipName(pip));
+        break;
+    }
+#endif
+}
+
+void archcheck_names(ArchChecker &chk)
+{
+    const Context *ctx = chk.ctx;
     log_info("Checking entity names.\n");
 
     log_info("Checking bel names..\n");
-    for (BelId bel : ctx->getBels()) {
+    chk.for_each("archcheck/bel_names", ctx->getBels(), [&](BelId bel, CheckFailures &f) {
         IdStringList name = ctx->getBelName(bel);
         BelId bel2 = ctx->getBelByName(name);
-        if (bel != bel2) {
-            log_error("bel != bel2, name = %s\n", ctx->nameOfBel(bel));
-        }
-    }
+        ARCHCHECK_ASSERT(f, bel == bel2, "bel %s", bel_name(ctx, bel).c_str());
+    });
+    chk.report("bel");
 
     log_info("Checking wire names..\n");
-    for (WireId wire : ctx->getWires()) {
+    chk.for_each("archcheck/wire_names", ctx->getWires(), [&](WireId wire, CheckFailures &f) {
         IdStringList name = ctx->getWireName(wire);
         WireId wire2 = ctx->getWireByName(name);
-        if (wire != wire2) {
-            log_error("wire != wire2, name = %s\n", ctx->nameOfWire(wire));
-        }
-    }
+        ARCHCHECK_ASSERT(f, wire == wire2, "wire %s", wire_name(ctx, wire).c_str());
+    });
+    chk.report("wire");
 
     log_info("Checking bucket names..\n");
-    for (BelBucketId bucket : ctx->getBelBuckets()) {
+    chk.for_each("archcheck/bucket_names", ctx->getBelBuckets(), [&](BelBucketId bucket, CheckFailures &f) {
         IdString name = ctx->getBelBucketName(bucket);
         BelBucketId bucket2 = ctx->getBelBucketByName(name);
-        if (bucket != bucket2) {
-            log_error("bucket != bucket2, name = %s\n", name.c_str(ctx));
-        }
-    }
+        ARCHCHECK_ASSERT(f, bucket == bucket2, "bucket %s", name.c_str(ctx));
+    });
+    chk.report("bucket");
 
 #ifndef ARCH_ECP5
     log_info("Checking pip names..\n");
-    for (PipId pip : ctx->getPips()) {
-        IdStringList name = ctx->getPipName(pip);
-        PipId pip2 = ctx->getPipByName(name);
-        if (pip != pip2) {
-            log_error("pip != pip2, name = %s\n", ctx->nameOfPip(pip));
-        }
-    }
+#ifdef SERIAL_PIP_NAMES
+    const int pip_chunk = ArchChecker::block_size;
+#else
+    const int pip_chunk = 64;
+#endif
+    chk.for_each_shard("archcheck/pip_names", ctx->getPips(), pip_chunk,
+                       [&](const PipId *begin, const PipId *end, CheckFailures &f) {
+                           for (const PipId *pip = begin; pip != end; ++pip) {
+                               IdStringList name = ctx->getPipName(*pip);
+                               PipId pip2 = ctx->getPipByName(name);
+                               ARCHCHECK_ASSERT(f, *pip == pip2, "pip %s", pip_name(ctx, *pip).c_str());
+                           }
+                       });
+    chk.report("pip");
 #endif
     log_break();
 }
 
-void archcheck_locs(const Context *ctx)
+void archcheck_locs(ArchChecker &chk)
 {
+    const Context *ctx = chk.ctx;
     log_info("Checking location data.\n");
 
     log_info("Checking all bels..\n");
-    for (BelId bel : ctx->getBels()) {
-        log_assert(bel != BelId());
-        dbg("> %s\n", ctx->getBelName(bel).c_str(ctx));
+    chk.for_each("archcheck/bel_locs", ctx->getBels(), [&](BelId bel, CheckFailures &f) {
+        ARCHCHECK_ASSERT(f, bel != BelId(), "null bel");
+        if (bel == BelId())
+            return;
 
         Loc loc = ctx->getBelLocation(bel);
-        dbg("   ... %d %d %d\n", loc.x, loc.y, loc.z);
-
-        log_assert(0 <= loc.x);
-        log_assert(0 <= loc.y);
-        log_assert(0 <= loc.z);
-        log_assert(loc.x < ctx->getGridDimX());
-        log_assert(loc.y < ctx->getGridDimY());
-        log_assert(loc.z < ctx->getTileBelDimZ(loc.x, loc.y));
+        ARCHCHECK_ASSERT(f, 0 <= loc.x, "bel %s", bel_name(ctx, bel).c_str());
+        ARCHCHECK_ASSERT(f, 0 <= loc.y, "bel %s", bel_name(ctx, bel).c_str());
+        ARCHCHECK_ASSERT(f, 0 <= loc.z, "bel %s", bel_name(ctx, bel).c_str());
+        ARCHCHECK_ASSERT(f, loc.x < ctx->getGridDimX(), "bel %s", bel_name(ctx, bel).c_str());
+        ARCHCHECK_ASSERT(f, loc.y < ctx->getGridDimY(), "bel %s", bel_name(ctx, bel).c_str());
+        if (loc.x < 0 || loc.y < 0 || loc.x >= ctx->getGridDimX() || loc.y >= ctx->getGridDimY())
+            return;
+        ARCHCHECK_ASSERT(f, loc.z < ctx->getTileBelDimZ(loc.x, loc.y), "bel %s", bel_name(ctx, bel).c_str());
 
         BelId bel2 = ctx->getBelByLocation(loc);
-        dbg("   ... %s\n", ctx->getBelName(bel2).c_str(ctx));
-        log_assert(bel == bel2);
-    }
+        ARCHCHECK_ASSERT(f, bel == bel2, "bel %s at (%d, %d, %d)", bel_name(ctx, bel).c_str(), loc.x, loc.y, loc.z);
+    });
+    chk.report("bel location");
 
     log_info("Checking all locations..\n");
+    std::vector<Loc> tiles;
     for (int x = 0; x < ctx->getGridDimX(); x++)
-        for (int y = 0; y < ctx->getGridDimY(); y++) {
-            dbg("> %d %d\n", x, y);
-            pool<int> usedz;
-
-            for (int z = 0; z < ctx->getTileBelDimZ(x, y); z++) {
-                BelId bel = ctx->getBelByLocation(Loc(x, y, z));
-                if (bel == BelId())
-                    continue;
-                Loc loc = ctx->getBelLocation(bel);
-                dbg("   + %d %s\n", z, ctx->nameOfBel(bel));
-                log_assert(x == loc.x);
-                log_assert(y == loc.y);
-                log_assert(z == loc.z);
-                usedz.insert(z);
-            }
-
-            for (BelId bel : ctx->getBelsByTile(x, y)) {
-                Loc loc = ctx->getBelLocation(bel);
-                dbg("   - %d %s\n", loc.z, ctx->nameOfBel(bel));
-                log_assert(x == loc.x);
-                log_assert(y == loc.y);
-                log_assert(usedz.count(loc.z));
-                usedz.erase(loc.z);
-            }
+        for (int y = 0; y < ctx->getGridDimY(); y++)
+            tiles.emplace_back(x, y, 0);
+    chk.for_each("archcheck/tile_locs", tiles, [&](Loc tile, CheckFailures &f) {
+        int x = tile.x, y = tile.y;
+        pool<int> usedz;
+
+        for (int z = 0; z < ctx->getTileBelDimZ(x, y); z++) {
+            BelId bel = ctx->getBelByLocation(Loc(x, y, z));
+            if (bel == BelId())
+                continue;
+            Loc loc = ctx->getBelLocation(bel);
+            ARCHCHECK_ASSERT(f, x == loc.x && y == loc.y && z == loc.z, "bel %s by location (%d, %d, %d)",
+                             bel_name(ctx, bel).c_str(), x, y, z);
+            usedz.insert(z);
+        }
 
-            log_assert(usedz.empty());
+        for (BelId bel : ctx->getBelsByTile(x, y)) {
+            Loc loc = ctx->getBelLocation(bel);
+            ARCHCHECK_ASSERT(f, x == loc.x && y == loc.y, "bel %s by tile (%d, %d)", bel_name(ctx, bel).c_str(), x, y);
+            ARCHCHECK_ASSERT(f, usedz.count(loc.z), "bel %s by tile (%d, %d)", bel_name(ctx, bel).c_str(), x, y);
+            usedz.erase(loc.z);
         }
 
+        ARCHCHECK_ASSERT(f, usedz.empty(), "tile (%d, %d)", x, y);
+    });
+    chk.report("tile");
+
     log_break();
 }
 
@@ -250,44 +393,92 @@ struct LruWireCacheMap
     }
 };
 
-void archcheck_conn(const Context *ctx)
+void archcheck_conn(ArchChecker &chk)
 {
+    const Context *ctx = chk.ctx;
     log_info("Checking connectivity data.\n");
 
+    // When sampling, only some wires are visited, so the pip checks below can't rely on a map built from them
+    const bool scan_pips = chk.sampled();
+
     log_info("Checking all wires...\n");
 
 #ifndef USING_LRU_CACHE
     dict<PipId, WireId> pips_downhill;
     dict<PipId, WireId> pips_uphill;
+    std::mutex pips_mutex;
+    // Pips from each shard, merged into the maps afterwards in shard order
+    std::vector<std::pair<int64_t, std::vector<std::pair<PipId, WireId>>>> shard_downhill, shard_uphill;
 #endif
 
-    for (WireId wire : ctx->getWires()) {
-        for (BelPin belpin : ctx->getWireBelPins(wire)) {
-            WireId wire2 = ctx->getBelPinWire(belpin.bel, belpin.pin);
-            log_assert(wire == wire2);
-        }
-
-        for (PipId pip : ctx->getPipsDownhill(wire)) {
-            WireId wire2 = ctx->getPipSrcWire(pip);
-            log_assert(wire == wire2);
+    chk.for_each_shard("archcheck/wires", ctx->getWires(), 64,
+                       [&](const WireId *begin, const WireId *end, CheckFailures &f) {
 #ifndef USING_LRU_CACHE
-            auto result = pips_downhill.emplace(pip, wire);
-            log_assert(result.second);
+                           std::vector<std::pair<PipId, WireId>> downhill, uphill;
 #endif
-        }
+                           for (const WireId *it = begin; it != end; ++it) {
+                               WireId wire = *it;
+                               for (BelPin belpin : ctx->getWireBelPins(wire)) {
+                                   WireId wire2 = ctx->getBelPinWire(belpin.bel, belpin.pin);
+                                   ARCHCHECK_ASSERT(f, wire == wire2, "wire %s bel pin %s.%s",
+                                                    wire_name(ctx, wire).c_str(), bel_name(ctx, belpin.bel).c_str(),
+                                                    belpin.pin.c_str(ctx));
+                               }
+
+                               for (PipId pip : ctx->getPipsDownhill(wire)) {
+                                   WireId wire2 = ctx->getPipSrcWire(pip);
+                                   ARCHCHECK_ASSERT(f, wire == wire2, "wire %s downhill pip %s",
+                                                    wire_name(ctx, wire).c_str(), pip_name(ctx, pip).c_str());
+#ifndef USING_LRU_CACHE
+                                   if (!scan_pips)
+                                       downhill.emplace_back(pip, wire);
+#endif
+                               }
 
-        for (PipId pip : ctx->getPipsUphill(wire)) {
-            WireId wire2 = ctx->getPipDstWire(pip);
-            log_assert(wire == wire2);
+                               for (PipId pip : ctx->getPipsUphill(wire)) {
+                                   WireId wire2 = ctx->getPipDstWire(pip);
+                                   ARCHCHECK_ASSERT(f, wire == wire2, "wire %s uphill pip %s",
+                                                    wire_name(ctx, wire).c_str(), pip_name(ctx, pip).c_str());
 #ifndef USING_LRU_CACHE
-            auto result = pips_uphill.emplace(pip, wire);
-            log_assert(result.second);
+                                   if (!scan_pips)
+                                       uphill.emplace_back(pip, wire);
 #endif
-        }
+                               }
+                           }
+#ifndef USING_LRU_CACHE
+                           std::lock_guard<std::mutex> lock(pips_mutex);
+                           shard_downhill.emplace_back(f.key, std::move(downhill));
+                           shard_uphill.emplace_back(f.key, std::move(uphill));
+#endif
+                       });
+
+#ifndef USING_LRU_CACHE
+    if (!scan_pips) {
+        CheckFailures f;
+        auto merge = [&](std::vector<std::pair<int64_t, std::vector<std::pair<PipId, WireId>>>> &shards,
+                         dict<PipId, WireId> &pips, const char *dir) {
+            std::sort(shards.begin(), shards.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            for (auto &shard : shards)
+                for (auto &entry : shard.second) {
+                    bool inserted = pips.emplace(entry.first, entry.second).second;
+                    ARCHCHECK_ASSERT(f, inserted, "pip %s %s of more than one wire",
+                                     pip_name(ctx, entry.first).c_str(), dir);
+                }
+            shards.clear();
+            // Lookups may rehash the map on first use, which must happen before it is read from several threads
+            pips.count(PipId());
+        };
+        merge(shard_downhill, pips_downhill, "downhill");
+        merge(shard_uphill, pips_uphill, "uphill");
+        for (auto &msg : f.messages)
+            log_nonfatal_error("%s\n", msg.c_str());
+        chk.total_failures += int(f.messages.size());
     }
+#endif
+    chk.report("wire");
 
     log_info("Checking all BELs...\n");
-    for (BelId bel : ctx->getBels()) {
+    chk.for_each("archcheck/bel_pins", ctx->getBels(), [&](BelId bel, CheckFailures &f) {
         for (IdString pin : ctx->getBelPins(bel)) {
             WireId wire = ctx->getBelPinWire(bel, pin);
 
@@ -303,108 +494,169 @@ void archcheck_conn(const Context *ctx)
                 }
             }
 
-            log_assert(found_belpin);
+            ARCHCHECK_ASSERT(f, found_belpin, "bel pin %s.%s", bel_name(ctx, bel).c_str(), pin.c_str(ctx));
         }
-    }
+    });
+    chk.report("bel pin");
+
+    log_info("Checking all PIPs...\n");
+    chk.for_each_shard("archcheck/pips", ctx->getPips(), 1024,
+                       [&](const PipId *begin, const PipId *end, CheckFailures &f) {
 #ifdef USING_LRU_CACHE
-    // This cache is used to meet two goals:
-    //  - Avoid linear scan by invoking getPipsDownhill/getPipsUphill directly.
-    //  - Avoid having pip -> wire maps for the entire part.
-    //
-    // The overhead of maintaining the cache is small relatively to the memory
-    // gains by avoiding the full pip -> wire map, and still preserves a fast
-    // pip -> wire, assuming that pips are returned from getPips with some
-    // chip locality.
-    LruWireCacheMap pip_cache(ctx, /*cache_size=*/64 * 1024);
+                           // This cache is used to meet two goals:
+                           //  - Avoid linear scan by invoking getPipsDownhill/getPipsUphill directly.
+                           //  - Avoid having pip -> wire maps for the entire part.
+                           //
+                           // The overhead of maintaining the cache is small relatively to the memory
+                           // gains by avoiding the full pip -> wire map, and still preserves a fast
+                           // pip -> wire, assuming that pips are returned from getPips with some
+                           // chip locality. Each shard has its own, splitting the original budget.
+                           LruWireCacheMap pip_cache(ctx, std::max<size_t>(4096, 64 * 1024 / chk.pool.size()));
 #endif
-    log_info("Checking all PIPs...\n");
-    for (PipId pip : ctx->getPips()) {
-        WireId src_wire = ctx->getPipSrcWire(pip);
-        if (src_wire != WireId()) {
+                           auto listed = [](const auto &range, PipId pip) {
+                               for (PipId p : range)
+                                   if (p == pip)
+                                       return true;
+                               return false;
+                           };
+                           for (const PipId *it = begin; it != end; ++it) {
+                               PipId pip = *it;
+                               WireId src_wire = ctx->getPipSrcWire(pip);
+                               if (src_wire != WireId()) {
+                                   bool downhill;
+                                   if (scan_pips)
+                                       downhill = listed(ctx->getPipsDownhill(src_wire), pip);
+                                   else
 #ifdef USING_LRU_CACHE
-            log_assert(pip_cache.isPipDownhill(pip, src_wire));
+                                       downhill = pip_cache.isPipDownhill(pip, src_wire);
 #else
-            log_assert(pips_downhill.at(pip) == src_wire);
+                                       downhill = pips_downhill.count(pip) && pips_downhill.at(pip) == src_wire;
 #endif
-        }
-
-        WireId dst_wire = ctx->getPipDstWire(pip);
-        if (dst_wire != WireId()) {
+                                   ARCHCHECK_ASSERT(f, downhill, "pip %s", pip_name(ctx, pip).c_str());
+                               }
+
+                               WireId dst_wire = ctx->getPipDstWire(pip);
+                               if (dst_wire != WireId()) {
+                                   bool uphill;
+                                   if (scan_pips)
+                                       uphill = listed(ctx->getPipsUphill(dst_wire), pip);
+                                   else
 #ifdef USING_LRU_CACHE
-            log_assert(pip_cache.isPipUphill(pip, dst_wire));
+                                       uphill = pip_cache.isPipUphill(pip, dst_wire);
 #else
-            log_assert(pips_uphill.at(pip) == dst_wire);
+                                       uphill = pips_uphill.count(pip) && pips_uphill.at(pip) == dst_wire;
 #endif
-        }
-    }
+                                   ARCHCHECK_ASSERT(f, uphill, "pip %s", pip_name(ctx, pip).c_str());
+                               }
+                           }
+                       });
+    chk.report("pip");
 }
 
-void archcheck_buckets(const Context *ctx)
+void archcheck_buckets(ArchChecker &chk)
 {
+    const Context *ctx = chk.ctx;
     log_info("Checking bucket data.\n");
 
+    // Sampling applies to the BELs visited for each bucket, rather than to the few buckets themselves
+    std::vector<BelId> bels;
+    for (BelId bel : ctx->getBels())
+        if (!chk.sampled() || chk.rng.rngf(1.0f) < chk.sample)
+            bels.push_back(bel);
+
+    // getCellTypes() may be computed on each call, so look it up just once
+    std::vector<std::pair<IdString, BelBucketId>> cell_types;
+    for (IdString cell_type : ctx->getCellTypes())
+        cell_types.emplace_back(cell_type, ctx->getBelBucketForCellType(cell_type));
+
     // BEL buckets should be subsets of BELs that form an exact cover.
     // In particular that means cell types in a bucket should only be
     // placable in that bucket.
-    for (BelBucketId bucket : ctx->getBelBuckets()) {
-
-        // Find out which cell types are in this bucket.
-        pool<IdString> cell_types_in_bucket;
-        for (IdString cell_type : ctx->getCellTypes()) {
-            if (ctx->getBelBucketForCellType(cell_type) == bucket) {
-                cell_types_in_bucket.insert(cell_type);
-            }
-        }
-
-        // Make sure that all cell types in this bucket have at least one
-        // BelId they can be placed at.
-        pool<IdString> cell_types_unused;
-
-        pool<BelId> bels_in_bucket;
-        for (BelId bel : ctx->getBelsInBucket(bucket)) {
-            BelBucketId bucket2 = ctx->getBelBucketForBel(bel);
-            log_assert(bucket == bucket2);
-
-            bels_in_bucket.insert(bel);
-
-            // Check to see if a cell type not in this bucket can be
-            // placed at a BEL in this bucket.
-            for (IdString cell_type : ctx->getCellTypes()) {
-                if (ctx->getBelBucketForCellType(cell_type) == bucket) {
-                    if (ctx->isValidBelForCellType(cell_type, bel)) {
-                        cell_types_unused.erase(cell_type);
-                    }
-                } else {
-                    log_assert(!ctx->isValidBelForCellType(cell_type, bel));
-                }
-            }
-        }
-
-        // Verify that any BEL not in this bucket reports a different
-        // bucket.
-        for (BelId bel : ctx->getBels()) {
-            if (ctx->getBelBucketForBel(bel) != bucket) {
-                log_assert(bels_in_bucket.count(bel) == 0);
-            }
-        }
-
-        log_assert(cell_types_unused.empty());
-    }
+    std::vector<BelBucketId> buckets;
+    for (BelBucketId bucket : ctx->getBelBuckets())
+        buckets.push_back(bucket);
+    chk.for_each_shard("archcheck/buckets", buckets, 1,
+                       [&](const BelBucketId *begin, const BelBucketId *end, CheckFailures &f) {
+                           for (const BelBucketId *it = begin; it != end; ++it) {
+                               BelBucketId bucket = *it;
+                               const char *bucket_name = ctx->getBelBucketName(bucket).c_str(ctx);
+
+                               // Find out which cell types are in this bucket.
+                               pool<IdString> cell_types_in_bucket;
+                               for (auto &cell_type : cell_types) {
+                                   if (cell_type.second == bucket) {
+                                       cell_types_in_bucket.insert(cell_type.first);
+                                   }
+                               }
+
+                               // Make sure that all cell types in this bucket have at least one
+                               // BelId they can be placed at.
+                               pool<IdString> cell_types_unused;
+
+                               pool<BelId> bels_in_bucket;
+                               for (BelId bel : ctx->getBelsInBucket(bucket)) {
+                                   BelBucketId bucket2 = ctx->getBelBucketForBel(bel);
+                                   ARCHCHECK_ASSERT(f, bucket == bucket2, "bucket %s bel %s", bucket_name,
+                                                    bel_name(ctx, bel).c_str());
+
+                                   bels_in_bucket.insert(bel);
+
+                                   // Check to see if a cell type not in this bucket can be
+                                   // placed at a BEL in this bucket.
+                                   for (auto &cell_type : cell_types) {
+                                       if (cell_type.second == bucket) {
+                                           if (ctx->isValidBelForCellType(cell_type.first, bel)) {
+                                               cell_types_unused.erase(cell_type.first);
+                                           }
+                                       } else {
+                                           ARCHCHECK_ASSERT(f, !ctx->isValidBelForCellType(cell_type.first, bel),
+                                                            "bucket %s bel %s cell type %s", bucket_name,
+                                                            bel_name(ctx, bel).c_str(), cell_type.first.c_str(ctx));
+                                       }
+                                   }
+                               }
+
+                               // Verify that any BEL not in this bucket reports a different
+                               // bucket.
+                               for (BelId bel : bels) {
+                                   if (ctx->getBelBucketForBel(bel) != bucket) {
+                                       ARCHCHECK_ASSERT(f, bels_in_bucket.count(bel) == 0, "bucket %s bel %s",
+                                                        bucket_name, bel_name(ctx, bel).c_str());
+                                   }
+                               }
+
+                               ARCHCHECK_ASSERT(f, cell_types_unused.empty(), "bucket %s", bucket_name);
+                           }
+                       },
+                       false);
+    chk.report("bucket");
 }
 
 } // namespace
 
 NEXTPNR_NAMESPACE_BEGIN
 
-void Context::archcheck() const
+void Context::archcheck()
 {
     log_info("Running architecture database integrity check.\n");
+    float sample = setting<float>("archcheck/sample", 1.0f);
+    if (sample <= 0 || sample > 1)
+        log_error("archcheck sample fraction must be in (0, 1], got %g\n", sample);
+    ArchChecker chk(this, thread_pool(), sample, rngstate);
+    if (chk.sampled())
+        log_info("Checking a random %g%% of entities, on %d threads.\n", 100.0 * sample, chk.pool.size());
+    else
+        log_info("Checking on %d threads.\n", chk.pool.size());
     log_break();
 
-    archcheck_names(this);
-    archcheck_locs(this);
-    archcheck_conn(this);
-    archcheck_buckets(this);
+    archcheck_warmup(this);
+    archcheck_names(chk);
+    archcheck_locs(chk);
+    archcheck_conn(chk);
+    archcheck_buckets(chk);
+
+    if (chk.total_failures > 0)
+        log_error("Architecture database integrity check failed with %d errors.\n", chk.total_failures);
 }
 
 NEXTPNR_NAMESPACE_END
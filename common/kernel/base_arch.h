@@ -27,6 +27,7 @@
 #include "arch_api.h"
 #include "base_clusterinfo.h"
 #include "idstring.h"
+#include "legality_cache.h"
 #include "nextpnr_types.h"
 
 NEXTPNR_NAMESPACE_BEGIN
@@ -451,6 +452,12 @@ template <typename R> struct BaseArch : ArchAPI<R>
         bb.x1 = std::min(bb.x1 + 1, this->getGridDimX());
         bb.y1 = std::min(bb.y1 + 1, this->getGridDimY());
     }
+    // Default implementation has no dense wire index, so routers must build their own wire lookup
+    virtual int getDenseWireCount() const override { return -1; }
+    virtual int getDenseWireIndex(WireId /*wire*/) const override
+    {
+        NPNR_ASSERT_FALSE("getDenseWireIndex called for arch without dense wire indices");
+    }
 
     // Resource methods
     virtual GroupId getResourceKeyForPip(PipId /*pip*/) const override { return GroupId(); }
@@ -468,6 +475,9 @@ template <typename R> struct BaseArch : ArchAPI<R>
     dict<WireId, NetInfo *> base_wire2net;
     dict<PipId, NetInfo *> base_pip2net;
 
+    // Query and hit counts of the cached legality checks behind isBelLocationValid, for arches that have them
+    mutable LegalityCacheStats legality_stats;
+
     // For the default cell/bel bucket implementations
     std::vector<IdString> cell_types;
     std::vector<BelBucketId> bel_buckets;
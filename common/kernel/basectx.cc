@@ -23,9 +23,19 @@
 
 #include "context.h"
 #include "log.h"
+#include "util.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
+ThreadPool &BaseCtx::thread_pool()
+{
+    std::call_once(thread_pool_once, [&]() {
+        int threads = int_or_default(settings, id("threads"), int(std::thread::hardware_concurrency()));
+        thread_pool_ptr = std::make_unique<ThreadPool>(std::max(1, threads));
+    });
+    return *thread_pool_ptr;
+}
+
 IdString BaseCtx::idf(const char *fmt, ...) const
 {
     std::string string;
@@ -306,6 +316,25 @@ CellInfo *BaseCtx::createCell(IdString name, IdString type)
     return ptr;
 }
 
+namespace {
+template <typename T> void erase_marked(dict<IdString, T> &objects, pool<IdString> &marked)
+{
+    if (marked.empty())
+        return;
+    objects.erase_if([&](const std::pair<IdString, T> &entry) { return marked.count(entry.first) > 0; });
+    marked.clear();
+}
+} // namespace
+
+void BaseCtx::flushDeletions()
+{
+    if (cells_to_delete.empty() && nets_to_delete.empty())
+        return;
+    erase_marked(cells, cells_to_delete);
+    erase_marked(nets, nets_to_delete);
+    refreshUi();
+}
+
 void BaseCtx::copyBelPorts(IdString cell, BelId bel)
 {
     CellInfo *cell_info = cells.at(cell).get();
@@ -21,6 +21,8 @@
 #ifndef BASECTX_H
 #define BASECTX_H
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -30,10 +32,12 @@
 
 #include "hashlib.h"
 #include "idstring.h"
+#include "idstring_db.h"
 #include "nextpnr_namespaces.h"
 #include "nextpnr_types.h"
 #include "property.h"
 #include "str_ring_buffer.h"
+#include "thread_pool.h"
 
 NEXTPNR_NAMESPACE_BEGIN
 
@@ -50,11 +54,12 @@ struct BaseCtx
     // method will lock/unlock it when its' released the main mutex to make
     // sure the UI is not starved.
     std::mutex ui_mutex;
+    // Number of threads blocked in lock_ui(); yield() only hands over the lock when this is non-zero
+    std::atomic<int> ui_waiting{0};
 #endif
 
-    // ID String database.
-    mutable std::unordered_map<std::string, int> *idstring_str_to_idx;
-    mutable std::vector<const std::string *> *idstring_idx_to_str;
+    // ID String database; unlike the rest of the context, this may be used from several threads at once
+    mutable IdStringDB *idstring_db;
 
     // Temporary string backing store for logging
     mutable StrRingBuffer log_strs;
@@ -65,6 +70,8 @@ struct BaseCtx
     // Placed nets and cells.
     dict<IdString, std::unique_ptr<NetInfo>> nets;
     dict<IdString, std::unique_ptr<CellInfo>> cells;
+    // Cells and nets pending removal by flushDeletions()
+    pool<IdString> cells_to_delete, nets_to_delete;
 
     // Hierarchical (non-leaf) cells by full path
     dict<IdString, HierarchicalCell> hierarchy;
@@ -92,10 +99,13 @@ struct BaseCtx
     // Has the frontend loaded a design?
     bool design_loaded;
 
+    // Worker threads shared between passes, created on first use
+    std::unique_ptr<ThreadPool> thread_pool_ptr;
+    std::once_flag thread_pool_once;
+
     BaseCtx()
     {
-        idstring_str_to_idx = new std::unordered_map<std::string, int>;
-        idstring_idx_to_str = new std::vector<const std::string *>;
+        idstring_db = new IdStringDB;
         IdString::initialize_add(this, "", 0);
         IdString::initialize_arch(this);
 
@@ -104,8 +114,7 @@ struct BaseCtx
 
     virtual ~BaseCtx()
     {
-        delete idstring_str_to_idx;
-        delete idstring_idx_to_str;
+        delete idstring_db;
     }
 
     // Must be called before performing any mutating changes on the Ctx/Arch.
@@ -126,12 +135,15 @@ struct BaseCtx
     }
 
     // Must be called by the UI before rendering data. This lock will be
-    // prioritized when processing code calls yield().
+    // prioritized when processing code calls yield(). It excludes the
+    // processing code for as long as it is held, so keep UI reads short.
     void lock_ui(void)
     {
 #ifndef NPNR_DISABLE_THREADS
+        ui_waiting++;
         ui_mutex.lock();
         mutex.lock();
+        ui_waiting--;
 #endif
     }
 
@@ -146,11 +158,14 @@ struct BaseCtx
     // Yield to UI by unlocking the main mutex, flashing the UI mutex and
     // relocking the main mutex. Call this when you're performing a
     // long-standing action while holding a lock to let the UI show
-    // visualization updates.
+    // visualization updates. This is cheap when nothing is waiting, so it
+    // may be called often.
     // Must be called with the main lock taken.
     void yield(void)
     {
 #ifndef NPNR_DISABLE_THREADS
+        if (ui_waiting.load(std::memory_order_acquire) == 0)
+            return;
         unlock();
         ui_mutex.lock();
         ui_mutex.unlock();
@@ -158,6 +173,10 @@ struct BaseCtx
 #endif
     }
 
+    // Get the shared thread pool, sized from the "threads" setting (or the number of hardware threads if unset) the
+    // first time it is used
+    ThreadPool &thread_pool();
+
     IdString id(const std::string &s) const { return IdString(this, s); }
 
     IdString id(const char *s) const { return IdString(this, s); }
@@ -241,6 +260,14 @@ struct BaseCtx
     CellInfo *createCell(IdString name, IdString type);
     void copyBelPorts(IdString cell, BelId bel);
 
+    // Batched removal of cells and nets, for packers that remove many at once. Marked cells and nets stay in place, so
+    // pointers to them remain valid, until flushDeletions() removes them all in one pass over cells and nets. Unlike
+    // erasing one at a time, which moves the last entry into each hole, this keeps the remaining entries in their
+    // existing order whatever the batch size. Ports are not touched, so disconnect them first where needed.
+    void markCellForDeletion(IdString name) { cells_to_delete.insert(name); }
+    void markNetForDeletion(IdString name) { nets_to_delete.insert(name); }
+    void flushDeletions();
+
     // Workaround for lack of wrappable constructors
     DecalXY constructDecalXY(DecalId decal, float x, float y);
 
@@ -248,6 +275,19 @@ struct BaseCtx
     void attributesToArchInfo();
 };
 
+// Scoped lock_ui()/unlock_ui(), for use by UI code
+struct UiLockGuard
+{
+    explicit UiLockGuard(BaseCtx *ctx) : ctx(ctx) { ctx->lock_ui(); }
+    ~UiLockGuard() { ctx->unlock_ui(); }
+
+    UiLockGuard(const UiLockGuard &) = delete;
+    UiLockGuard &operator=(const UiLockGuard &) = delete;
+
+  private:
+    BaseCtx *ctx;
+};
+
 NEXTPNR_NAMESPACE_END
 
 #endif /* BASECTX_H */
@@ -0,0 +1,725 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+/*
+ * Binary checkpoints of the design state (netlist, attributes, placement and routing) so a flow can be resumed
+ * without the cost of writing and re-parsing JSON.
+ *
+ * Layout, all values in host byte order:
+ *   header: magic, format version, sizeof(delay_t), chip name
+ *   string table: the IdString database, other records refer to strings by their u32 index into this table
+ *   body: fixed-width records for the random number generator state, settings, regions, nets, cells, connectivity,
+ *         clusters, placement, routing, top-level ports, net aliases and hierarchy
+ *
+ * Containers are written in insertion order so that iteration order, which the placers and routers depend on, is the
+ * same after loading. Bels, wires and pips are stored by name, so a checkpoint is only valid for the same device.
+ */
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <chrono>
+#include <cstring>
+
+#include "context.h"
+#include "log.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace {
+
+const char checkpoint_magic[8] = {'N', 'P', 'N', 'R', 'C', 'K', 'P', 'T'};
+// Must be bumped whenever the layout changes
+const uint32_t checkpoint_version = 2;
+const uint32_t no_index = 0xFFFFFFFF;
+
+// hashlib containers iterate newest entry first, so reverse that to get the order to recreate them in
+template <typename T> auto insertion_order(const T &container)
+{
+    std::vector<const std::remove_cv_t<std::remove_reference_t<decltype(*container.begin())>> *> result;
+    result.reserve(container.size());
+    for (auto &entry : container)
+        result.push_back(&entry);
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+struct CheckpointWriter
+{
+    const Context *ctx;
+    std::string body;
+    // Keyed by pointer, as top-level port entries may still point to nets that packing removed
+    dict<const CellInfo *, uint32_t, hash_ptr_ops> cell_to_index;
+    dict<const NetInfo *, uint32_t, hash_ptr_ops> net_to_index;
+
+    explicit CheckpointWriter(const Context *ctx) : ctx(ctx) {};
+
+    template <typename T> void write_pod(const T &value)
+    {
+        body.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    void write_u32(uint32_t value) { write_pod(value); }
+    void write_str(const std::string &str)
+    {
+        write_u32(uint32_t(str.size()));
+        body.append(str);
+    }
+    void write_id(IdString id) { write_u32(uint32_t(id.index)); }
+    void write_id_list(const IdStringList &list)
+    {
+        write_u32(uint32_t(list.size()));
+        for (auto id : list)
+            write_id(id);
+    }
+    void write_bel(BelId bel) { write_id_list((bel == BelId()) ? IdStringList(size_t(0)) : ctx->getBelName(bel)); }
+    void write_wire(WireId wire)
+    {
+        write_id_list((wire == WireId()) ? IdStringList(size_t(0)) : ctx->getWireName(wire));
+    }
+    void write_pip(PipId pip) { write_id_list((pip == PipId()) ? IdStringList(size_t(0)) : ctx->getPipName(pip)); }
+    void write_property(const Property &prop)
+    {
+        write_pod(uint8_t(prop.is_string));
+        write_str(prop.str);
+        write_pod(prop.intval);
+    }
+    void write_properties(const dict<IdString, Property> &props)
+    {
+        write_u32(uint32_t(props.size()));
+        for (auto entry : insertion_order(props)) {
+            write_id(entry->first);
+            write_property(entry->second);
+        }
+    }
+    void write_id_map(const dict<IdString, IdString> &map)
+    {
+        write_u32(uint32_t(map.size()));
+        for (auto entry : insertion_order(map)) {
+            write_id(entry->first);
+            write_id(entry->second);
+        }
+    }
+    void write_delay_pair(const DelayPair &delay)
+    {
+        write_pod(delay.min_delay);
+        write_pod(delay.max_delay);
+    }
+    void write_net_ref(const NetInfo *net)
+    {
+        auto found = net_to_index.find(net);
+        write_u32((found == net_to_index.end()) ? no_index : found->second);
+    }
+    void write_port_ref(const PortRef &ref)
+    {
+        write_u32((ref.cell == nullptr) ? no_index : cell_to_index.at(ref.cell));
+        write_id(ref.port);
+    }
+
+    void write_regions()
+    {
+        write_u32(uint32_t(ctx->region.size()));
+        for (auto entry : insertion_order(ctx->region)) {
+            const Region *r = entry->second.get();
+            write_id(r->name);
+            write_pod(uint8_t(r->constr_bels));
+            write_pod(uint8_t(r->constr_wires));
+            write_pod(uint8_t(r->constr_pips));
+            write_u32(uint32_t(r->bels.size()));
+            for (auto bel : insertion_order(r->bels))
+                write_bel(*bel);
+            write_u32(uint32_t(r->wires.size()));
+            for (auto wire : insertion_order(r->wires))
+                write_wire(*wire);
+            write_u32(uint32_t(r->piplocs.size()));
+            for (auto loc : insertion_order(r->piplocs)) {
+                write_pod(int32_t(loc->x));
+                write_pod(int32_t(loc->y));
+                write_pod(int32_t(loc->z));
+            }
+        }
+    }
+
+    void write_netlist()
+    {
+        auto nets = insertion_order(ctx->nets);
+        auto cells = insertion_order(ctx->cells);
+        for (auto net : nets)
+            net_to_index.emplace(net->second.get(), uint32_t(net_to_index.size()));
+        for (auto cell : cells) {
+            if (cell->second->isPseudo())
+                log_error("Checkpoints don't support pseudo cells such as region plugs (found '%s').\n",
+                          ctx->nameOf(cell->first));
+            cell_to_index.emplace(cell->second.get(), uint32_t(cell_to_index.size()));
+        }
+
+        write_u32(uint32_t(nets.size()));
+        for (auto entry : nets) {
+            const NetInfo *ni = entry->second.get();
+            write_id(ni->name);
+            write_id(ni->hierpath);
+            write_id(ni->constant_value);
+            write_id((ni->region != nullptr) ? ni->region->name : IdString());
+            write_properties(ni->attrs);
+            write_u32(uint32_t(ni->aliases.size()));
+            for (auto alias : ni->aliases)
+                write_id(alias);
+            write_pod(uint8_t(ni->clkconstr != nullptr));
+            if (ni->clkconstr) {
+                write_delay_pair(ni->clkconstr->high);
+                write_delay_pair(ni->clkconstr->low);
+                write_delay_pair(ni->clkconstr->period);
+            }
+        }
+
+        write_u32(uint32_t(cells.size()));
+        for (auto entry : cells) {
+            const CellInfo *ci = entry->second.get();
+            write_id(ci->name);
+            write_id(ci->type);
+            write_id(ci->hierpath);
+            write_id((ci->region != nullptr) ? ci->region->name : IdString());
+            write_properties(ci->attrs);
+            write_properties(ci->params);
+            write_u32(uint32_t(ci->ports.size()));
+            for (auto port : insertion_order(ci->ports)) {
+                write_id(port->second.name);
+                write_pod(uint8_t(port->second.type));
+                write_net_ref(port->second.net);
+            }
+        }
+
+        // Connectivity, keeping the order of users
+        for (auto entry : nets) {
+            const NetInfo *ni = entry->second.get();
+            write_port_ref(ni->driver);
+            write_u32(uint32_t(ni->users.entries()));
+            for (auto &usr : ni->users)
+                write_port_ref(usr);
+        }
+
+        // Clusters, which are only set up by the packers so can't be recreated on load
+        for (auto entry : cells) {
+            const CellInfo *ci = entry->second.get();
+            write_id(ci->cluster);
+            write_u32(uint32_t(ci->constr_children.size()));
+            for (auto child : ci->constr_children)
+                write_u32(cell_to_index.at(child));
+            write_pod(int32_t(ci->constr_x));
+            write_pod(int32_t(ci->constr_y));
+            write_pod(int32_t(ci->constr_z));
+            write_pod(uint8_t(ci->constr_abs_z));
+        }
+    }
+
+    void write_implementation()
+    {
+        for (auto entry : insertion_order(ctx->cells)) {
+            const CellInfo *ci = entry->second.get();
+            write_bel(ci->bel);
+            write_pod(int32_t(ci->belStrength));
+        }
+        for (auto entry : insertion_order(ctx->nets)) {
+            const NetInfo *ni = entry->second.get();
+            write_u32(uint32_t(ni->wires.size()));
+            for (auto wire : insertion_order(ni->wires)) {
+                write_wire(wire->first);
+                write_pip(wire->second.pip);
+                write_pod(int32_t(wire->second.strength));
+            }
+        }
+    }
+
+    void write_top_level()
+    {
+        write_id(ctx->top_module);
+        write_u32(uint32_t(ctx->ports.size()));
+        for (auto entry : insertion_order(ctx->ports)) {
+            write_id(entry->first);
+            write_id(entry->second.name);
+            write_pod(uint8_t(entry->second.type));
+            write_net_ref(entry->second.net);
+        }
+        std::vector<std::pair<IdString, uint32_t>> port_cells;
+        for (auto entry : insertion_order(ctx->port_cells)) {
+            // Entries may be left pointing at port cells that packing removed, whose storage may since have been
+            // reused for another cell. So match them by name, as the frontend names port cells after their port, and
+            // never dereference the pointer itself.
+            auto found = ctx->cells.find(entry->first);
+            if (found == ctx->cells.end() || found->second.get() != entry->second)
+                continue;
+            port_cells.emplace_back(entry->first, cell_to_index.at(entry->second));
+        }
+        write_u32(uint32_t(port_cells.size()));
+        for (auto &entry : port_cells) {
+            write_id(entry.first);
+            write_u32(entry.second);
+        }
+        write_id_map(ctx->net_aliases);
+    }
+
+    void write_hierarchy()
+    {
+        write_u32(uint32_t(ctx->hierarchy.size()));
+        for (auto entry : insertion_order(ctx->hierarchy)) {
+            const HierarchicalCell &hc = entry->second;
+            write_id(entry->first);
+            write_id(hc.name);
+            write_id(hc.type);
+            write_id(hc.parent);
+            write_id(hc.fullpath);
+            write_id_map(hc.leaf_cells);
+            write_id_map(hc.nets);
+            write_id_map(hc.leaf_cells_by_gname);
+            write_id_map(hc.nets_by_gname);
+            write_u32(uint32_t(hc.ports.size()));
+            for (auto port : insertion_order(hc.ports)) {
+                write_id(port->first);
+                write_id(port->second.name);
+                write_pod(uint8_t(port->second.dir));
+                write_u32(uint32_t(port->second.nets.size()));
+                for (auto net : port->second.nets)
+                    write_id(net);
+                write_pod(int32_t(port->second.offset));
+                write_pod(uint8_t(port->second.upto));
+            }
+            write_id_map(hc.hier_cells);
+            write_properties(hc.attrs);
+        }
+    }
+
+    void write(std::ostream &out)
+    {
+        write_pod(ctx->rngstate);
+        write_properties(ctx->settings);
+        write_properties(ctx->attrs);
+        write_regions();
+        write_netlist();
+        write_implementation();
+        write_top_level();
+        write_hierarchy();
+
+        std::string header;
+        std::swap(header, body);
+        body.append(checkpoint_magic, sizeof(checkpoint_magic));
+        write_u32(checkpoint_version);
+        write_u32(uint32_t(sizeof(delay_t)));
+        write_str(ctx->getChipName());
+        // The whole IdString database is saved, rather than just the strings used, so that re-creating it in order
+        // gives the same indices when loading into a fresh context. This matters as IdString index order is used to
+        // break ties in a few places, and by the design checksum.
+        int id_count = ctx->idstring_db->size();
+        write_u32(uint32_t(id_count));
+        for (int i = 0; i < id_count; i++)
+            write_str(ctx->idstring_db->str(i));
+        std::swap(header, body);
+        out.write(header.data(), header.size());
+        out.write(body.data(), body.size());
+    }
+};
+
+struct CheckpointReader
+{
+    Context *ctx;
+    const std::string &filename;
+    const char *ptr, *end;
+    std::vector<IdString> ids;
+    std::vector<NetInfo *> nets;
+    std::vector<CellInfo *> cells;
+
+    CheckpointReader(Context *ctx, const std::string &filename, const char *data, size_t size)
+            : ctx(ctx), filename(filename), ptr(data), end(data + size) {};
+
+    NPNR_NORETURN void corrupt() { log_error("Checkpoint file '%s' is truncated or corrupt.\n", filename.c_str()); }
+
+    template <typename T> T read_pod()
+    {
+        if (size_t(end - ptr) < sizeof(T))
+            corrupt();
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+    uint32_t read_u32() { return read_pod<uint32_t>(); }
+    std::string read_str()
+    {
+        uint32_t size = read_u32();
+        if (size_t(end - ptr) < size)
+            corrupt();
+        std::string result(ptr, size);
+        ptr += size;
+        return result;
+    }
+    IdString read_id()
+    {
+        uint32_t index = read_u32();
+        if (index >= ids.size())
+            corrupt();
+        return ids[index];
+    }
+    IdStringList read_id_list()
+    {
+        uint32_t size = read_u32();
+        IdStringList result{size_t(size)};
+        for (uint32_t i = 0; i < size; i++)
+            result.ids[i] = read_id();
+        return result;
+    }
+    BelId read_bel()
+    {
+        IdStringList name = read_id_list();
+        if (name.size() == 0)
+            return BelId();
+        BelId bel = ctx->getBelByName(name);
+        if (bel == BelId())
+            log_error("Bel '%s' in checkpoint '%s' not found on this device.\n", name.str(ctx).c_str(),
+                      filename.c_str());
+        return bel;
+    }
+    WireId read_wire()
+    {
+        IdStringList name = read_id_list();
+        if (name.size() == 0)
+            return WireId();
+        WireId wire = ctx->getWireByName(name);
+        if (wire == WireId())
+            log_error("Wire '%s' in checkpoint '%s' not found on this device.\n", name.str(ctx).c_str(),
+                      filename.c_str());
+        return wire;
+    }
+    PipId read_pip()
+    {
+        IdStringList name = read_id_list();
+        if (name.size() == 0)
+            return PipId();
+        PipId pip = ctx->getPipByName(name);
+        if (pip == PipId())
+            log_error("Pip '%s' in checkpoint '%s' not found on this device.\n", name.str(ctx).c_str(),
+                      filename.c_str());
+        return pip;
+    }
+    Property read_property()
+    {
+        Property prop;
+        prop.is_string = read_pod<uint8_t>() != 0;
+        prop.str = read_str();
+        prop.intval = read_pod<int64_t>();
+        return prop;
+    }
+    void read_properties(dict<IdString, Property> &props, bool overwrite = true)
+    {
+        uint32_t count = read_u32();
+        for (uint32_t i = 0; i < count; i++) {
+            IdString key = read_id();
+            Property value = read_property();
+            if (overwrite || !props.count(key))
+                props[key] = value;
+        }
+    }
+    void read_id_map(dict<IdString, IdString> &map)
+    {
+        uint32_t count = read_u32();
+        for (uint32_t i = 0; i < count; i++) {
+            IdString key = read_id();
+            map[key] = read_id();
+        }
+    }
+    DelayPair read_delay_pair()
+    {
+        delay_t min_delay = read_pod<delay_t>();
+        delay_t max_delay = read_pod<delay_t>();
+        return DelayPair(min_delay, max_delay);
+    }
+    NetInfo *read_net_ref()
+    {
+        uint32_t index = read_u32();
+        if (index == no_index)
+            return nullptr;
+        if (index >= nets.size())
+            corrupt();
+        return nets[index];
+    }
+    PortRef read_port_ref()
+    {
+        PortRef ref;
+        uint32_t index = read_u32();
+        if (index != no_index) {
+            if (index >= cells.size())
+                corrupt();
+            ref.cell = cells[index];
+        }
+        ref.port = read_id();
+        return ref;
+    }
+    Region *read_region_ref()
+    {
+        IdString name = read_id();
+        if (name == IdString())
+            return nullptr;
+        auto found = ctx->region.find(name);
+        if (found == ctx->region.end())
+            corrupt();
+        return found->second.get();
+    }
+
+    void read_header()
+    {
+        char magic[sizeof(checkpoint_magic)];
+        for (auto &c : magic)
+            c = read_pod<char>();
+        if (std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0)
+            log_error("File '%s' is not a nextpnr checkpoint.\n", filename.c_str());
+        uint32_t version = read_u32();
+        if (version != checkpoint_version)
+            log_error("Checkpoint '%s' has format version %u, but this version of nextpnr only supports version %u.\n",
+                      filename.c_str(), version, checkpoint_version);
+        if (read_u32() != sizeof(delay_t))
+            log_error("Checkpoint '%s' was written for a different architecture.\n", filename.c_str());
+        std::string chip = read_str();
+        if (chip != ctx->getChipName())
+            log_error("Checkpoint '%s' was written for device '%s', but the current device is '%s'.\n",
+                      filename.c_str(), chip.c_str(), ctx->getChipName().c_str());
+        uint32_t id_count = read_u32();
+        ids.reserve(id_count);
+        for (uint32_t i = 0; i < id_count; i++)
+            ids.push_back(ctx->id(read_str()));
+    }
+
+    void read_regions()
+    {
+        uint32_t count = read_u32();
+        for (uint32_t i = 0; i < count; i++) {
+            auto r = std::make_unique<Region>();
+            r->name = read_id();
+            r->constr_bels = read_pod<uint8_t>() != 0;
+            r->constr_wires = read_pod<uint8_t>() != 0;
+            r->constr_pips = read_pod<uint8_t>() != 0;
+            uint32_t bel_count = read_u32();
+            for (uint32_t j = 0; j < bel_count; j++)
+                r->bels.insert(read_bel());
+            uint32_t wire_count = read_u32();
+            for (uint32_t j = 0; j < wire_count; j++)
+                r->wires.insert(read_wire());
+            uint32_t loc_count = read_u32();
+            for (uint32_t j = 0; j < loc_count; j++) {
+                Loc loc;
+                loc.x = read_pod<int32_t>();
+                loc.y = read_pod<int32_t>();
+                loc.z = read_pod<int32_t>();
+                r->piplocs.insert(loc);
+            }
+            IdString name = r->name;
+            ctx->region[name] = std::move(r);
+        }
+    }
+
+    void read_netlist()
+    {
+        uint32_t net_count = read_u32();
+        nets.reserve(net_count);
+        for (uint32_t i = 0; i < net_count; i++) {
+            IdString name = read_id();
+            auto net = std::make_unique<NetInfo>(name);
+            net->hierpath = read_id();
+            net->constant_value = read_id();
+            net->region = read_region_ref();
+            read_properties(net->attrs);
+            uint32_t alias_count = read_u32();
+            for (uint32_t j = 0; j < alias_count; j++)
+                net->aliases.push_back(read_id());
+            if (read_pod<uint8_t>()) {
+                net->clkconstr = std::make_unique<ClockConstraint>();
+                net->clkconstr->high = read_delay_pair();
+                net->clkconstr->low = read_delay_pair();
+                net->clkconstr->period = read_delay_pair();
+            }
+            nets.push_back(net.get());
+            ctx->nets[name] = std::move(net);
+        }
+
+        uint32_t cell_count = read_u32();
+        cells.reserve(cell_count);
+        for (uint32_t i = 0; i < cell_count; i++) {
+            IdString name = read_id();
+            IdString type = read_id();
+            auto cell = std::make_unique<CellInfo>(ctx, name, type);
+            cell->hierpath = read_id();
+            cell->region = read_region_ref();
+            read_properties(cell->attrs);
+            read_properties(cell->params);
+            uint32_t port_count = read_u32();
+            for (uint32_t j = 0; j < port_count; j++) {
+                PortInfo port;
+                port.name = read_id();
+                port.type = PortType(read_pod<uint8_t>());
+                port.net = read_net_ref();
+                cell->ports[port.name] = port;
+            }
+            cells.push_back(cell.get());
+            ctx->cells[name] = std::move(cell);
+        }
+
+        for (auto ni : nets) {
+            ni->driver = read_port_ref();
+            uint32_t user_count = read_u32();
+            for (uint32_t j = 0; j < user_count; j++) {
+                PortRef usr = read_port_ref();
+                if (usr.cell == nullptr || !usr.cell->ports.count(usr.port))
+                    corrupt();
+                usr.cell->ports.at(usr.port).user_idx = ni->users.add(usr);
+            }
+        }
+
+        for (auto ci : cells) {
+            ci->cluster = read_id();
+            uint32_t child_count = read_u32();
+            for (uint32_t j = 0; j < child_count; j++) {
+                uint32_t index = read_u32();
+                if (index >= cells.size())
+                    corrupt();
+                ci->constr_children.push_back(cells[index]);
+            }
+            ci->constr_x = read_pod<int32_t>();
+            ci->constr_y = read_pod<int32_t>();
+            ci->constr_z = read_pod<int32_t>();
+            ci->constr_abs_z = read_pod<uint8_t>() != 0;
+        }
+    }
+
+    void read_implementation()
+    {
+        for (auto ci : cells) {
+            BelId bel = read_bel();
+            PlaceStrength strength = PlaceStrength(read_pod<int32_t>());
+            if (bel != BelId())
+                ctx->bindBel(bel, ci, strength);
+        }
+        for (auto ni : nets) {
+            uint32_t wire_count = read_u32();
+            for (uint32_t j = 0; j < wire_count; j++) {
+                WireId wire = read_wire();
+                PipId pip = read_pip();
+                PlaceStrength strength = PlaceStrength(read_pod<int32_t>());
+                if (pip == PipId())
+                    ctx->bindWire(wire, ni, strength);
+                else
+                    ctx->bindPip(pip, ni, strength);
+            }
+        }
+    }
+
+    void read_top_level()
+    {
+        ctx->top_module = read_id();
+        uint32_t port_count = read_u32();
+        for (uint32_t i = 0; i < port_count; i++) {
+            IdString key = read_id();
+            PortInfo port;
+            port.name = read_id();
+            port.type = PortType(read_pod<uint8_t>());
+            port.net = read_net_ref();
+            ctx->ports[key] = port;
+        }
+        uint32_t port_cell_count = read_u32();
+        for (uint32_t i = 0; i < port_cell_count; i++) {
+            IdString key = read_id();
+            uint32_t index = read_u32();
+            if (index >= cells.size())
+                corrupt();
+            ctx->port_cells[key] = cells[index];
+        }
+        read_id_map(ctx->net_aliases);
+    }
+
+    void read_hierarchy()
+    {
+        uint32_t count = read_u32();
+        for (uint32_t i = 0; i < count; i++) {
+            IdString key = read_id();
+            HierarchicalCell &hc = ctx->hierarchy[key];
+            hc.name = read_id();
+            hc.type = read_id();
+            hc.parent = read_id();
+            hc.fullpath = read_id();
+            read_id_map(hc.leaf_cells);
+            read_id_map(hc.nets);
+            read_id_map(hc.leaf_cells_by_gname);
+            read_id_map(hc.nets_by_gname);
+            uint32_t port_count = read_u32();
+            for (uint32_t j = 0; j < port_count; j++) {
+                IdString port_key = read_id();
+                HierarchicalPort &port = hc.ports[port_key];
+                port.name = read_id();
+                port.dir = PortType(read_pod<uint8_t>());
+                uint32_t net_count = read_u32();
+                for (uint32_t k = 0; k < net_count; k++)
+                    port.nets.push_back(read_id());
+                port.offset = read_pod<int32_t>();
+                port.upto = read_pod<uint8_t>() != 0;
+            }
+            read_id_map(hc.hier_cells);
+            read_properties(hc.attrs);
+        }
+    }
+
+    void read()
+    {
+        read_header();
+        ctx->rngstate = read_pod<uint64_t>();
+        // Settings given on the command line take precedence over those saved in the checkpoint
+        read_properties(ctx->settings, /*overwrite=*/false);
+        read_properties(ctx->attrs);
+        read_regions();
+        read_netlist();
+        // Arches derive per-cell state here that bindBel relies on, such as the iCE40 carry enable
+        ctx->assignArchInfo();
+        read_implementation();
+        read_top_level();
+        read_hierarchy();
+        if (ptr != end)
+            corrupt();
+    }
+};
+
+} // namespace
+
+void Context::writeCheckpoint(std::ostream &out) const
+{
+    CheckpointWriter writer(this);
+    writer.write(out);
+}
+
+void Context::readCheckpoint(const std::string &filename)
+{
+    if (!cells.empty() || !nets.empty())
+        log_error("Checkpoint '%s' must be loaded into an empty design.\n", filename.c_str());
+    auto start = std::chrono::high_resolution_clock::now();
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(filename);
+    } catch (std::exception &e) {
+        log_error("Failed to open checkpoint file '%s': %s.\n", filename.c_str(), e.what());
+    }
+    CheckpointReader reader(this, filename, file.data(), file.size());
+    reader.read();
+    design_loaded = true;
+    auto end = std::chrono::high_resolution_clock::now();
+    log_info("Loaded checkpoint '%s' with %d cells and %d nets in %.02fs.\n", filename.c_str(), int(cells.size()),
+             int(nets.size()), std::chrono::duration<float>(end - start).count());
+}
+
+NEXTPNR_NAMESPACE_END
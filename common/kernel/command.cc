@@ -342,6 +342,11 @@ po::options_description CommandHandler::getGeneralOptions()
 #endif
     general.add_options()("json", po::value<std::string>(), "JSON design file to ingest");
     general.add_options()("write", po::value<std::string>(), "JSON design file to write");
+    general.add_options()("load-checkpoint", po::value<std::string>(),
+                          "binary checkpoint to load instead of a JSON design; use --no-pack/--no-place to resume "
+                          "from the stage it was written after");
+    general.add_options()("write-checkpoint", po::value<std::string>(),
+                          "binary checkpoint file to write after the last stage run");
     general.add_options()("top", po::value<std::string>(), "name of top module");
     general.add_options()("seed", po::value<uint64_t>(), "seed value for random number generator");
     general.add_options()("randomize-seed,r", "randomize seed value for random number generator");
@@ -371,6 +376,8 @@ po::options_description CommandHandler::getGeneralOptions()
 
     general.add_options()("version,V", "show version");
     general.add_options()("test", "check architecture database integrity");
+    general.add_options()("test-sample", po::value<double>(),
+                          "with --test, check only a random fraction (0, 1] of the entities (default: 1)");
     general.add_options()("freq", po::value<double>(), "set target frequency for design in MHz");
     general.add_options()("timing-allow-fail", "allow timing to fail in design");
     general.add_options()("no-tmdriv", "disable timing-driven placement");
@@ -391,11 +398,19 @@ po::options_description CommandHandler::getGeneralOptions()
                           "N, default: 8, 0 for no timeout)");
 
     general.add_options()("placer-heap-no-ctrl-set", "disable control set awareness in placer heap");
+    general.add_options()("placer-heap-solver", po::value<std::string>(),
+                          "placer heap equation solver; available: cg, ldlt (default: cg)");
+    general.add_options()("placer-heap-preconditioner", po::value<std::string>(),
+                          "placer heap conjugate gradient preconditioner; available: jacobi, ichol, none "
+                          "(default: jacobi)");
 
     general.add_options()("static-dump-density", "write density csv files during placer-static flow");
 
 #if !defined(NPNR_DISABLE_THREADS)
     general.add_options()("parallel-refine", "use new experimental parallelised engine for placement refinement");
+    general.add_options()("placer1-parallel-refine",
+                          "hand the low-temperature part of the SA placer's anneal to the parallelised refinement "
+                          "engine");
 #endif
 
     general.add_options()("router2-heatmap", po::value<std::string>(),
@@ -406,6 +421,9 @@ po::options_description CommandHandler::getGeneralOptions()
                           "enable experimental timing-driven ripup in router (deprecated; use --tmg-ripup instead)");
 
     general.add_options()("router2-alt-weights", "use alternate router2 weights");
+    general.add_options()("router2-lookahead", "use a precomputed per-wire-type lookahead for router2 A* estimates");
+    general.add_options()("router2-lookahead-cache", po::value<std::string>(),
+                          "file to load the router2 lookahead from, or save it to (implies --router2-lookahead)");
 
     general.add_options()("report", po::value<std::string>(),
                           "write timing and utilization report in JSON format to file");
@@ -456,6 +474,14 @@ void CommandHandler::setupContext(Context *ctx)
         ctx->settings[ctx->id("threads")] = vm["threads"].as<int>();
     }
 
+    if (vm.count("test-sample")) {
+        double sample = vm["test-sample"].as<double>();
+        if (!(sample > 0 && sample <= 1))
+            log_error("--test-sample must be in the range (0, 1], got %g\n", sample);
+        // Full precision, as std::to_string would round small fractions down to zero
+        ctx->settings[ctx->id("archcheck/sample")] = stringf("%.9g", sample);
+    }
+
     if (vm.count("randomize-seed")) {
         std::random_device randDev{};
         std::uniform_int_distribution<uint64_t> distrib{1};
@@ -529,9 +555,18 @@ void CommandHandler::setupContext(Context *ctx)
     if (vm.count("placer-heap-no-ctrl-set"))
         ctx->settings[ctx->id("placerHeap/noCtrlSet")] = true;
 
+    if (vm.count("placer-heap-solver"))
+        ctx->settings[ctx->id("placerHeap/solver")] = vm["placer-heap-solver"].as<std::string>();
+
+    if (vm.count("placer-heap-preconditioner"))
+        ctx->settings[ctx->id("placerHeap/preconditioner")] = vm["placer-heap-preconditioner"].as<std::string>();
+
     if (vm.count("parallel-refine"))
         ctx->settings[ctx->id("placerHeap/parallelRefine")] = true;
 
+    if (vm.count("placer1-parallel-refine"))
+        ctx->settings[ctx->id("placer1/parallelRefine")] = true;
+
     if (vm.count("router2-heatmap"))
         ctx->settings[ctx->id("router2/heatmap")] = vm["router2-heatmap"].as<std::string>();
     if (vm.count("tmg-ripup") || vm.count("router2-tmg-ripup"))
@@ -539,6 +574,10 @@ void CommandHandler::setupContext(Context *ctx)
 
     if (vm.count("router2-alt-weights"))
         ctx->settings[ctx->id("router2/alt-weights")] = true;
+    if (vm.count("router2-lookahead") || vm.count("router2-lookahead-cache"))
+        ctx->settings[ctx->id("router2/lookahead")] = true;
+    if (vm.count("router2-lookahead-cache"))
+        ctx->settings[ctx->id("router2/lookaheadCache")] = vm["router2-lookahead-cache"].as<std::string>();
 
     if (vm.count("static-dump-density"))
         ctx->settings[ctx->id("static/dump_density")] = true;
@@ -595,8 +634,7 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         try {
             if (vm.count("json")) {
                 std::string filename = vm["json"].as<std::string>();
-                auto f = open_ifstream_and_log_error(filename, "JSON file");
-                if (!parse_json(f, filename, w.getContext()))
+                if (!parse_json(filename, w.getContext()))
                     log_error("Loading design failed.\n");
 
                 if (vm.count("sdc")) {
@@ -621,9 +659,7 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
 #endif
     if (vm.count("json")) {
         std::string filename = vm["json"].as<std::string>();
-        auto f = open_ifstream_and_log_error(filename, "'--json' file");
-
-        if (!parse_json(f, filename, ctx.get()))
+        if (!parse_json(filename, ctx.get()))
             log_error("Loading design failed.\n");
 
         if (vm.count("sdc")) {
@@ -635,6 +671,21 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
         customAfterLoad(ctx.get());
     }
 
+    if (vm.count("load-checkpoint")) {
+        // Constraints were already applied to the design saved in the checkpoint, so customAfterLoad isn't run
+        uint64_t rngstate = ctx->rngstate;
+        ctx->readCheckpoint(vm["load-checkpoint"].as<std::string>());
+        // The checkpoint restores the random state it was saved with, unless a seed was explicitly given
+        if (vm.count("seed") || vm.count("randomize-seed"))
+            ctx->rngstate = rngstate;
+
+        if (vm.count("sdc")) {
+            std::string sdc_filename = vm["sdc"].as<std::string>();
+            auto sdc_stream = open_ifstream_and_log_error(sdc_filename, "SDC file");
+            ctx->read_sdc(sdc_stream);
+        }
+    }
+
 #ifndef NO_PYTHON
     init_python(argv[0]);
     python_export_global("ctx", *ctx);
@@ -666,6 +717,8 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
                 ctx->debug = true;
             if (!ctx->place() && !ctx->force)
                 log_error("Placing design failed.\n");
+            if (ctx->verbose || ctx->debug)
+                ctx->legality_stats.log_summary();
             ctx->debug = saved_debug;
             ctx->check();
             if (vm.count("placed-svg"))
@@ -685,6 +738,9 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
                 ctx->writeSVG(vm["routed-svg"].as<std::string>(), "scale=500");
         }
 
+        if (ctx->verbose && ctx->thread_pool_ptr)
+            ctx->thread_pool_ptr->log_stats();
+
         customBitstream(ctx.get());
     }
 
@@ -695,6 +751,14 @@ int CommandHandler::executeMain(std::unique_ptr<Context> ctx)
             log_error("Saving design failed.\n");
     }
 
+    if (vm.count("write-checkpoint")) {
+        std::string filename = vm["write-checkpoint"].as<std::string>();
+        std::ofstream f(filename, std::ios::binary);
+        if (!f)
+            log_error("Failed to open checkpoint file '%s' for writing.\n", filename.c_str());
+        ctx->writeCheckpoint(f);
+    }
+
     if (vm.count("sdf")) {
         std::string filename = vm["sdf"].as<std::string>();
         auto f = open_ofstream_and_log_error(filename, "SDF file");
@@ -760,11 +824,8 @@ void CommandHandler::load_json(Context *ctx, std::string filename)
 {
     setupContext(ctx);
     setupArchContext(ctx);
-    {
-        auto f = open_ifstream_and_log_error(filename, "JSON file");
-        if (!parse_json(f, filename, ctx))
-            log_error("Loading design failed.\n");
-    }
+    if (!parse_json(filename, ctx))
+        log_error("Loading design failed.\n");
 }
 
 void CommandHandler::clear() { vm.clear(); }
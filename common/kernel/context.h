@@ -91,6 +91,12 @@ struct Context : Arch, DeterministicRNG
 
     // --------------------------------------------------------------
 
+    // provided by checkpoint.cc
+    void writeCheckpoint(std::ostream &out) const;
+    void readCheckpoint(const std::string &filename);
+
+    // --------------------------------------------------------------
+
     // provided by report.cc
     void writeJsonReport(std::ostream &out) const;
 
@@ -106,7 +112,7 @@ struct Context : Arch, DeterministicRNG
     uint32_t checksum() const;
 
     void check() const;
-    void archcheck() const;
+    void archcheck();
 
     template <typename T> T setting(const char *name, T defaultValue)
     {
@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -22,6 +23,11 @@
 #include "nextpnr_assertions.h"
 #include "nextpnr_namespaces.h"
 
+#if defined(NPNR_HASHLIB_OPEN_ADDRESSING) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define NPNR_HASHLIB_SSE2
+#endif
+
 NEXTPNR_NAMESPACE_BEGIN
 
 const int hashtable_size_trigger = 2;
@@ -205,6 +211,194 @@ inline int hashtable_size(int min_size)
     throw std::length_error("hash table exceeded maximum size.");
 }
 
+#ifdef NPNR_HASHLIB_OPEN_ADDRESSING
+// Open addressing index used by dict and pool in place of the chained hashtable when built with
+// HASHLIB_OPEN_ADDRESSING. Like the chained version it only stores indices into the entries vector, so iteration
+// order (and hence everything downstream of it) is unaffected by the choice.
+//
+// Slots are probed in groups of 16. Each slot has a control byte, which is either empty, deleted or 7 bits of the
+// hash of the key in it; so a whole group can be searched for candidates with one vector compare, and keys are only
+// compared on a (1 in 128 false positive) match. The control bytes of a group are stored next to its slots so that a
+// probe usually touches a single cache line of the index.
+class open_hash_index
+{
+    static constexpr int group_size = 16;
+    static constexpr int8_t ctrl_empty = -128;
+    static constexpr int8_t ctrl_deleted = -2;
+
+    struct group_t
+    {
+        alignas(16) int8_t ctrl[group_size];
+        int slots[group_size];
+    };
+
+    std::vector<group_t> groups;
+    // number of full and deleted slots
+    int used = 0;
+
+    static inline int lowest_bit(uint32_t mask)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            i++;
+        }
+        return i;
+#endif
+    }
+
+    // Bitmask of the slots in a group whose control byte equals c
+    static inline uint32_t match(const group_t &g, int8_t c)
+    {
+#ifdef NPNR_HASHLIB_SSE2
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(g.ctrl));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+#else
+        uint32_t mask = 0;
+        for (int i = 0; i < group_size; i++)
+            if (g.ctrl[i] == c)
+                mask |= (1U << i);
+        return mask;
+#endif
+    }
+
+    // Bitmask of the slots in a group that are empty or deleted
+    static inline uint32_t match_free(const group_t &g)
+    {
+#ifdef NPNR_HASHLIB_SSE2
+        return _mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(g.ctrl)));
+#else
+        uint32_t mask = 0;
+        for (int i = 0; i < group_size; i++)
+            if (g.ctrl[i] < 0)
+                mask |= (1U << i);
+        return mask;
+#endif
+    }
+
+    // The hash_ops hashes are often just an index, so mix them before taking the group from the upper bits and the
+    // control byte from the lower ones
+    static inline uint64_t mix(unsigned int hash) { return uint64_t(hash) * 0x9E3779B97F4A7C15ULL; }
+    inline int first_group(uint64_t m) const { return int(m >> 32) & (int(groups.size()) - 1); }
+    static inline int8_t tag(uint64_t m) { return int8_t((m >> 25) & 0x7F); }
+    // Triangular probing visits every group when their count is a power of two
+    inline int next_group(int group, int &step) const { return (group + (++step)) & (int(groups.size()) - 1); }
+
+    // The group and slot holding an index that is known to be present
+    inline std::pair<int, int> find_slot(unsigned int hash, int index) const
+    {
+        uint64_t m = mix(hash);
+        int8_t t = tag(m);
+        for (int group = first_group(m), step = 0;; group = next_group(group, step)) {
+            const group_t &g = groups[group];
+            for (uint32_t mask = match(g, t); mask != 0; mask &= (mask - 1)) {
+                int slot = lowest_bit(mask);
+                if (g.slots[slot] == index)
+                    return std::make_pair(group, slot);
+            }
+            NPNR_ASSERT(match(g, ctrl_empty) == 0);
+        }
+    }
+
+  public:
+    bool empty() const { return groups.empty(); }
+
+    void clear()
+    {
+        groups.clear();
+        used = 0;
+    }
+
+    void swap(open_hash_index &other)
+    {
+        groups.swap(other.groups);
+        std::swap(used, other.used);
+    }
+
+    // Drop everything and allocate enough slots to insert n indices without growing
+    void reset(size_t n)
+    {
+        clear();
+        if (n == 0)
+            return;
+        size_t count = 1;
+        while (count * group_size * 7 / 8 < n)
+            count *= 2;
+        if (count * group_size > size_t(std::numeric_limits<int>::max()))
+            throw std::length_error("hash table exceeded maximum size.");
+        group_t init;
+        std::fill(init.ctrl, init.ctrl + group_size, ctrl_empty);
+        std::fill(init.slots, init.slots + group_size, -1);
+        groups.resize(count, init);
+    }
+
+    // Index of the entry for which is_match returns true, or -1 if there is none
+    template <typename F> inline int find(unsigned int hash, F is_match) const
+    {
+        if (groups.empty())
+            return -1;
+        uint64_t m = mix(hash);
+        int8_t t = tag(m);
+        for (int group = first_group(m), step = 0;; group = next_group(group, step)) {
+            const group_t &g = groups[group];
+            for (uint32_t mask = match(g, t); mask != 0; mask &= (mask - 1)) {
+                int index = g.slots[lowest_bit(mask)];
+                if (is_match(index))
+                    return index;
+            }
+            if (match(g, ctrl_empty) != 0)
+                return -1;
+        }
+    }
+
+    // Add an index, which must not already be present. Returns false without doing anything if the table is too full,
+    // in which case the owner must reset it to a larger size and insert everything again
+    inline bool insert(unsigned int hash, int index)
+    {
+        if (groups.empty() || size_t(used + 1) * 8 > groups.size() * group_size * 7)
+            return false;
+        uint64_t m = mix(hash);
+        for (int group = first_group(m), step = 0;; group = next_group(group, step)) {
+            group_t &g = groups[group];
+            uint32_t mask = match_free(g);
+            if (mask != 0) {
+                int slot = lowest_bit(mask);
+                if (g.ctrl[slot] == ctrl_empty)
+                    used++;
+                g.ctrl[slot] = tag(m);
+                g.slots[slot] = index;
+                return true;
+            }
+        }
+    }
+
+    inline void erase(unsigned int hash, int index)
+    {
+        auto loc = find_slot(hash, index);
+        group_t &g = groups[loc.first];
+        // A group that still has an empty slot has never been full, so no probe sequence can have continued past it
+        // and the slot can be made empty rather than leaving a tombstone
+        if (match(g, ctrl_empty) != 0) {
+            g.ctrl[loc.second] = ctrl_empty;
+            used--;
+        } else {
+            g.ctrl[loc.second] = ctrl_deleted;
+        }
+        g.slots[loc.second] = -1;
+    }
+
+    // Update the index of an entry that has been moved within the entries vector
+    inline void replace(unsigned int hash, int old_index, int new_index)
+    {
+        auto loc = find_slot(hash, old_index);
+        groups[loc.first].slots[loc.second] = new_index;
+    }
+};
+#endif
+
 template <typename K, typename T, typename OPS = hash_ops<K>> class dict;
 template <typename K, int offset = 0, typename OPS = hash_ops<K>> class idict;
 template <typename K, typename OPS = hash_ops<K>> class pool;
@@ -212,6 +406,98 @@ template <typename K, typename OPS = hash_ops<K>> class mfp;
 
 template <typename K, typename T, typename OPS> class dict
 {
+#ifdef NPNR_HASHLIB_OPEN_ADDRESSING
+    struct entry_t
+    {
+        std::pair<K, T> udata;
+
+        entry_t() {}
+        entry_t(const std::pair<K, T> &udata) : udata(udata) {}
+        entry_t(std::pair<K, T> &&udata) : udata(std::move(udata)) {}
+        bool operator<(const entry_t &other) const { return udata.first < other.udata.first; }
+    };
+
+    open_hash_index hashtable;
+    std::vector<entry_t> entries;
+    OPS ops;
+
+#ifdef NDEBUG
+    static inline void do_assert(bool) {}
+#else
+    static inline void do_assert(bool cond) { NPNR_ASSERT(cond); }
+#endif
+
+    int do_hash(const K &key) const { return ops.hash(key); }
+
+    void do_rehash()
+    {
+        hashtable.reset(std::max(entries.capacity(), 2 * entries.size()));
+        for (int i = 0; i < int(entries.size()); i++)
+            hashtable.insert(do_hash(entries[i].udata.first), i);
+    }
+
+    // Rebuild the index after entries have been removed wholesale
+    void do_reindex()
+    {
+        if (entries.empty())
+            hashtable.clear();
+        else
+            do_rehash();
+    }
+
+    int do_erase(int index, int hash)
+    {
+        do_assert(index < int(entries.size()));
+        if (hashtable.empty() || index < 0)
+            return 0;
+
+        hashtable.erase(hash, index);
+
+        int back_idx = entries.size() - 1;
+        if (index != back_idx) {
+            hashtable.replace(do_hash(entries[back_idx].udata.first), back_idx, index);
+            entries[index] = std::move(entries[back_idx]);
+        }
+
+        entries.pop_back();
+
+        if (entries.empty())
+            hashtable.clear();
+
+        return 1;
+    }
+
+    int do_lookup(const K &key, int &hash) const
+    {
+        return hashtable.find(hash, [&](int index) { return ops.cmp(entries[index].udata.first, key); });
+    }
+
+    int do_index_back(int hash)
+    {
+        int index = entries.size() - 1;
+        if (!hashtable.insert(hash, index))
+            do_rehash();
+        return index;
+    }
+
+    int do_insert(const K &key, int &hash)
+    {
+        entries.emplace_back(std::pair<K, T>(key, T()));
+        return do_index_back(hash);
+    }
+
+    int do_insert(const std::pair<K, T> &value, int &hash)
+    {
+        entries.emplace_back(value);
+        return do_index_back(hash);
+    }
+
+    int do_insert(std::pair<K, T> &&rvalue, int &hash)
+    {
+        entries.emplace_back(std::forward<std::pair<K, T>>(rvalue));
+        return do_index_back(hash);
+    }
+#else
     struct entry_t
     {
         std::pair<K, T> udata;
@@ -254,6 +540,18 @@ template <typename K, typename T, typename OPS> class dict
         }
     }
 
+    // Rebuild the index after entries have been removed wholesale, when their next links are stale
+    void do_reindex()
+    {
+        if (entries.empty()) {
+            hashtable.clear();
+            return;
+        }
+        for (auto &e : entries)
+            e.next = -1;
+        do_rehash();
+    }
+
     int do_erase(int index, int hash)
     {
         do_assert(index < int(entries.size()));
@@ -361,6 +659,7 @@ template <typename K, typename T, typename OPS> class dict
         }
         return entries.size() - 1;
     }
+#endif
 
   public:
     using key_type = K;
@@ -633,6 +932,20 @@ template <typename K, typename T, typename OPS> class dict
         do_rehash();
     }
 
+    // Erase every entry for which pred(entry) holds, rebuilding the hashtable once rather than updating it for each
+    // erased entry. Unlike erase(), which moves the last entry into the hole, the remaining entries keep their order.
+    template <typename Pred> int erase_if(Pred pred)
+    {
+        auto new_end =
+                std::remove_if(entries.begin(), entries.end(), [&](const entry_t &e) { return pred(e.udata); });
+        int count = int(entries.end() - new_end);
+        if (count > 0) {
+            entries.erase(new_end, entries.end());
+            do_reindex();
+        }
+        return count;
+    }
+
     void swap(dict &other)
     {
         hashtable.swap(other.hashtable);
@@ -686,6 +999,82 @@ template <typename K, typename OPS> class pool
     template <typename, int, typename> friend class idict;
 
   protected:
+#ifdef NPNR_HASHLIB_OPEN_ADDRESSING
+    struct entry_t
+    {
+        K udata;
+
+        entry_t() {}
+        entry_t(const K &udata) : udata(udata) {}
+        entry_t(K &&udata) : udata(std::move(udata)) {}
+    };
+
+    open_hash_index hashtable;
+    std::vector<entry_t> entries;
+    OPS ops;
+
+#ifdef NDEBUG
+    static inline void do_assert(bool) {}
+#else
+    static inline void do_assert(bool cond) { NPNR_ASSERT(cond); }
+#endif
+
+    int do_hash(const K &key) const { return ops.hash(key); }
+
+    void do_rehash()
+    {
+        hashtable.reset(std::max(entries.capacity(), 2 * entries.size()));
+        for (int i = 0; i < int(entries.size()); i++)
+            hashtable.insert(do_hash(entries[i].udata), i);
+    }
+
+    int do_erase(int index, int hash)
+    {
+        do_assert(index < int(entries.size()));
+        if (hashtable.empty() || index < 0)
+            return 0;
+
+        hashtable.erase(hash, index);
+
+        int back_idx = entries.size() - 1;
+        if (index != back_idx) {
+            hashtable.replace(do_hash(entries[back_idx].udata), back_idx, index);
+            entries[index] = std::move(entries[back_idx]);
+        }
+
+        entries.pop_back();
+
+        if (entries.empty())
+            hashtable.clear();
+
+        return 1;
+    }
+
+    int do_lookup(const K &key, int &hash) const
+    {
+        return hashtable.find(hash, [&](int index) { return ops.cmp(entries[index].udata, key); });
+    }
+
+    int do_index_back(int hash)
+    {
+        int index = entries.size() - 1;
+        if (!hashtable.insert(hash, index))
+            do_rehash();
+        return index;
+    }
+
+    int do_insert(const K &value, int &hash)
+    {
+        entries.emplace_back(value);
+        return do_index_back(hash);
+    }
+
+    int do_insert(K &&rvalue, int &hash)
+    {
+        entries.emplace_back(std::forward<K>(rvalue));
+        return do_index_back(hash);
+    }
+#else
     struct entry_t
     {
         K udata;
@@ -816,6 +1205,7 @@ template <typename K, typename OPS> class pool
         }
         return entries.size() - 1;
     }
+#endif
 
   public:
     class const_iterator
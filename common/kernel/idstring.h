@@ -22,6 +22,7 @@
 #define IDSTRING_H
 
 #include <string>
+#include <string_view>
 #include "nextpnr_namespaces.h"
 
 NEXTPNR_NAMESPACE_BEGIN
@@ -39,11 +40,10 @@ struct IdString
     constexpr IdString() : index(0) {}
     explicit constexpr IdString(int index) : index(index) {}
 
-    void set(const BaseCtx *ctx, const std::string &s);
+    // Safe to call from any thread
+    void set(const BaseCtx *ctx, std::string_view s);
 
-    IdString(const BaseCtx *ctx, const std::string &s) { set(ctx, s); }
-
-    IdString(const BaseCtx *ctx, const char *s) { set(ctx, s); }
+    IdString(const BaseCtx *ctx, std::string_view s) { set(ctx, s); }
 
     const std::string &str(const BaseCtx *ctx) const;
 
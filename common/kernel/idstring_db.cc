@@ -0,0 +1,139 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "idstring_db.h"
+
+#include <functional>
+
+NEXTPNR_NAMESPACE_BEGIN
+
+IdStringDB::IdStringDB()
+{
+    for (auto &chunk : chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+}
+
+IdStringDB::~IdStringDB()
+{
+    for (auto &chunk : chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+uint64_t IdStringDB::hash(std::string_view s)
+{
+    // Spread the bits of std::hash, which might only be 32 bits wide, over all 64; bits 26-31 then select the shard and
+    // the upper 32 bits are the tag stored in the table, which also gives the position in it
+    return uint64_t(std::hash<std::string_view>()(s)) * 0x9E3779B97F4A7C15ULL;
+}
+
+int IdStringDB::find(const Table *table, std::string_view s, uint64_t h) const
+{
+    if (table == nullptr)
+        return -1;
+    uint32_t tag = uint32_t(h >> 32);
+    for (uint32_t pos = tag & table->mask;; pos = (pos + 1) & table->mask) {
+        uint64_t slot = table->slots[pos].load(std::memory_order_acquire);
+        if (slot == 0)
+            return -1;
+        if (uint32_t(slot >> 32) == tag) {
+            int idx = int(uint32_t(slot)) - 1;
+            if (str(idx) == s)
+                return idx;
+        }
+    }
+}
+
+int IdStringDB::insert(Shard &shard, std::string_view s, uint64_t h, int idx)
+{
+    // Make the string reachable through its index first, so that it is never found in the table before that
+    shard.strings.emplace_back(s);
+    int chunk = chunk_of(idx);
+    NPNR_ASSERT(chunk < max_chunks);
+    const std::string **entries = chunks[chunk].load(std::memory_order_acquire);
+    if (entries == nullptr) {
+        std::lock_guard<std::mutex> lock(chunk_mutex);
+        entries = chunks[chunk].load(std::memory_order_relaxed);
+        if (entries == nullptr) {
+            entries = new const std::string *[size_t(1) << (chunk + first_chunk_bits)]();
+            chunks[chunk].store(entries, std::memory_order_release);
+        }
+    }
+    entries[idx - chunk_start(chunk)] = &shard.strings.back();
+
+    auto place = [](Table *table, uint64_t slot) {
+        uint32_t pos = uint32_t(slot >> 32) & table->mask;
+        while (table->slots[pos].load(std::memory_order_relaxed) != 0)
+            pos = (pos + 1) & table->mask;
+        table->slots[pos].store(slot, std::memory_order_release);
+    };
+
+    // Keep the table at most half full
+    Table *table = shard.table.load(std::memory_order_relaxed);
+    if (table == nullptr || 2 * (shard.count + 1) > int(table->mask) + 1) {
+        auto new_table = std::make_unique<Table>(table ? 2 * (int(table->mask) + 1) : 64);
+        if (table != nullptr) {
+            for (uint32_t i = 0; i <= table->mask; i++) {
+                uint64_t slot = table->slots[i].load(std::memory_order_relaxed);
+                if (slot != 0)
+                    place(new_table.get(), slot);
+            }
+        }
+        table = new_table.get();
+        shard.tables.push_back(std::move(new_table));
+        shard.table.store(table, std::memory_order_release);
+    }
+    place(table, (h & 0xFFFFFFFF00000000ULL) | uint64_t(uint32_t(idx + 1)));
+    shard.count++;
+    return idx;
+}
+
+int IdStringDB::get(std::string_view s)
+{
+    uint64_t h = hash(s);
+    Shard &shard = shards[(h >> 26) & ((1 << shard_bits) - 1)];
+    int idx = find(shard.table.load(std::memory_order_acquire), s, h);
+    if (idx >= 0)
+        return idx;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Another thread may have added it, or replaced the table, in the meantime
+    idx = find(shard.table.load(std::memory_order_relaxed), s, h);
+    if (idx >= 0)
+        return idx;
+    return insert(shard, s, h, next_idx.fetch_add(1, std::memory_order_acq_rel));
+}
+
+void IdStringDB::add(std::string_view s, int idx)
+{
+    uint64_t h = hash(s);
+    Shard &shard = shards[(h >> 26) & ((1 << shard_bits) - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    NPNR_ASSERT(find(shard.table.load(std::memory_order_relaxed), s, h) < 0);
+    int next = next_idx.fetch_add(1, std::memory_order_acq_rel);
+    NPNR_ASSERT(next == idx);
+    insert(shard, s, h, idx);
+}
+
+bool IdStringDB::contains(std::string_view s) const
+{
+    uint64_t h = hash(s);
+    const Shard &shard = shards[(h >> 26) & ((1 << shard_bits) - 1)];
+    return find(shard.table.load(std::memory_order_acquire), s, h) >= 0;
+}
+
+NEXTPNR_NAMESPACE_END
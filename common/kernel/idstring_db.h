@@ -0,0 +1,123 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef IDSTRING_DB_H
+#define IDSTRING_DB_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nextpnr_assertions.h"
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// The string interning table behind IdString, mapping strings to consecutive indices and back.
+//
+// All operations are safe to call from any number of threads at once. Looking up a string that is already present
+// and getting the string of an index take no locks; adding a new string locks one of several shards, chosen by hash.
+// Strings are never removed and never move in memory.
+//
+// Indices are handed out in order of insertion, so they are only deterministic if strings are added from one thread at
+// a time, as IdString index order is used to break ties in some places.
+class IdStringDB
+{
+  public:
+    IdStringDB();
+    ~IdStringDB();
+
+    IdStringDB(const IdStringDB &) = delete;
+    IdStringDB &operator=(const IdStringDB &) = delete;
+
+    // Index of s, adding it if it isn't present yet
+    int get(std::string_view s);
+    // Add s, which must not be present yet, as the given index, which must be the next one to be allocated
+    void add(std::string_view s, int idx);
+    bool contains(std::string_view s) const;
+
+    const std::string &str(int idx) const
+    {
+        NPNR_ASSERT(idx >= 0 && idx < size());
+        int chunk = chunk_of(idx);
+        return *chunks[chunk].load(std::memory_order_acquire)[idx - chunk_start(chunk)];
+    }
+
+    // Number of indices allocated. While strings are being added by another thread, this may include indices whose
+    // string is not yet available
+    int size() const { return next_idx.load(std::memory_order_acquire); }
+
+  private:
+    // Open-addressing hash table, whose slots hold the upper 32 bits of the hash and one more than the index; zero
+    // marks an empty slot. A full table is replaced by one twice the size, but kept alive for lock-free readers that
+    // may still be probing it
+    struct Table
+    {
+        explicit Table(int size) : mask(size - 1), slots(new std::atomic<uint64_t>[size]())
+        {
+            for (int i = 0; i < size; i++)
+                slots[i].store(0, std::memory_order_relaxed);
+        }
+        uint32_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    };
+
+    struct alignas(64) Shard
+    {
+        std::atomic<Table *> table{nullptr};
+        std::mutex mutex;
+        int count = 0;
+        std::vector<std::unique_ptr<Table>> tables;
+        std::deque<std::string> strings;
+    };
+
+    static constexpr int shard_bits = 6;
+    std::array<Shard, 1 << shard_bits> shards;
+
+    // Index to string, in chunks that double in size so that they never need to be moved
+    static constexpr int first_chunk_bits = 12;
+    static constexpr int max_chunks = 20;
+    std::array<std::atomic<const std::string **>, max_chunks> chunks;
+    std::mutex chunk_mutex;
+    std::atomic<int> next_idx{0};
+
+    static int chunk_of(int idx)
+    {
+        unsigned q = (unsigned(idx) >> first_chunk_bits) + 1;
+        int chunk = 0;
+        while (q >>= 1)
+            chunk++;
+        return chunk;
+    }
+    static int chunk_start(int chunk) { return ((1 << chunk) - 1) << first_chunk_bits; }
+
+    static uint64_t hash(std::string_view s);
+    int find(const Table *table, std::string_view s, uint64_t h) const;
+    int insert(Shard &shard, std::string_view s, uint64_t h, int idx);
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif /* IDSTRING_DB_H */
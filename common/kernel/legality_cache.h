@@ -0,0 +1,95 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef LEGALITY_CACHE_H
+#define LEGALITY_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "log.h"
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// Number of cached legality queries, and how many of them didn't need rechecking. isBelLocationValid may be called
+// from several placer threads at once, so these are atomic.
+struct LegalityCacheStats
+{
+    std::atomic<uint64_t> queries{0}, hits{0};
+
+    void count(bool hit)
+    {
+        queries.fetch_add(1, std::memory_order_relaxed);
+        if (hit)
+            hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        queries = 0;
+        hits = 0;
+    }
+
+    void log_summary() const
+    {
+        uint64_t q = queries.load(), h = hits.load();
+        if (q == 0)
+            return;
+        log_info("Legality cache: %llu queries, %llu hits (%.1f%%)\n", (unsigned long long)q, (unsigned long long)h,
+                 (100.0 * h) / q);
+    }
+};
+
+// Result of a legality check over a group of bels (a slice, tile, LAB...). The owner must call invalidate() whenever
+// a bel in the group is bound or unbound, and the check is then rerun by the next get().
+struct CachedLegality
+{
+    bool valid = true, dirty = true;
+
+    void invalidate() { dirty = true; }
+
+    template <typename Tcheck> bool get(LegalityCacheStats &stats, Tcheck check)
+    {
+        stats.count(!dirty);
+        if (dirty) {
+            valid = check();
+            dirty = false;
+        }
+        return valid;
+    }
+};
+
+// CachedLegality for every tile of an arch that has no per-tile state of its own to keep it in
+struct TileLegalityCache
+{
+    std::vector<CachedLegality> tiles;
+
+    void init(int num_tiles) { tiles.assign(num_tiles, CachedLegality()); }
+    void invalidate(int tile) { tiles.at(tile).invalidate(); }
+    template <typename Tcheck> bool get(int tile, LegalityCacheStats &stats, Tcheck check)
+    {
+        return tiles.at(tile).get(stats, check);
+    }
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif
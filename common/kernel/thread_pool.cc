@@ -0,0 +1,219 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "log.h"
+#include "nextpnr_assertions.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace {
+// The pool and queue the current thread is a worker of, if any
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local int current_queue = -1;
+} // namespace
+
+struct ThreadPool::Batch
+{
+    std::function<void(int)> func;
+    std::atomic<int> remaining{0};
+    std::atomic<int64_t> busy_ns{0};
+    // Protects error, and the final decrement of remaining
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(int threads)
+{
+#ifdef NPNR_DISABLE_THREADS
+    threads = 1;
+#endif
+    threads = std::max(1, threads);
+    for (int i = 0; i < threads; i++)
+        queues.emplace_back(std::make_unique<Queue>());
+    for (int i = 0; i < threads - 1; i++)
+        workers.emplace_back([this, i]() { worker(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(sleep_mutex);
+        shutdown = true;
+    }
+    sleep_cv.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+bool ThreadPool::pop_task(int queue_idx, Task &task)
+{
+    int n = int(queues.size());
+    // Own queue first, newest task first as it is most likely to be hot in cache
+    {
+        auto &q = *queues.at(queue_idx);
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (!q.tasks.empty()) {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+            --queued;
+            return true;
+        }
+    }
+    // Then steal the oldest task from another queue
+    for (int i = 1; i < n; i++) {
+        auto &q = *queues.at((queue_idx + i) % n);
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (!q.tasks.empty()) {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            --queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(const Task &task)
+{
+    Batch *batch = task.batch;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        batch->func(task.index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lk(batch->mutex);
+        if (!batch->error)
+            batch->error = std::current_exception();
+    }
+    auto end = std::chrono::steady_clock::now();
+    batch->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    // The batch may be destroyed as soon as the submitting thread sees remaining reach zero and can take the mutex
+    std::lock_guard<std::mutex> lk(batch->mutex);
+    if (--batch->remaining == 0)
+        batch->done_cv.notify_all();
+}
+
+void ThreadPool::worker(int idx)
+{
+    current_pool = this;
+    current_queue = idx;
+    while (true) {
+        Task task;
+        if (pop_task(idx, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(sleep_mutex);
+        sleep_cv.wait(lk, [this]() { return shutdown || queued.load() > 0; });
+        if (shutdown)
+            return;
+    }
+}
+
+void ThreadPool::run(const char *name, int N, std::function<void(int)> func)
+{
+    if (N <= 0)
+        return;
+    auto start = std::chrono::steady_clock::now();
+    Batch batch;
+    batch.func = std::move(func);
+    batch.remaining = N;
+    if (workers.empty() || N == 1) {
+        // Nothing to gain from queueing
+        for (int i = 0; i < N; i++)
+            execute(Task{&batch, i});
+    } else {
+        // Hand out contiguous blocks of tasks to each queue, idle threads will steal to balance any remaining work
+        int n = int(queues.size());
+        for (int q = 0; q < n; q++) {
+            int begin = int((int64_t(N) * q) / n), end = int((int64_t(N) * (q + 1)) / n);
+            if (begin == end)
+                continue;
+            auto &queue = *queues.at(q);
+            std::lock_guard<std::mutex> lk(queue.mutex);
+            for (int i = begin; i < end; i++)
+                queue.tasks.push_back(Task{&batch, i});
+            queued += (end - begin);
+        }
+        {
+            std::lock_guard<std::mutex> lk(sleep_mutex);
+        }
+        sleep_cv.notify_all();
+        // Help out until everything from this batch has at least started
+        int own_queue = (current_pool == this) ? current_queue : n - 1;
+        while (batch.remaining.load() > 0) {
+            Task task;
+            if (pop_task(own_queue, task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(batch.mutex);
+            batch.done_cv.wait(lk, [&]() { return batch.remaining.load() == 0; });
+        }
+    }
+    // Make sure the last task has released the batch
+    std::lock_guard<std::mutex> lk(batch.mutex);
+    auto end = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> stats_lk(stats_mutex);
+        auto &s = stats[name];
+        s.calls++;
+        s.tasks += N;
+        s.wall += std::chrono::duration<double>(end - start).count();
+        s.busy += batch.busy_ns.load() / 1e9;
+    }
+    if (batch.error)
+        std::rethrow_exception(batch.error);
+}
+
+void ThreadPool::run_ranges(const char *name, int N, int min_chunk, std::function<void(int, int)> func)
+{
+    if (N <= 0)
+        return;
+    // A few chunks per thread, so that uneven chunks can be balanced by stealing
+    int chunks = std::min((N + std::max(1, min_chunk) - 1) / std::max(1, min_chunk), 4 * size());
+    run(name, chunks, [&](int c) {
+        func(int((int64_t(N) * c) / chunks), int((int64_t(N) * (c + 1)) / chunks));
+    });
+}
+
+std::map<std::string, ThreadPool::Stats> ThreadPool::get_stats() const
+{
+    std::lock_guard<std::mutex> lk(stats_mutex);
+    return stats;
+}
+
+void ThreadPool::log_stats() const
+{
+    auto all_stats = get_stats();
+    if (all_stats.empty())
+        return;
+    log_info("Thread pool usage (%d threads):\n", size());
+    log_info("    %-24s %8s %10s %10s %10s\n", "task", "calls", "tasks", "wall (s)", "busy (s)");
+    for (auto &s : all_stats)
+        log_info("    %-24s %8d %10lld %10.02f %10.02f\n", s.first.c_str(), s.second.calls,
+                 (long long)s.second.tasks, s.second.wall, s.second.busy);
+}
+
+NEXTPNR_NAMESPACE_END
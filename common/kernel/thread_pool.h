@@ -0,0 +1,107 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// A persistent pool of worker threads, shared by all the passes of a Context so that short parallel sections don't pay
+// for thread creation every time.
+//
+// Each worker has its own task queue; idle workers steal from the other queues. The thread calling run() executes tasks
+// too while it waits, so run() may be nested inside a task without deadlocking.
+//
+// Tasks must not take the Context lock, which is usually held by the thread that started them.
+class ThreadPool
+{
+  public:
+    // threads is the total parallelism, including the calling thread; so threads-1 workers are started
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return int(workers.size()) + 1; }
+
+    // Call func(i) for i in [0, N), returning once all calls have completed. The first exception thrown by a task is
+    // rethrown here, once all other tasks have finished.
+    void run(const char *name, int N, std::function<void(int)> func);
+    // Split [0, N) into contiguous ranges of at least min_chunk items, and call func(begin, end) for each
+    void run_ranges(const char *name, int N, int min_chunk, std::function<void(int, int)> func);
+
+    // Per-name counters; busy is the sum of task run times, wall the time spent in run() itself
+    struct Stats
+    {
+        int calls = 0;
+        int64_t tasks = 0;
+        double wall = 0, busy = 0;
+    };
+    std::map<std::string, Stats> get_stats() const;
+    void log_stats() const;
+
+  private:
+    struct Batch;
+    struct Task
+    {
+        Batch *batch;
+        int index;
+    };
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    // One queue per worker, plus one at the end for tasks submitted from outside the pool
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    // Number of tasks sitting in any queue, used to put workers to sleep
+    std::atomic<int> queued{0};
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool shutdown = false;
+
+    mutable std::mutex stats_mutex;
+    std::map<std::string, Stats> stats;
+
+    bool pop_task(int queue_idx, Task &task);
+    void execute(const Task &task);
+    void worker(int idx);
+};
+
+NEXTPNR_NAMESPACE_END
+
+#endif
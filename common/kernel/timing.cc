@@ -35,10 +35,14 @@ TimingAnalyser::TimingAnalyser(Context *ctx) : ctx(ctx)
     domain_to_id.emplace(key, 0);
     domains.emplace_back(key);
     async_clock_id = 0;
+    check_incremental = bool_or_default(ctx->settings, ctx->id("timing/checkIncremental"), false);
+    threads = std::max(1, int_or_default(ctx->settings, ctx->id("threads"), 1));
 };
 
 void TimingAnalyser::setup(bool update_net_timings, bool update_histogram, bool update_crit_paths)
 {
+    have_times = false;
+    changed_route_delays.clear();
     init_ports();
     get_cell_delays();
     topo_sort();
@@ -50,13 +54,16 @@ void TimingAnalyser::setup(bool update_net_timings, bool update_histogram, bool
 void TimingAnalyser::run(bool update_route_delays, bool update_net_timings, bool update_histogram,
                          bool update_crit_paths)
 {
-    reset_times();
     if (update_route_delays)
         get_route_delays();
-    walk_forward();
-    walk_backward();
-    compute_slack();
-    compute_criticality();
+    if (incremental && have_times && !have_loops) {
+        run_incremental();
+        if (check_incremental)
+            verify_incremental();
+    } else {
+        run_full();
+    }
+    changed_route_delays.clear();
 
     // Ensure we clear all timing results if any of them has been marked as
     // as to be updated. This is done so we ensure it's not possible to have
@@ -78,15 +85,45 @@ void TimingAnalyser::run(bool update_route_delays, bool update_net_timings, bool
     }
 }
 
+void TimingAnalyser::run_full()
+{
+    reset_times();
+    walk_forward();
+    walk_backward();
+    compute_slack();
+    compute_criticality();
+    have_times = true;
+}
+
 void TimingAnalyser::init_ports()
 {
+    ports.clear();
+    port_to_id.clear();
+    net_users.clear();
     // Per cell port structures
     for (auto &cell : ctx->cells) {
         CellInfo *ci = cell.second.get();
         for (auto &port : ci->ports) {
-            auto &data = ports[CellPortKey(ci->name, port.first)];
+            CellPortKey key(ci->name, port.first);
+            port_to_id.emplace(key, port_id_t(ports.size()));
+            auto &data = ports.emplace_back();
             data.type = port.second.type;
-            data.cell_port = CellPortKey(ci->name, port.first);
+            data.cell_port = key;
+        }
+    }
+    // Connectivity across nets, so the walks don't need to go via the netlist
+    for (auto &pd : ports) {
+        const NetInfo *net = port_info(pd.cell_port).net;
+        if (net == nullptr)
+            continue;
+        if (pd.type == PORT_IN) {
+            if (net->driver.cell != nullptr)
+                pd.net_driver = port_to_id.at(CellPortKey(net->driver));
+        } else if (pd.type == PORT_OUT) {
+            pd.users_begin = int(net_users.size());
+            for (auto &usr : net->users)
+                net_users.push_back(port_to_id.at(CellPortKey(usr)));
+            pd.users_end = int(net_users.size());
         }
     }
 }
@@ -95,12 +132,11 @@ void TimingAnalyser::get_cell_delays()
 {
     auto async_clk_key = domains.at(async_clock_id);
 
-    for (auto &port : ports) {
-        CellInfo *ci = cell_info(port.first);
-        auto &pi = port_info(port.first);
-        auto &pd = port.second;
+    for (auto &pd : ports) {
+        CellInfo *ci = cell_info(pd.cell_port);
+        auto &pi = port_info(pd.cell_port);
 
-        IdString name = port.first.port;
+        IdString name = pd.cell_port.port;
         // Ignore dangling ports altogether for timing purposes
         if (!pi.net)
             continue;
@@ -163,6 +199,9 @@ void TimingAnalyser::get_cell_delays()
                     pd.cell_arcs.emplace_back(CellArc::COMBINATIONAL, other_port.first, delay);
             }
         }
+        for (auto &arc : pd.cell_arcs)
+            if (arc.other_port != IdString())
+                arc.other_id = port_to_id.at(CellPortKey(pd.cell_port.cell, arc.other_port));
     }
 }
 
@@ -176,34 +215,40 @@ void TimingAnalyser::get_route_delays()
         for (auto &usr : ni->users) {
             if (usr.cell->bel == BelId())
                 continue;
-            ports.at(CellPortKey(usr)).route_delay = DelayPair(ctx->getNetinfoRouteDelay(ni, usr));
+            set_route_delay(port_to_id.at(CellPortKey(usr)), DelayPair(ctx->getNetinfoRouteDelay(ni, usr)));
         }
     }
 }
 
-void TimingAnalyser::set_route_delay(CellPortKey port, DelayPair value) { ports.at(port).route_delay = value; }
+void TimingAnalyser::set_route_delay(CellPortKey port, DelayPair value) { set_route_delay(port_to_id.at(port), value); }
+
+void TimingAnalyser::set_route_delay(port_id_t port, DelayPair value)
+{
+    auto &pd = ports.at(port);
+    if (incremental && have_times &&
+        (pd.route_delay.min_delay != value.min_delay || pd.route_delay.max_delay != value.max_delay))
+        changed_route_delays.push_back(port);
+    pd.route_delay = value;
+}
 
 void TimingAnalyser::topo_sort()
 {
-    TopoSort<CellPortKey> topo;
-    for (auto &port : ports) {
-        auto &pd = port.second;
+    TopoSort<port_id_t> topo;
+    for (port_id_t port = 0; port < port_id_t(ports.size()); port++) {
+        auto &pd = ports.at(port);
         // All ports are nodes
-        topo.node(port.first);
+        topo.node(port);
         if (pd.type == PORT_IN) {
             // inputs: combinational arcs through the cell are edges
             for (auto &arc : pd.cell_arcs) {
                 if (arc.type != CellArc::COMBINATIONAL)
                     continue;
-                topo.edge(port.first, CellPortKey(port.first.cell, arc.other_port));
+                topo.edge(port, arc.other_id);
             }
         } else if (pd.type == PORT_OUT) {
             // output: routing arcs are edges
-            const NetInfo *pn = port_info(port.first).net;
-            if (pn != nullptr) {
-                for (auto &usr : pn->users)
-                    topo.edge(port.first, CellPortKey(usr));
-            }
+            for (int i = pd.users_begin; i < pd.users_end; i++)
+                topo.edge(port, net_users.at(i));
         }
     }
 
@@ -214,9 +259,10 @@ void TimingAnalyser::topo_sort()
         int i = 0;
         for (auto &loop : topo.loops) {
             log_info("    loop %d:\n", ++i);
-            for (auto &port : loop) {
-                log_info("        %s.%s (%s)\n", ctx->nameOf(port.cell), ctx->nameOf(port.port),
-                         ctx->nameOf(port_info(port).net));
+            for (auto port : loop) {
+                auto &key = ports.at(port).cell_port;
+                log_info("        %s.%s (%s)\n", ctx->nameOf(key.cell), ctx->nameOf(key.port),
+                         ctx->nameOf(port_info(key).net));
             }
         }
 
@@ -227,6 +273,93 @@ void TimingAnalyser::topo_sort()
     }
     have_loops = !no_loops;
     std::swap(topological_order, topo.sorted);
+    levelise();
+    for (int i = 0; i < int(topological_order.size()); i++)
+        ports.at(topological_order.at(i)).topo_index = i;
+    if (!level_starts.empty()) {
+        // The gather walks visit fan-in and fan-out in topological order
+        auto by_topo = [&](const std::pair<port_id_t, int> &a, const std::pair<port_id_t, int> &b) {
+            return ports.at(a.first).topo_index < ports.at(b.first).topo_index;
+        };
+        for (port_id_t p = 0; p < port_id_t(ports.size()); p++) {
+            std::sort(comb_fanin.begin() + comb_fanin_start.at(p), comb_fanin.begin() + comb_fanin_start.at(p + 1),
+                      by_topo);
+            std::sort(comb_fanout.begin() + comb_fanout_start.at(p), comb_fanout.begin() + comb_fanout_start.at(p + 1),
+                      by_topo);
+            auto &pd = ports.at(p);
+            std::sort(net_users.begin() + pd.users_begin, net_users.begin() + pd.users_end,
+                      [&](port_id_t a, port_id_t b) { return ports.at(a).topo_index < ports.at(b).topo_index; });
+        }
+    }
+}
+
+void TimingAnalyser::levelise()
+{
+    level_starts.clear();
+    // Levels are only meaningful without loops
+    if (have_loops)
+        return;
+    int n = int(ports.size());
+    // Combinational arcs are stored at the input end in the forward direction, and at the output end backwards
+    comb_fanin_start.assign(n + 1, 0);
+    comb_fanout_start.assign(n + 1, 0);
+    for (auto &pd : ports) {
+        for (auto &arc : pd.cell_arcs) {
+            if (arc.type != CellArc::COMBINATIONAL)
+                continue;
+            if (pd.type == PORT_IN)
+                ++comb_fanin_start.at(arc.other_id + 1);
+            else if (pd.type == PORT_OUT)
+                ++comb_fanout_start.at(arc.other_id + 1);
+        }
+        // The walks only follow nets from outputs to inputs
+        if (pd.type == PORT_IN && pd.net_driver != -1 && ports.at(pd.net_driver).type != PORT_OUT)
+            return;
+        for (int i = pd.users_begin; i < pd.users_end; i++)
+            if (ports.at(net_users.at(i)).type != PORT_IN)
+                return;
+    }
+    for (int i = 0; i < n; i++) {
+        comb_fanin_start.at(i + 1) += comb_fanin_start.at(i);
+        comb_fanout_start.at(i + 1) += comb_fanout_start.at(i);
+    }
+    comb_fanin.resize(comb_fanin_start.back());
+    comb_fanout.resize(comb_fanout_start.back());
+    std::vector<int> fanin_cursor(comb_fanin_start.begin(), comb_fanin_start.end() - 1);
+    std::vector<int> fanout_cursor(comb_fanout_start.begin(), comb_fanout_start.end() - 1);
+    for (port_id_t p = 0; p < n; p++) {
+        auto &pd = ports.at(p);
+        for (int i = 0; i < int(pd.cell_arcs.size()); i++) {
+            auto &arc = pd.cell_arcs.at(i);
+            if (arc.type != CellArc::COMBINATIONAL)
+                continue;
+            if (pd.type == PORT_IN)
+                comb_fanin.at(fanin_cursor.at(arc.other_id)++) = std::make_pair(p, i);
+            else if (pd.type == PORT_OUT)
+                comb_fanout.at(fanout_cursor.at(arc.other_id)++) = std::make_pair(p, i);
+        }
+    }
+    // A port's level is one more than the highest level in its fan-in
+    std::vector<int> level(n, 0);
+    int max_level = 0;
+    for (auto p : topological_order) {
+        auto &pd = ports.at(p);
+        int l = 0;
+        if (pd.type == PORT_IN && pd.net_driver != -1)
+            l = level.at(pd.net_driver) + 1;
+        for (int i = comb_fanin_start.at(p); i < comb_fanin_start.at(p + 1); i++)
+            l = std::max(l, level.at(comb_fanin.at(i).first) + 1);
+        level.at(p) = l;
+        max_level = std::max(max_level, l);
+    }
+    // Reorder the topological order by level, which is still a valid topological order
+    std::stable_sort(topological_order.begin(), topological_order.end(),
+                     [&](port_id_t a, port_id_t b) { return level.at(a) < level.at(b); });
+    level_starts.assign(max_level + 2, 0);
+    for (int i = 0; i < n; i++)
+        ++level_starts.at(level.at(i) + 1);
+    for (int i = 0; i <= max_level; i++)
+        level_starts.at(i + 1) += level_starts.at(i);
 }
 
 void TimingAnalyser::setup_port_domains()
@@ -235,52 +368,58 @@ void TimingAnalyser::setup_port_domains()
         d.startpoints.clear();
         d.endpoints.clear();
     }
+    for (auto &pd : ports) {
+        pd.startpoints.clear();
+        pd.endpoints.clear();
+    }
+    // Domains are collected per port first, then flattened once the set for every port is known
+    std::vector<std::vector<domain_id_t>> arrival_doms(ports.size()), required_doms(ports.size());
     bool first_iter = true;
     do {
         // Go forward through the topological order (domains from the PoV of arrival time)
         updated_domains = false;
         for (auto port : topological_order) {
             auto &pd = ports.at(port);
-            auto &pi = port_info(port);
-            if (pi.type == PORT_OUT) {
+            if (pd.type == PORT_OUT) {
                 if (first_iter) {
                     for (auto &fanin : pd.cell_arcs) {
                         domain_id_t dom;
                         // registered outputs are startpoints
                         if (fanin.type == CellArc::CLK_TO_Q)
-                            dom = domain_id(port.cell, fanin.other_port, fanin.edge);
+                            dom = domain_id(pd.cell_port.cell, fanin.other_port, fanin.edge);
                         else if (fanin.type == CellArc::STARTPOINT)
                             dom = async_clock_id;
                         else
                             continue;
                         // create per-domain data
-                        pd.arrival[dom];
+                        auto &port_doms = arrival_doms.at(port);
+                        if (std::find(port_doms.begin(), port_doms.end(), dom) == port_doms.end())
+                            port_doms.push_back(dom);
                         domains.at(dom).startpoints.emplace_back(port, fanin.other_port);
+                        pd.startpoints.emplace_back(dom, fanin.other_port);
                     }
                 }
                 // copy domains across routing
-                if (pi.net != nullptr)
-                    for (auto &usr : pi.net->users)
-                        copy_domains(port, CellPortKey(usr), false);
+                for (int i = pd.users_begin; i < pd.users_end; i++)
+                    copy_domains(arrival_doms.at(port), arrival_doms.at(net_users.at(i)));
             } else {
                 // copy domains from input to output
                 for (auto &fanout : pd.cell_arcs) {
                     if (fanout.type != CellArc::COMBINATIONAL)
                         continue;
-                    copy_domains(port, CellPortKey(port.cell, fanout.other_port), false);
+                    copy_domains(arrival_doms.at(port), arrival_doms.at(fanout.other_id));
                 }
             }
         }
         // Go backward through the topological order (domains from the PoV of required time)
         for (auto port : reversed_range(topological_order)) {
             auto &pd = ports.at(port);
-            auto &pi = port_info(port);
-            if (pi.type == PORT_OUT) {
+            if (pd.type == PORT_OUT) {
                 // copy domains from output to input
                 for (auto &fanin : pd.cell_arcs) {
                     if (fanin.type != CellArc::COMBINATIONAL)
                         continue;
-                    copy_domains(port, CellPortKey(port.cell, fanin.other_port), true);
+                    copy_domains(required_doms.at(port), required_doms.at(fanin.other_id));
                 }
             } else {
                 if (first_iter) {
@@ -288,33 +427,49 @@ void TimingAnalyser::setup_port_domains()
                         domain_id_t dom;
                         // registered inputs are endpoints
                         if (fanout.type == CellArc::SETUP)
-                            dom = domain_id(port.cell, fanout.other_port, fanout.edge);
+                            dom = domain_id(pd.cell_port.cell, fanout.other_port, fanout.edge);
                         else if (fanout.type == CellArc::ENDPOINT)
                             dom = async_clock_id;
                         else
                             continue;
                         // create per-domain data
-                        pd.required[dom];
+                        auto &port_doms = required_doms.at(port);
+                        if (std::find(port_doms.begin(), port_doms.end(), dom) == port_doms.end())
+                            port_doms.push_back(dom);
                         domains.at(dom).endpoints.emplace_back(port, fanout.other_port);
+                        pd.endpoints.emplace_back(dom, fanout.other_port);
                     }
                 }
                 // copy port to driver
-                if (pi.net != nullptr && pi.net->driver.cell != nullptr)
-                    copy_domains(port, CellPortKey(pi.net->driver), true);
+                if (pd.net_driver != -1)
+                    copy_domains(required_doms.at(port), required_doms.at(pd.net_driver));
             }
         }
-        // Iterate over ports and find domain pairs
-        for (auto port : topological_order) {
-            auto &pd = ports.at(port);
-            for (auto &arr : pd.arrival)
-                for (auto &req : pd.required) {
-                    pd.domain_pairs[domain_pair_id(arr.first, req.first)];
-                }
-        }
         first_iter = false;
         // If there are loops, repeat the process until a fixed point is reached, as there might be unusual ways to
         // visit points, which would result in a missing domain key and therefore crash later on
     } while (have_loops && updated_domains);
+    // Flatten the per-port domains, and find domain pairs
+    arrival_domain.clear();
+    required_domain.clear();
+    pair_domain.clear();
+    for (port_id_t port = 0; port < port_id_t(ports.size()); port++) {
+        auto &pd = ports.at(port);
+        pd.arrival_begin = int(arrival_domain.size());
+        arrival_domain.insert(arrival_domain.end(), arrival_doms.at(port).begin(), arrival_doms.at(port).end());
+        pd.arrival_end = int(arrival_domain.size());
+        pd.required_begin = int(required_domain.size());
+        required_domain.insert(required_domain.end(), required_doms.at(port).begin(), required_doms.at(port).end());
+        pd.required_end = int(required_domain.size());
+        pd.pair_begin = int(pair_domain.size());
+        for (auto arr : arrival_doms.at(port))
+            for (auto req : required_doms.at(port))
+                pair_domain.push_back(domain_pair_id(arr, req));
+        pd.pair_end = int(pair_domain.size());
+    }
+    arrival_time.assign(arrival_domain.size(), ArrivReqTime());
+    required_time.assign(required_domain.size(), ArrivReqTime());
+    pair_data.assign(pair_domain.size(), PortDomainPairData());
     for (auto &dp : domain_pairs) {
         auto &launch_data = domains.at(dp.key.launch);
         auto &capture_data = domains.at(dp.key.capture);
@@ -504,33 +659,35 @@ void TimingAnalyser::reset_times()
 {
     static const auto init_delay =
             DelayPair(std::numeric_limits<delay_t>::max(), std::numeric_limits<delay_t>::lowest());
-    for (auto &port : ports) {
-        auto do_reset = [&](dict<domain_id_t, ArrivReqTime> &times) {
-            for (auto &t : times) {
-                t.second.value = init_delay;
-                t.second.path_length = 0;
-                t.second.bwd_min = CellPortKey();
-                t.second.bwd_max = CellPortKey();
-            }
-        };
-        do_reset(port.second.arrival);
-        do_reset(port.second.required);
-        for (auto &dp : port.second.domain_pairs) {
-            dp.second.setup_slack = std::numeric_limits<delay_t>::max();
-            dp.second.hold_slack = std::numeric_limits<delay_t>::max();
-            dp.second.max_path_length = 0;
-            dp.second.criticality = 0;
+    auto do_reset = [&](std::vector<ArrivReqTime> &times) {
+        for (auto &t : times) {
+            t.value = init_delay;
+            t.path_length = 0;
+            t.bwd_min = -1;
+            t.bwd_max = -1;
         }
-        port.second.worst_crit = 0;
-        port.second.worst_setup_slack = std::numeric_limits<delay_t>::max();
-        port.second.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    };
+    do_reset(arrival_time);
+    do_reset(required_time);
+    for (auto &dp : pair_data) {
+        dp.setup_slack = std::numeric_limits<delay_t>::max();
+        dp.hold_slack = std::numeric_limits<delay_t>::max();
+        dp.max_path_length = 0;
+        dp.criticality = 0;
+    }
+    for (auto &pd : ports) {
+        pd.worst_crit = 0;
+        pd.worst_setup_slack = std::numeric_limits<delay_t>::max();
+        pd.worst_hold_slack = std::numeric_limits<delay_t>::max();
     }
 }
 
-void TimingAnalyser::set_arrival_time(CellPortKey target, domain_id_t domain, DelayPair arrival, int path_length,
-                                      CellPortKey prev)
+void TimingAnalyser::set_arrival_time(port_id_t target, domain_id_t domain, DelayPair arrival, int path_length,
+                                      port_id_t prev)
 {
-    auto &arr = ports.at(target).arrival.at(domain);
+    int idx = find_arrival(target, domain);
+    NPNR_ASSERT(idx != -1);
+    auto &arr = arrival_time.at(idx);
     if (arrival.max_delay > arr.value.max_delay) {
         arr.value.max_delay = arrival.max_delay;
         arr.bwd_max = prev;
@@ -542,10 +699,12 @@ void TimingAnalyser::set_arrival_time(CellPortKey target, domain_id_t domain, De
     arr.path_length = std::max(arr.path_length, path_length);
 }
 
-void TimingAnalyser::set_required_time(CellPortKey target, domain_id_t domain, DelayPair required, int path_length,
-                                       CellPortKey prev)
+void TimingAnalyser::set_required_time(port_id_t target, domain_id_t domain, DelayPair required, int path_length,
+                                       port_id_t prev)
 {
-    auto &req = ports.at(target).required.at(domain);
+    int idx = find_required(target, domain);
+    NPNR_ASSERT(idx != -1);
+    auto &req = required_time.at(idx);
     if (required.min_delay < req.value.min_delay) {
         req.value.min_delay = required.min_delay;
         req.bwd_min = prev;
@@ -557,114 +716,424 @@ void TimingAnalyser::set_required_time(CellPortKey target, domain_id_t domain, D
     req.path_length = std::max(req.path_length, path_length);
 }
 
-void TimingAnalyser::walk_forward()
+void TimingAnalyser::init_startpoint(port_id_t port, domain_id_t dom_id, IdString clock_port)
 {
-    // Assign initial arrival time to domain startpoints
-    for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
-        auto &dom = domains.at(dom_id);
-        for (auto &sp : dom.startpoints) {
-            auto &pd = ports.at(sp.first);
-            DelayPair init_arrival(0);
-            CellPortKey clock_key;
-            if (sp.second != IdString()) {
-                // clocked startpoints have a clock-to-out time
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type == CellArc::CLK_TO_Q && fanin.other_port == sp.second) {
-                        init_arrival += fanin.value.delayPair();
-                        // Include the clock delay if clock_skew analysis is enabled
-                        if (with_clock_skew) {
-                            init_arrival += ports.at(CellPortKey(sp.first.cell, fanin.other_port)).route_delay;
-                        }
-                        break;
-                    }
+    auto &pd = ports.at(port);
+    DelayPair init_arrival(0);
+    port_id_t clock_id = -1;
+    if (clock_port != IdString()) {
+        // clocked startpoints have a clock-to-out time
+        for (auto &fanin : pd.cell_arcs) {
+            if (fanin.type == CellArc::CLK_TO_Q && fanin.other_port == clock_port) {
+                clock_id = fanin.other_id;
+                init_arrival += fanin.value.delayPair();
+                // Include the clock delay if clock_skew analysis is enabled
+                if (with_clock_skew) {
+                    init_arrival += ports.at(fanin.other_id).route_delay;
                 }
-                clock_key = CellPortKey(sp.first.cell, sp.second);
+                break;
             }
-            set_arrival_time(sp.first, dom_id, init_arrival, 1, clock_key);
         }
     }
-    // Walk forward in topological order
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &arr : pd.arrival) {
-            if (pd.type == PORT_OUT) {
-                // Output port: propagate delay through net, adding route delay
-                NetInfo *net = port_info(p).net;
-                if (net != nullptr)
-                    for (auto &usr : net->users) {
-                        CellPortKey usr_key(usr);
-                        auto &usr_pd = ports.at(usr_key);
-                        auto next_arr = arr.second.value + usr_pd.route_delay;
-                        set_arrival_time(usr_key, arr.first, next_arr, arr.second.path_length, p);
-                    }
-            } else if (pd.type == PORT_IN) {
-                // Input port; propagate delay through cell, adding combinational delay
-                for (auto &fanout : pd.cell_arcs) {
-                    if (fanout.type != CellArc::COMBINATIONAL)
-                        continue;
+    set_arrival_time(port, dom_id, init_arrival, 1, clock_id);
+}
 
-                    auto next_arr = arr.second.value + fanout.value.delayPair();
-                    set_arrival_time(CellPortKey(p.cell, fanout.other_port), arr.first, next_arr,
-                                     arr.second.path_length + 1, p);
+void TimingAnalyser::init_endpoint(port_id_t port, domain_id_t dom_id, IdString clock_port)
+{
+    auto &pd = ports.at(port);
+    DelayPair init_required(0);
+    port_id_t clock_id = -1;
+    // TODO: clock routing delay, if analysis of that is enabled
+    if (clock_port != IdString()) {
+        // Add setup/hold time, if this endpoint is clocked
+        for (auto &fanin : pd.cell_arcs) {
+
+            if (fanin.type == CellArc::SETUP && fanin.other_port == clock_port) {
+                clock_id = fanin.other_id;
+                if (with_clock_skew) {
+                    init_required += ports.at(fanin.other_id).route_delay;
                 }
+                init_required.min_delay -= fanin.value.maxDelay();
+            }
+            if (fanin.type == CellArc::HOLD && fanin.other_port == clock_port)
+                init_required.max_delay += fanin.value.maxDelay();
+        }
+    }
+    set_required_time(port, dom_id, init_required, 1, clock_id);
+}
+
+void TimingAnalyser::propagate_arrival(port_id_t p)
+{
+    auto &pd = ports.at(p);
+    for (int i = pd.arrival_begin; i < pd.arrival_end; i++) {
+        domain_id_t dom = arrival_domain.at(i);
+        const auto &arr = arrival_time.at(i);
+        if (pd.type == PORT_OUT) {
+            // Output port: propagate delay through net, adding route delay
+            for (int j = pd.users_begin; j < pd.users_end; j++) {
+                port_id_t usr = net_users.at(j);
+                auto next_arr = arr.value + ports.at(usr).route_delay;
+                set_arrival_time(usr, dom, next_arr, arr.path_length, p);
+            }
+        } else if (pd.type == PORT_IN) {
+            // Input port; propagate delay through cell, adding combinational delay
+            for (auto &fanout : pd.cell_arcs) {
+                if (fanout.type != CellArc::COMBINATIONAL)
+                    continue;
+
+                auto next_arr = arr.value + fanout.value.delayPair();
+                set_arrival_time(fanout.other_id, dom, next_arr, arr.path_length + 1, p);
             }
         }
     }
 }
 
+void TimingAnalyser::propagate_required(port_id_t p)
+{
+    auto &pd = ports.at(p);
+    for (int i = pd.required_begin; i < pd.required_end; i++) {
+        domain_id_t dom = required_domain.at(i);
+        const auto &req = required_time.at(i);
+        if (pd.type == PORT_IN) {
+            // Input port: propagate delay back through net, subtracting route delay
+            if (pd.net_driver != -1)
+                set_required_time(pd.net_driver, dom, req.value - DelayPair(pd.route_delay.maxDelay()), req.path_length,
+                                  p);
+        } else if (pd.type == PORT_OUT) {
+            // Output port : propagate delay back through cell, subtracting combinational delay
+            for (auto &fanin : pd.cell_arcs) {
+                if (fanin.type != CellArc::COMBINATIONAL)
+                    continue;
+                set_required_time(fanin.other_id, dom, req.value - DelayPair(fanin.value.maxDelay()),
+                                  req.path_length + 1, p);
+            }
+        }
+    }
+}
+
+void TimingAnalyser::walk_forward()
+{
+    if (threads > 1 && !level_starts.empty()) {
+        // Ports in a level only depend on earlier levels, so each level can be processed in parallel
+        for (int level = 0; level < int(level_starts.size()) - 1; level++)
+            walk_level(level, false);
+        return;
+    }
+    // Assign initial arrival time to domain startpoints
+    for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
+        auto &dom = domains.at(dom_id);
+        for (auto &sp : dom.startpoints)
+            init_startpoint(sp.first, dom_id, sp.second);
+    }
+    // Walk forward in topological order
+    for (auto p : topological_order)
+        propagate_arrival(p);
+}
+
 void TimingAnalyser::walk_backward()
 {
+    if (threads > 1 && !level_starts.empty()) {
+        for (int level = int(level_starts.size()) - 2; level >= 0; level--)
+            walk_level(level, true);
+        return;
+    }
     // Assign initial required time to domain endpoints
     // Note that clock frequency will be considered later in the analysis for, for now all required times are normalised
     // to 0ns
     for (domain_id_t dom_id = 0; dom_id < domain_id_t(domains.size()); ++dom_id) {
         auto &dom = domains.at(dom_id);
-        for (auto &ep : dom.endpoints) {
-            auto &pd = ports.at(ep.first);
-            DelayPair init_required(0);
-            CellPortKey clock_key;
-            // TODO: clock routing delay, if analysis of that is enabled
-            if (ep.second != IdString()) {
-                // Add setup/hold time, if this endpoint is clocked
-                for (auto &fanin : pd.cell_arcs) {
+        for (auto &ep : dom.endpoints)
+            init_endpoint(ep.first, dom_id, ep.second);
+    }
+    // Walk backwards in topological order
+    for (auto p : reversed_range(topological_order))
+        propagate_required(p);
+}
 
-                    if (fanin.type == CellArc::SETUP && fanin.other_port == ep.second) {
-                        if (with_clock_skew) {
-                            init_required += ports.at(CellPortKey(ep.first.cell, fanin.other_port)).route_delay;
-                        }
-                        init_required.min_delay -= fanin.value.maxDelay();
-                    }
-                    if (fanin.type == CellArc::HOLD && fanin.other_port == ep.second)
-                        init_required.max_delay += fanin.value.maxDelay();
-                }
-                clock_key = CellPortKey(ep.first.cell, ep.second);
+void TimingAnalyser::walk_level(int level, bool backwards)
+{
+    int begin = level_starts.at(level), end = level_starts.at(level + 1);
+    auto process = [this, backwards](int range_begin, int range_end) {
+        for (int i = range_begin; i < range_end; i++) {
+            if (backwards)
+                gather_required(topological_order.at(i));
+            else
+                gather_arrival(topological_order.at(i));
+        }
+    };
+    // Narrow levels aren't worth the threading overhead
+    const int min_ports_per_task = 512;
+    if ((end - begin) >= 2 * min_ports_per_task) {
+        ctx->thread_pool().run_ranges(backwards ? "timing/backward" : "timing/forward", end - begin,
+                                      min_ports_per_task, [&](int range_begin, int range_end) {
+                                          process(begin + range_begin, begin + range_end);
+                                      });
+        return;
+    }
+    process(begin, end);
+}
+
+void TimingAnalyser::gather_arrival(port_id_t p)
+{
+    auto &pd = ports.at(p);
+    for (auto &sp : pd.startpoints)
+        init_startpoint(p, sp.first, sp.second);
+    if (pd.type == PORT_IN) {
+        // Input port: arrival time at the driver plus route delay
+        if (pd.net_driver == -1)
+            return;
+        auto &drv = ports.at(pd.net_driver);
+        for (int i = drv.arrival_begin; i < drv.arrival_end; i++) {
+            auto &arr = arrival_time.at(i);
+            set_arrival_time(p, arrival_domain.at(i), arr.value + pd.route_delay, arr.path_length, pd.net_driver);
+        }
+    } else if (pd.type == PORT_OUT) {
+        // Output port: arrival times at the inputs plus combinational delay
+        for (int i = comb_fanin_start.at(p); i < comb_fanin_start.at(p + 1); i++) {
+            port_id_t in = comb_fanin.at(i).first;
+            auto &in_pd = ports.at(in);
+            auto &arc = in_pd.cell_arcs.at(comb_fanin.at(i).second);
+            for (int j = in_pd.arrival_begin; j < in_pd.arrival_end; j++) {
+                auto &arr = arrival_time.at(j);
+                set_arrival_time(p, arrival_domain.at(j), arr.value + arc.value.delayPair(), arr.path_length + 1, in);
             }
-            set_required_time(ep.first, dom_id, init_required, 1, clock_key);
         }
     }
-    // Walk backwards in topological order
-    for (auto p : reversed_range(topological_order)) {
+}
+
+void TimingAnalyser::gather_required(port_id_t p)
+{
+    auto &pd = ports.at(p);
+    for (auto &ep : pd.endpoints)
+        init_endpoint(p, ep.first, ep.second);
+    if (pd.type == PORT_OUT) {
+        // Output port: required times at the net users minus route delay
+        for (int i = pd.users_end - 1; i >= pd.users_begin; i--) {
+            port_id_t usr = net_users.at(i);
+            auto &usr_pd = ports.at(usr);
+            for (int j = usr_pd.required_begin; j < usr_pd.required_end; j++) {
+                auto &req = required_time.at(j);
+                set_required_time(p, required_domain.at(j), req.value - DelayPair(usr_pd.route_delay.maxDelay()),
+                                  req.path_length, usr);
+            }
+        }
+    } else if (pd.type == PORT_IN) {
+        // Input port: required times at the outputs minus combinational delay
+        for (int i = comb_fanout_start.at(p + 1) - 1; i >= comb_fanout_start.at(p); i--) {
+            port_id_t out = comb_fanout.at(i).first;
+            auto &out_pd = ports.at(out);
+            auto &arc = out_pd.cell_arcs.at(comb_fanout.at(i).second);
+            for (int j = out_pd.required_begin; j < out_pd.required_end; j++) {
+                auto &req = required_time.at(j);
+                set_required_time(p, required_domain.at(j), req.value - DelayPair(arc.value.maxDelay()),
+                                  req.path_length + 1, out);
+            }
+        }
+    }
+}
+
+void TimingAnalyser::get_fanin(port_id_t p, std::vector<port_id_t> &fanin)
+{
+    auto &pd = ports.at(p);
+    if (pd.type == PORT_IN) {
+        if (pd.net_driver != -1)
+            fanin.push_back(pd.net_driver);
+    } else if (pd.type == PORT_OUT) {
+        for (auto &arc : pd.cell_arcs)
+            if (arc.type == CellArc::COMBINATIONAL)
+                fanin.push_back(arc.other_id);
+    }
+}
+
+void TimingAnalyser::get_fanout(port_id_t p, std::vector<port_id_t> &fanout)
+{
+    auto &pd = ports.at(p);
+    if (pd.type == PORT_OUT) {
+        fanout.insert(fanout.end(), net_users.begin() + pd.users_begin, net_users.begin() + pd.users_end);
+    } else if (pd.type == PORT_IN) {
+        for (auto &arc : pd.cell_arcs)
+            if (arc.type == CellArc::COMBINATIONAL)
+                fanout.push_back(arc.other_id);
+    }
+}
+
+void TimingAnalyser::find_cone(std::vector<port_id_t> &cone, bool backwards)
+{
+    std::vector<port_id_t> next;
+    // The cone starts off containing only the seeds
+    for (size_t i = 0; i < cone.size(); i++) {
+        next.clear();
+        if (backwards)
+            get_fanin(cone.at(i), next);
+        else
+            get_fanout(cone.at(i), next);
+        for (auto n : next) {
+            auto &pd = ports.at(n);
+            bool &mark = backwards ? pd.in_bwd_cone : pd.in_fwd_cone;
+            if (mark)
+                continue;
+            mark = true;
+            cone.push_back(n);
+        }
+    }
+    std::sort(cone.begin(), cone.end(),
+              [&](port_id_t a, port_id_t b) { return ports.at(a).topo_index < ports.at(b).topo_index; });
+}
+
+void TimingAnalyser::run_incremental()
+{
+    static const auto init_delay =
+            DelayPair(std::numeric_limits<delay_t>::max(), std::numeric_limits<delay_t>::lowest());
+    // Find the ports where propagation must start. A changed route delay affects the arrival time at the sink port
+    // and the required time at the driver; with clock skew analysis clock route delays also affect the initial
+    // arrival and required times of the startpoints and endpoints of that cell.
+    std::vector<port_id_t> fwd_cone, bwd_cone;
+    auto add_seed = [&](std::vector<port_id_t> &cone, port_id_t port, bool backwards) {
+        auto &pd = ports.at(port);
+        bool &mark = backwards ? pd.in_bwd_cone : pd.in_fwd_cone;
+        if (mark)
+            return;
+        mark = true;
+        cone.push_back(port);
+    };
+    for (auto port : changed_route_delays) {
+        add_seed(fwd_cone, port, false);
+        if (ports.at(port).net_driver != -1)
+            add_seed(bwd_cone, ports.at(port).net_driver, true);
+        if (!with_clock_skew)
+            continue;
+        const auto &key = ports.at(port).cell_port;
+        for (auto &cell_port : cell_info(key)->ports) {
+            port_id_t other = port_to_id.at(CellPortKey(key.cell, cell_port.first));
+            for (auto &arc : ports.at(other).cell_arcs) {
+                if (arc.other_id != port)
+                    continue;
+                if (arc.type == CellArc::CLK_TO_Q)
+                    add_seed(fwd_cone, other, false);
+                else if (arc.type == CellArc::SETUP)
+                    add_seed(bwd_cone, other, true);
+            }
+        }
+    }
+    find_cone(fwd_cone, false);
+    find_cone(bwd_cone, true);
+
+    // Forward cone: reset arrival times, then re-add startpoints and the contribution of ports outside of the cone.
+    // Ports outside of the cone are unchanged, so propagating them again leaves their other fanouts untouched.
+    auto reset_range = [&](std::vector<ArrivReqTime> &times, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            auto &t = times.at(i);
+            t.value = init_delay;
+            t.path_length = 0;
+            t.bwd_min = -1;
+            t.bwd_max = -1;
+        }
+    };
+    std::vector<port_id_t> boundary;
+    pool<port_id_t> boundary_seen;
+    for (auto p : fwd_cone)
+        reset_range(arrival_time, ports.at(p).arrival_begin, ports.at(p).arrival_end);
+    for (auto p : fwd_cone) {
+        for (auto &sp : ports.at(p).startpoints)
+            init_startpoint(p, sp.first, sp.second);
+        boundary.clear();
+        get_fanin(p, boundary);
+        for (auto b : boundary)
+            if (!ports.at(b).in_fwd_cone && boundary_seen.insert(b).second)
+                propagate_arrival(b);
+    }
+    for (auto p : fwd_cone)
+        propagate_arrival(p);
+
+    // Backward cone: the same process for required times
+    boundary_seen.clear();
+    for (auto p : bwd_cone)
+        reset_range(required_time, ports.at(p).required_begin, ports.at(p).required_end);
+    for (auto p : bwd_cone) {
+        for (auto &ep : ports.at(p).endpoints)
+            init_endpoint(p, ep.first, ep.second);
+        boundary.clear();
+        get_fanout(p, boundary);
+        for (auto b : boundary)
+            if (!ports.at(b).in_bwd_cone && boundary_seen.insert(b).second)
+                propagate_required(b);
+    }
+    for (auto p : reversed_range(bwd_cone))
+        propagate_required(p);
+
+    // Slack has changed for every port in either cone
+    std::vector<port_id_t> affected;
+    for (auto p : fwd_cone) {
+        ports.at(p).in_fwd_cone = false;
+        affected.push_back(p);
+    }
+    for (auto p : bwd_cone) {
         auto &pd = ports.at(p);
-        for (auto &req : pd.required) {
-            if (pd.type == PORT_IN) {
-                // Input port: propagate delay back through net, subtracting route delay
-                NetInfo *net = port_info(p).net;
-                if (net != nullptr && net->driver.cell != nullptr)
-                    set_required_time(CellPortKey(net->driver), req.first,
-                                      req.second.value - DelayPair(pd.route_delay.maxDelay()), req.second.path_length,
-                                      p);
-            } else if (pd.type == PORT_OUT) {
-                // Output port : propagate delay back through cell, subtracting combinational delay
-                for (auto &fanin : pd.cell_arcs) {
-                    if (fanin.type != CellArc::COMBINATIONAL)
-                        continue;
-                    set_required_time(CellPortKey(p.cell, fanin.other_port), req.first,
-                                      req.second.value - DelayPair(fanin.value.maxDelay()), req.second.path_length + 1,
-                                      p);
-                }
+        pd.in_bwd_cone = false;
+        if (!pd.in_fwd_cone)
+            affected.push_back(p);
+    }
+
+    // If an affected port set the worst slack of a domain pair, that slack might have got better, which can only be
+    // found with a full pass
+    for (auto p : affected) {
+        auto &pd = ports.at(p);
+        for (int i = pd.pair_begin; i < pd.pair_end; i++) {
+            auto &dp = domain_pairs.at(pair_domain.at(i));
+            auto &pdp = pair_data.at(i);
+            if (pdp.setup_slack == dp.worst_setup_slack || (!setup_only && pdp.hold_slack == dp.worst_hold_slack)) {
+                compute_slack();
+                compute_criticality();
+                return;
             }
         }
     }
+    std::vector<delay_t> old_worst_setup;
+    for (auto &dp : domain_pairs)
+        old_worst_setup.push_back(dp.worst_setup_slack);
+    for (auto p : affected)
+        compute_port_slack(p);
+    // Criticality is relative to the worst slack, so a change in it affects every port
+    bool worst_changed = false;
+    for (domain_id_t i = 0; i < domain_id_t(domain_pairs.size()); i++)
+        worst_changed |= (domain_pairs.at(i).worst_setup_slack != old_worst_setup.at(i));
+    if (worst_changed) {
+        compute_criticality();
+    } else {
+        for (auto p : affected)
+            compute_port_criticality(p);
+    }
+}
+
+void TimingAnalyser::verify_incremental()
+{
+    auto inc_ports = ports;
+    auto inc_arrival = arrival_time, inc_required = required_time;
+    auto inc_domain_pairs = domain_pairs;
+    run_full();
+    auto check_times = [&](const PerPort &pd, const char *type, const ArrivReqTime &inc, const ArrivReqTime &full) {
+        if (inc.value.min_delay != full.value.min_delay || inc.value.max_delay != full.value.max_delay)
+            log_error("Incremental timing mismatch at %s.%s: %s time (%.3f, %.3f) expected (%.3f, %.3f)\n",
+                      ctx->nameOf(pd.cell_port.cell), ctx->nameOf(pd.cell_port.port), type,
+                      ctx->getDelayNS(inc.value.min_delay), ctx->getDelayNS(inc.value.max_delay),
+                      ctx->getDelayNS(full.value.min_delay), ctx->getDelayNS(full.value.max_delay));
+    };
+    for (port_id_t p = 0; p < port_id_t(ports.size()); p++) {
+        auto &inc = inc_ports.at(p);
+        auto &full = ports.at(p);
+        for (int i = full.arrival_begin; i < full.arrival_end; i++)
+            check_times(full, "arrival", inc_arrival.at(i), arrival_time.at(i));
+        for (int i = full.required_begin; i < full.required_end; i++)
+            check_times(full, "required", inc_required.at(i), required_time.at(i));
+        if (inc.worst_setup_slack != full.worst_setup_slack || inc.worst_crit != full.worst_crit)
+            log_error("Incremental timing mismatch at %s.%s: slack %.3f crit %.3f expected slack %.3f crit %.3f\n",
+                      ctx->nameOf(full.cell_port.cell), ctx->nameOf(full.cell_port.port),
+                      ctx->getDelayNS(inc.worst_setup_slack), inc.worst_crit, ctx->getDelayNS(full.worst_setup_slack),
+                      full.worst_crit);
+    }
+    for (domain_id_t i = 0; i < domain_id_t(domain_pairs.size()); i++)
+        if (inc_domain_pairs.at(i).worst_setup_slack != domain_pairs.at(i).worst_setup_slack)
+            log_error("Incremental timing mismatch in worst slack of domain pair %d\n", i);
 }
 
 dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
@@ -677,9 +1146,11 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
         for (auto &ep : capture.endpoints) {
             auto &ep_port = ports.at(ep.first);
 
-            auto &req = ep_port.required.at(capture_id);
+            auto &req = required_time.at(find_required(ep.first, capture_id));
 
-            for (auto &[launch_id, arr] : ep_port.arrival) {
+            for (int i = ep_port.arrival_begin; i < ep_port.arrival_end; i++) {
+                domain_id_t launch_id = arrival_domain.at(i);
+                const auto &arr = arrival_time.at(i);
                 const auto &launch = domains.at(capture_id);
 
                 auto dp = domain_pair_id(launch_id, capture_id);
@@ -700,7 +1171,7 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
                 if (with_clock_skew && !same_clock && !related_clocks) {
                     for (auto &fanin : ep_port.cell_arcs) {
                         if (fanin.type == CellArc::SETUP) {
-                            auto clock_delay = ports.at(CellPortKey(ep.first.cell, fanin.other_port)).route_delay;
+                            auto clock_delay = ports.at(fanin.other_id).route_delay;
                             delay += clock_delay.minDelay();
                         }
                     }
@@ -709,11 +1180,11 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
                     auto crit_path = walk_crit_path(domain_pair_id(launch_id, capture_id), ep.first, true);
                     auto first_inp = crit_path.back();
                     const auto &sp = first_inp.cell->ports.at(first_inp.port).net->driver;
-                    auto &sp_port = ports.at(CellPortKey{sp.cell->name, sp.port});
+                    auto &sp_port = ports.at(port_to_id.at(CellPortKey{sp.cell->name, sp.port}));
 
                     for (auto &fanin : sp_port.cell_arcs) {
                         if (fanin.type == CellArc::CLK_TO_Q) {
-                            auto clock_delay = ports.at(CellPortKey(sp.cell->name, fanin.other_port)).route_delay;
+                            auto clock_delay = ports.at(fanin.other_id).route_delay;
                             delay -= clock_delay.maxDelay();
                         }
                     }
@@ -729,63 +1200,75 @@ dict<domain_id_t, delay_t> TimingAnalyser::max_delay_by_domain_pairs()
     return domain_delay;
 }
 
+void TimingAnalyser::compute_port_slack(port_id_t p)
+{
+    auto &pd = ports.at(p);
+    pd.worst_setup_slack = std::numeric_limits<delay_t>::max();
+    pd.worst_hold_slack = std::numeric_limits<delay_t>::max();
+    for (int i = pd.pair_begin; i < pd.pair_end; i++) {
+        auto &dp = domain_pairs.at(pair_domain.at(i));
+        auto &pdp = pair_data.at(i);
+
+        // Get clock names
+        const auto &launch_clock = domains.at(dp.key.launch).key.clock;
+        const auto &capture_clock = domains.at(dp.key.capture).key.clock;
+
+        // Get clock-to-clock delay if any
+        delay_t clock_to_clock = 0;
+        auto clocks = std::make_pair(launch_clock, capture_clock);
+        if (clock_delays.count(clocks)) {
+            clock_to_clock = clock_delays.at(clocks);
+        }
+
+        auto &arr = arrival_time.at(find_arrival(p, dp.key.launch));
+        auto &req = required_time.at(find_required(p, dp.key.capture));
+        pdp.setup_slack = 0 - (arr.value.maxDelay() - req.value.minDelay() + clock_to_clock);
+        if (!setup_only)
+            pdp.hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
+        pdp.max_path_length = arr.path_length + req.path_length;
+        if (dp.key.launch == dp.key.capture)
+            pd.worst_setup_slack = std::min(pd.worst_setup_slack, dp.period.minDelay() + pdp.setup_slack);
+        dp.worst_setup_slack = std::min(dp.worst_setup_slack, pdp.setup_slack);
+        if (!setup_only) {
+            pd.worst_hold_slack = std::min(pd.worst_hold_slack, pdp.hold_slack);
+            dp.worst_hold_slack = std::min(dp.worst_hold_slack, pdp.hold_slack);
+        }
+    }
+}
+
 void TimingAnalyser::compute_slack()
 {
     for (auto &dp : domain_pairs) {
         dp.worst_setup_slack = std::numeric_limits<delay_t>::max();
         dp.worst_hold_slack = std::numeric_limits<delay_t>::max();
     }
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &pdp : pd.domain_pairs) {
-            auto &dp = domain_pairs.at(pdp.first);
-
-            // Get clock names
-            const auto &launch_clock = domains.at(dp.key.launch).key.clock;
-            const auto &capture_clock = domains.at(dp.key.capture).key.clock;
-
-            // Get clock-to-clock delay if any
-            delay_t clock_to_clock = 0;
-            auto clocks = std::make_pair(launch_clock, capture_clock);
-            if (clock_delays.count(clocks)) {
-                clock_to_clock = clock_delays.at(clocks);
-            }
+    for (auto p : topological_order)
+        compute_port_slack(p);
+}
 
-            auto &arr = pd.arrival.at(dp.key.launch);
-            auto &req = pd.required.at(dp.key.capture);
-            pdp.second.setup_slack = 0 - (arr.value.maxDelay() - req.value.minDelay() + clock_to_clock);
-            if (!setup_only)
-                pdp.second.hold_slack = arr.value.minDelay() - req.value.maxDelay() + clock_to_clock;
-            pdp.second.max_path_length = arr.path_length + req.path_length;
-            if (dp.key.launch == dp.key.capture)
-                pd.worst_setup_slack = std::min(pd.worst_setup_slack, dp.period.minDelay() + pdp.second.setup_slack);
-            dp.worst_setup_slack = std::min(dp.worst_setup_slack, pdp.second.setup_slack);
-            if (!setup_only) {
-                pd.worst_hold_slack = std::min(pd.worst_hold_slack, pdp.second.hold_slack);
-                dp.worst_hold_slack = std::min(dp.worst_hold_slack, pdp.second.hold_slack);
-            }
-        }
+void TimingAnalyser::compute_port_criticality(port_id_t p)
+{
+    auto &pd = ports.at(p);
+    pd.worst_crit = 0;
+    for (int i = pd.pair_begin; i < pd.pair_end; i++) {
+        auto &dp = domain_pairs.at(pair_domain.at(i));
+        auto &pdp = pair_data.at(i);
+        // Do not set criticality for asynchronous paths
+        if (domains.at(dp.key.launch).key.is_async() || domains.at(dp.key.capture).key.is_async())
+            continue;
+
+        float crit = 1.0f - (float(pdp.setup_slack) - float(dp.worst_setup_slack)) / float(-dp.worst_setup_slack);
+        crit = std::min(crit, 1.0f);
+        crit = std::max(crit, 0.0f);
+        pdp.criticality = crit;
+        pd.worst_crit = std::max(pd.worst_crit, crit);
     }
 }
 
 void TimingAnalyser::compute_criticality()
 {
-    for (auto p : topological_order) {
-        auto &pd = ports.at(p);
-        for (auto &pdp : pd.domain_pairs) {
-            auto &dp = domain_pairs.at(pdp.first);
-            // Do not set criticality for asynchronous paths
-            if (domains.at(dp.key.launch).key.is_async() || domains.at(dp.key.capture).key.is_async())
-                continue;
-
-            float crit =
-                    1.0f - (float(pdp.second.setup_slack) - float(dp.worst_setup_slack)) / float(-dp.worst_setup_slack);
-            crit = std::min(crit, 1.0f);
-            crit = std::max(crit, 0.0f);
-            pdp.second.criticality = crit;
-            pd.worst_crit = std::max(pd.worst_crit, crit);
-        }
-    }
+    for (auto p : topological_order)
+        compute_port_criticality(p);
 }
 
 void TimingAnalyser::build_detailed_net_timing_report()
@@ -796,12 +1279,12 @@ void TimingAnalyser::build_detailed_net_timing_report()
         auto &dom = domains.at(dom_id);
         for (auto &ep : dom.endpoints) {
             auto &pd = ports.at(ep.first);
-            const NetInfo *net = port_info(ep.first).net;
+            const NetInfo *net = port_info(pd.cell_port).net;
 
-            for (auto &arr : pd.arrival) {
-                auto &launch = domains.at(arr.first).key;
-                for (auto &req : pd.required) {
-                    auto &capture = domains.at(req.first).key;
+            for (int i = pd.arrival_begin; i < pd.arrival_end; i++) {
+                auto &launch = domains.at(arrival_domain.at(i)).key;
+                for (int j = pd.required_begin; j < pd.required_end; j++) {
+                    auto &capture = domains.at(required_domain.at(j)).key;
 
                     NetSinkTiming sink_timing;
                     sink_timing.clock_pair.start.clock = launch.clock;
@@ -809,7 +1292,7 @@ void TimingAnalyser::build_detailed_net_timing_report()
                     sink_timing.clock_pair.end.clock = capture.clock;
                     sink_timing.clock_pair.end.edge = capture.edge;
                     sink_timing.cell_port = std::make_pair(pd.cell_port.cell, pd.cell_port.port);
-                    sink_timing.delay = arr.second.value;
+                    sink_timing.delay = arrival_time.at(i).value;
 
                     net_timings[net->name].push_back(sink_timing);
                 }
@@ -818,26 +1301,27 @@ void TimingAnalyser::build_detailed_net_timing_report()
     }
 }
 
-std::vector<CellPortKey> TimingAnalyser::get_worst_eps(domain_id_t domain_pair, int count)
+std::vector<port_id_t> TimingAnalyser::get_worst_eps(domain_id_t domain_pair, int count)
 {
-    std::vector<CellPortKey> worst_eps;
+    std::vector<port_id_t> worst_eps;
     delay_t last_slack = std::numeric_limits<delay_t>::lowest();
     auto &dp = domain_pairs.at(domain_pair);
     auto &cap_d = domains.at(dp.key.capture);
     while (int(worst_eps.size()) < count) {
-        CellPortKey next;
+        port_id_t next = -1;
         delay_t next_slack = std::numeric_limits<delay_t>::max();
         for (auto ep : cap_d.endpoints) {
             auto &pd = ports.at(ep.first);
-            if (!pd.domain_pairs.count(domain_pair))
+            auto pair = std::find(pair_domain.begin() + pd.pair_begin, pair_domain.begin() + pd.pair_end, domain_pair);
+            if (pair == pair_domain.begin() + pd.pair_end)
                 continue;
-            delay_t ep_slack = pd.domain_pairs.at(domain_pair).setup_slack;
+            delay_t ep_slack = pair_data.at(pair - pair_domain.begin()).setup_slack;
             if (ep_slack < next_slack && ep_slack > last_slack) {
                 next = ep.first;
                 next_slack = ep_slack;
             }
         }
-        if (next == CellPortKey())
+        if (next == -1)
             break;
         worst_eps.push_back(next);
         last_slack = next_slack;
@@ -845,7 +1329,7 @@ std::vector<CellPortKey> TimingAnalyser::get_worst_eps(domain_id_t domain_pair,
     return worst_eps;
 }
 
-std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, CellPortKey endpoint, bool longest_path)
+std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, port_id_t endpoint, bool longest_path)
 {
     const auto &dp = domain_pairs.at(domain_pair);
 
@@ -856,8 +1340,8 @@ std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, Cel
 
     bool is_startpoint = false;
     do {
-        auto cell = cell_info(cursor);
-        auto &port = port_info(cursor);
+        auto cell = cell_info(ports.at(cursor).cell_port);
+        auto &port = port_info(ports.at(cursor).cell_port);
         int port_clocks;
         auto portClass = ctx->getPortTimingClass(cell, port.name, port_clocks);
 
@@ -872,21 +1356,22 @@ std::vector<PortRef> TimingAnalyser::walk_crit_path(domain_id_t domain_pair, Cel
         if (is_input)
             crit_path_rev.emplace_back(PortRef{cell, port.name});
 
-        if (!ports.at(cursor).arrival.count(dp.key.launch))
+        int arr = find_arrival(cursor, dp.key.launch);
+        if (arr == -1)
             break;
 
         if (longest_path) {
-            cursor = ports.at(cursor).arrival.at(dp.key.launch).bwd_max;
+            cursor = arrival_time.at(arr).bwd_max;
         } else {
-            cursor = ports.at(cursor).arrival.at(dp.key.launch).bwd_min;
+            cursor = arrival_time.at(arr).bwd_min;
         }
         is_startpoint = portClass == TMG_STARTPOINT;
-    } while (!is_startpoint);
+    } while (!is_startpoint && cursor != -1);
 
     return crit_path_rev;
 }
 
-CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair, CellPortKey endpoint,
+CriticalPath TimingAnalyser::build_critical_path_report(domain_id_t domain_pair, port_id_t endpoint,
                                                         bool longest_path)
 {
     CriticalPath report;
@@ -1172,10 +1657,10 @@ void TimingAnalyser::build_slack_histogram_report()
         for (auto &ep : domains.at(dom_id).endpoints) {
             auto &pd = ports.at(ep.first);
 
-            for (auto &req : pd.required) {
-                auto &capture = domains.at(req.first).key;
-                for (auto &arr : pd.arrival) {
-                    auto &launch = domains.at(arr.first).key;
+            for (int i = pd.required_begin; i < pd.required_end; i++) {
+                auto &capture = domains.at(required_domain.at(i)).key;
+                for (int j = pd.arrival_begin; j < pd.arrival_end; j++) {
+                    auto &launch = domains.at(arrival_domain.at(j)).key;
 
                     if (launch.clock != capture.clock || launch.is_async())
                         continue;
@@ -1187,7 +1672,7 @@ void TimingAnalyser::build_slack_histogram_report()
                     if (launch.edge != capture.edge)
                         clk_period = clk_period / 2;
 
-                    delay_t delay = arr.second.value.maxDelay() - req.second.value.minDelay();
+                    delay_t delay = arrival_time.at(j).value.maxDelay() - required_time.at(i).value.minDelay();
                     delay_t slack = clk_period - delay;
 
                     int slack_ps = ctx->getDelayNS(slack) * 1000;
@@ -1207,17 +1692,18 @@ std::vector<CriticalPath> TimingAnalyser::get_min_delay_violations()
         const auto &capture_clock = capture.key.clock;
 
         for (const auto &ep : capture.endpoints) {
-            const CellInfo *ci = cell_info(ep.first);
+            const auto &port = ports.at(ep.first);
+            const CellInfo *ci = cell_info(port.cell_port);
             int clkInfoCount = 0;
-            const TimingPortClass cls = ctx->getPortTimingClass(ci, ep.first.port, clkInfoCount);
+            const TimingPortClass cls = ctx->getPortTimingClass(ci, port.cell_port.port, clkInfoCount);
             if (cls != TMG_REGISTER_INPUT)
                 continue;
 
-            const auto &port = ports.at(ep.first);
-
-            const auto &req = port.required.at(capture_id);
+            const auto &req = required_time.at(find_required(ep.first, capture_id));
 
-            for (auto &[launch_id, arr] : port.arrival) {
+            for (int i = port.arrival_begin; i < port.arrival_end; i++) {
+                domain_id_t launch_id = arrival_domain.at(i);
+                const auto &arr = arrival_time.at(i);
                 const auto &launch = domains.at(launch_id);
                 const auto &launch_clock = launch.key.clock;
                 const auto dom_pair_id = domain_pair_id(launch_id, capture_id);
@@ -1294,14 +1780,34 @@ domain_id_t TimingAnalyser::domain_pair_id(domain_id_t launch, domain_id_t captu
     return inserted.first->second;
 }
 
-void TimingAnalyser::copy_domains(const CellPortKey &from, const CellPortKey &to, bool backward)
+void TimingAnalyser::copy_domains(const std::vector<domain_id_t> &from, std::vector<domain_id_t> &to)
 {
-    auto &f = ports.at(from), &t = ports.at(to);
-    for (auto &dom : (backward ? f.required : f.arrival)) {
-        updated_domains |= (backward ? t.required : t.arrival).emplace(dom.first, ArrivReqTime{}).second;
+    for (auto dom : from) {
+        if (std::find(to.begin(), to.end(), dom) != to.end())
+            continue;
+        to.push_back(dom);
+        updated_domains = true;
     }
 }
 
+int TimingAnalyser::find_arrival(port_id_t port, domain_id_t domain) const
+{
+    auto &pd = ports.at(port);
+    for (int i = pd.arrival_begin; i < pd.arrival_end; i++)
+        if (arrival_domain.at(i) == domain)
+            return i;
+    return -1;
+}
+
+int TimingAnalyser::find_required(port_id_t port, domain_id_t domain) const
+{
+    auto &pd = ports.at(port);
+    for (int i = pd.required_begin; i < pd.required_end; i++)
+        if (required_domain.at(i) == domain)
+            return i;
+    return -1;
+}
+
 const std::string TimingAnalyser::arcType_to_str(CellArc::ArcType typ)
 {
     switch (typ) {
@@ -59,6 +59,7 @@ struct ClockDomainKey
 };
 
 typedef int domain_id_t;
+typedef int port_id_t;
 
 struct ClockDomainPairKey
 {
@@ -84,13 +85,14 @@ struct TimingAnalyser
     // model), but want to re-run STA with their own calculated delays
     void set_route_delay(CellPortKey port, DelayPair value);
 
-    float get_criticality(CellPortKey port) const { return ports.at(port).worst_crit; }
-    float get_setup_slack(CellPortKey port) const { return ports.at(port).worst_setup_slack; }
+    float get_criticality(CellPortKey port) const { return ports.at(port_to_id.at(port)).worst_crit; }
+    float get_setup_slack(CellPortKey port) const { return ports.at(port_to_id.at(port)).worst_setup_slack; }
     float get_domain_setup_slack(CellPortKey port) const
     {
         delay_t slack = std::numeric_limits<delay_t>::max();
-        for (const auto &dp : ports.at(port).domain_pairs)
-            slack = std::min(slack, domain_pairs.at(dp.first).worst_setup_slack);
+        const auto &pd = ports.at(port_to_id.at(port));
+        for (int i = pd.pair_begin; i < pd.pair_end; i++)
+            slack = std::min(slack, domain_pairs.at(pair_domain.at(i)).worst_setup_slack);
         return slack;
     }
 
@@ -102,6 +104,11 @@ struct TimingAnalyser
     bool with_clock_skew = false;
 
     bool setup_only = false;
+    // Only re-propagate through the fan-in/fan-out cones of ports whose route delay changed since the last run. Falls
+    // back to a full analysis on the first run after setup and if the timing graph has loops.
+    bool incremental = false;
+    // Number of threads used for the forward and backward walks of a full analysis; defaults to --threads
+    int threads = 1;
     bool have_loops = false;
     bool updated_domains = false;
 
@@ -109,26 +116,37 @@ struct TimingAnalyser
     void init_ports();
     void get_cell_delays();
     void get_route_delays();
+    void set_route_delay(port_id_t port, DelayPair value);
     void topo_sort();
     void setup_port_domains();
     void identify_related_domains();
 
     void reset_times();
 
+    void run_full();
+    void run_incremental();
+    // Compare the result of an incremental run against a full analysis (timing/checkIncremental)
+    void verify_incremental();
+
     void walk_forward();
     void walk_backward();
 
+    // Group the topological order into levels of independent ports, and find the arcs needed to walk them
+    void levelise();
+    // Walk one level, in parallel if it is wide enough
+    void walk_level(int level, bool backwards);
+
     void compute_slack();
     void compute_criticality();
 
     // Walk the endpoint back to a startpoint and get back the input ports walked
     // and the startpoint.
-    std::vector<PortRef> walk_crit_path(domain_id_t domain_pair, CellPortKey endpoint, bool longest_path);
+    std::vector<PortRef> walk_crit_path(domain_id_t domain_pair, port_id_t endpoint, bool longest_path);
 
     void build_detailed_net_timing_report();
     // longest_path indicate whether to follow the longest or shortest path from endpoint to startpoint
     // longest paths are interesting for setup violations and shortest paths are interesting for hold violations
-    CriticalPath build_critical_path_report(domain_id_t domain_pair, CellPortKey endpoint, bool longest_path);
+    CriticalPath build_critical_path_report(domain_id_t domain_pair, port_id_t endpoint, bool longest_path);
     void build_crit_path_reports();
     void build_slack_histogram_report();
 
@@ -137,13 +155,36 @@ struct TimingAnalyser
     dict<domain_id_t, delay_t> max_delay_by_domain_pairs();
 
     // get the N worst endpoints for a given domain pair
-    std::vector<CellPortKey> get_worst_eps(domain_id_t domain_pair, int count);
+    std::vector<port_id_t> get_worst_eps(domain_id_t domain_pair, int count);
 
     // Set arrival/required times if more/less than the current value
-    void set_arrival_time(CellPortKey target, domain_id_t domain, DelayPair arrival, int path_length,
-                          CellPortKey prev = CellPortKey());
-    void set_required_time(CellPortKey target, domain_id_t domain, DelayPair required, int path_length,
-                           CellPortKey prev = CellPortKey());
+    void set_arrival_time(port_id_t target, domain_id_t domain, DelayPair arrival, int path_length,
+                          port_id_t prev = -1);
+    void set_required_time(port_id_t target, domain_id_t domain, DelayPair required, int path_length,
+                           port_id_t prev = -1);
+
+    // Per-port steps of the forward and backward walks, shared by the full and incremental analysis
+    void init_startpoint(port_id_t port, domain_id_t dom_id, IdString clock_port);
+    void init_endpoint(port_id_t port, domain_id_t dom_id, IdString clock_port);
+    void propagate_arrival(port_id_t p);
+    void propagate_required(port_id_t p);
+    // Equivalents of propagate_arrival/propagate_required that pull times into a port from its fan-in/fan-out, in the
+    // same order as the serial walk would push them, so that ports in a level can be processed in parallel
+    void gather_arrival(port_id_t p);
+    void gather_required(port_id_t p);
+    void compute_port_slack(port_id_t p);
+    void compute_port_criticality(port_id_t p);
+
+    // Timing graph neighbours of a port, following nets and combinational arcs
+    void get_fanin(port_id_t p, std::vector<port_id_t> &fanin);
+    void get_fanout(port_id_t p, std::vector<port_id_t> &fanout);
+    // Extend a list of (already marked) seed ports to its full fan-out (or fan-in) cone, sorted topologically
+    void find_cone(std::vector<port_id_t> &cone, bool backwards);
+
+    // Index of a domain's entry within the range of a port in the flattened per-domain arrays, or -1 if the port
+    // has no timing for that domain
+    int find_arrival(port_id_t port, domain_id_t domain) const;
+    int find_required(port_id_t port, domain_id_t domain) const;
 
     // To avoid storing the domain tag structure (which could get large when considering more complex constrained tag
     // cases), assign each domain an ID and use that instead
@@ -152,8 +193,8 @@ struct TimingAnalyser
     struct ArrivReqTime
     {
         DelayPair value;
-        CellPortKey bwd_min, bwd_max;
-        int path_length;
+        port_id_t bwd_min = -1, bwd_max = -1;
+        int path_length = 0;
     };
     // Data per port-domain tuple
     struct PortDomainPairData
@@ -178,6 +219,8 @@ struct TimingAnalyser
         } type;
 
         IdString other_port;
+        // index of other_port, if there is one
+        port_id_t other_id = -1;
         DelayQuad value;
         // Clock polarity, not used for combinational arcs
         ClockEdge edge;
@@ -193,18 +236,26 @@ struct TimingAnalyser
     {
         CellPortKey cell_port;
         PortType type;
-        // per domain timings
-        dict<domain_id_t, ArrivReqTime> arrival;
-        dict<domain_id_t, ArrivReqTime> required;
-        dict<domain_id_t, PortDomainPairData> domain_pairs;
+        // ranges of this port's entries in the flattened per-domain timing arrays
+        int arrival_begin = 0, arrival_end = 0;
+        int required_begin = 0, required_end = 0;
+        int pair_begin = 0, pair_end = 0;
         // cell timing arcs to (outputs)/from (inputs)  from this port
         std::vector<CellArc> cell_arcs;
+        // driver of the net (input ports only) and range of the net users in net_users (output ports only)
+        port_id_t net_driver = -1;
+        int users_begin = 0, users_end = 0;
         // routing delay into this port (input ports only)
         DelayPair route_delay{0};
         // worst criticality and slack across domain pairs
         float worst_crit = 0;
         delay_t worst_setup_slack = std::numeric_limits<delay_t>::max(),
                 worst_hold_slack = std::numeric_limits<delay_t>::max();
+        // domains this port is a startpoint/endpoint of; pairs (domain; clock port)
+        std::vector<std::pair<domain_id_t, IdString>> startpoints, endpoints;
+        // position in topological_order, and marks used while finding the incremental cones
+        int topo_index = -1;
+        bool in_fwd_cone = false, in_bwd_cone = false;
     };
 
     struct PerDomain
@@ -212,7 +263,7 @@ struct TimingAnalyser
         PerDomain(ClockDomainKey key) : key(key) {};
         ClockDomainKey key;
         // these are pairs (signal port; clock port)
-        std::vector<std::pair<CellPortKey, IdString>> startpoints, endpoints;
+        std::vector<std::pair<port_id_t, IdString>> startpoints, endpoints;
     };
 
     struct PerDomainPair
@@ -230,18 +281,37 @@ struct TimingAnalyser
     domain_id_t domain_id(const NetInfo *net, ClockEdge edge);
     domain_id_t domain_pair_id(domain_id_t launch, domain_id_t capture);
 
-    void copy_domains(const CellPortKey &from, const CellPortKey &to, bool backwards);
+    void copy_domains(const std::vector<domain_id_t> &from, std::vector<domain_id_t> &to);
 
     [[maybe_unused]] static const std::string arcType_to_str(CellArc::ArcType typ);
 
-    dict<CellPortKey, PerPort> ports;
+    // Ports are indexed densely in the order created by init_ports
+    std::vector<PerPort> ports;
+    dict<CellPortKey, port_id_t> port_to_id;
+    std::vector<port_id_t> net_users;
+    // Per-domain timing data, as flat arrays with a contiguous range for each port. Most ports only see a handful of
+    // domains, so a linear scan of the range is cheaper than a hash lookup.
+    std::vector<domain_id_t> arrival_domain, required_domain, pair_domain;
+    std::vector<ArrivReqTime> arrival_time, required_time;
+    std::vector<PortDomainPairData> pair_data;
     dict<ClockDomainKey, domain_id_t> domain_to_id;
     dict<ClockDomainPairKey, domain_id_t> pair_to_id;
     std::vector<PerDomain> domains;
     std::vector<PerDomainPair> domain_pairs;
     dict<std::pair<IdString, IdString>, delay_t> clock_delays;
 
-    std::vector<CellPortKey> topological_order;
+    std::vector<port_id_t> topological_order;
+    // start of each level in topological_order, with an extra entry for the end, if the graph could be levelised
+    std::vector<int> level_starts;
+    // Combinational arcs by the port at their far end, sorted topologically; pairs (port; index into its cell_arcs)
+    std::vector<int> comb_fanin_start, comb_fanout_start;
+    std::vector<std::pair<port_id_t, int>> comb_fanin, comb_fanout;
+
+    // input ports whose route delay changed since the last run
+    std::vector<port_id_t> changed_route_delays;
+    // whether the arrival/required times are valid for the current timing graph
+    bool have_times = false;
+    bool check_incremental = false;
 
     domain_id_t async_clock_id;
 
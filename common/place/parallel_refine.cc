@@ -36,13 +36,14 @@ namespace {
 
 struct GlobalState : DetailPlacerState
 {
-    explicit GlobalState(Context *ctx, ParallelRefineCfg cfg) : DetailPlacerState(ctx, this->cfg), cfg(cfg) {};
+    explicit GlobalState(Context *ctx, ParallelRefineCfg cfg)
+            : DetailPlacerState(ctx, this->cfg), cfg(cfg), temperature(cfg.start_temp), radius(cfg.start_radius) {};
 
     dict<ClusterId, std::vector<CellInfo *>> cluster2cells;
 
     ParallelRefineCfg cfg;
-    double temperature = 1e-7;
-    int radius = 3;
+    double temperature;
+    int radius;
     // ....
 };
 
@@ -437,13 +438,8 @@ struct ParallelRefine
         }
 
         NPNR_ASSERT(parts.size() == t.size());
-        // TODO: thread pool to make this worthwhile...
-        std::vector<std::thread> workers;
-        for (size_t i = 0; i < t.size(); i++) {
-            workers.emplace_back([i, this]() { t.at(i).set_partition(parts.at(i)); });
-        }
-        for (auto &w : workers)
-            w.join();
+        ctx->thread_pool().run("refine/partition", int(t.size()),
+                               [this](int i) { t.at(i).set_partition(parts.at(i)); });
     }
 
     void run()
@@ -463,10 +459,11 @@ struct ParallelRefine
         wirelen_t min_wirelen = g.total_wirelen;
         while (true) {
             if (iter > 1) {
-                if (g.total_wirelen >= min_wirelen) {
-                    done = true;
-                } else if (g.total_wirelen < min_wirelen) {
+                // Only stop on lack of progress once cooled, as uphill moves are still being accepted before that
+                if (g.total_wirelen < min_wirelen) {
                     min_wirelen = g.total_wirelen;
+                } else if (g.temperature <= 1e-7) {
+                    done = true;
                 }
                 int n_accept = 0, n_move = 0;
                 for (auto &t_data : t) {
@@ -497,12 +494,7 @@ struct ParallelRefine
 
             do_partition();
 
-            std::vector<std::thread> workers;
-            workers.reserve(t.size());
-            for (int j = 0; j < int(t.size()); j++)
-                workers.emplace_back([this, j]() { t.at(j).run_iter(); });
-            for (auto &w : workers)
-                w.join();
+            ctx->thread_pool().run("refine/iter", int(t.size()), [this](int j) { t.at(j).run_iter(); });
             g.tmg.run();
             g.update_global_costs();
             iter++;
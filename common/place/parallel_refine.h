@@ -32,6 +32,9 @@ struct ParallelRefineCfg : DetailPlaceCfg
     double lambda = 0.5f;
     int inner_iters = 15;
     int min_thread_size = 500;
+    // Starting temperature and move radius, which are raised when taking over from a placer that is still annealing
+    double start_temp = 1e-7;
+    int start_radius = 3;
 };
 
 bool parallel_refine(Context *ctx, ParallelRefineCfg cfg);
@@ -42,6 +42,7 @@
 #include <vector>
 #include "fast_bels.h"
 #include "log.h"
+#include "parallel_refine.h"
 #include "place_common.h"
 #include "timing.h"
 #include "util.h"
@@ -238,6 +239,7 @@ class SAPlacer
 
         // Invoke timing analysis to obtain criticalities
         tmg.setup_only = true;
+        tmg.incremental = true;
         tmg.setup();
 
         // Calculate costs after initial placement
@@ -369,6 +371,15 @@ class SAPlacer
                 require_legal = false;
             }
 
+            // Once moves are local, they can be evaluated in parallel over disjoint regions of the chip
+            if (!refine && cfg.parallelRefine && !require_legal && diameter <= handover_dia) {
+                log_info("  at iteration #%d: temp = %f, timing cost = "
+                         "%.0f, wirelen = %.0f, handing over to parallel refinement\n",
+                         iter, temp, double(curr_timing_cost), double(curr_wirelen_cost));
+                handed_over = true;
+                break;
+            }
+
             // Invoke timing analysis to obtain criticalities
             if (cfg.timing_driven)
                 tmg.run();
@@ -410,11 +421,17 @@ class SAPlacer
                 }
             }
         }
-        timing_analysis(ctx);
+        if (!handed_over)
+            timing_analysis(ctx);
 
         return true;
     }
 
+    // Set when place() stopped early for parallel_refine to finish annealing, with the state to continue from
+    bool handed_over = false;
+    float get_temp() const { return temp; }
+    int get_diameter() const { return diameter; }
+
   private:
     std::vector<BelId> all_bels;
     // Initial random placement
@@ -1140,26 +1157,59 @@ class SAPlacer
     // Simple routeability driven placement
     const int large_cell_thresh = 50;
     int total_net_share = 0;
-    std::vector<std::vector<dict<IdString, int>>> nets_by_tile;
+    // For each tile, x * (max_y + 1) + y, pairs of (net udata, number of ports of cells in the tile on that net). These
+    // are short, so a linear search beats hashing; entries are removed once their count reaches zero
+    typedef std::vector<std::pair<int32_t, int32_t>> TileNets;
+    std::vector<TileNets> nets_by_tile;
+
+    TileNets &tile_nets(Loc loc) { return nets_by_tile.at(loc.x * (max_y + 1) + loc.y); }
+
+    static TileNets::iterator find_tile_net(TileNets &tn, int32_t net)
+    {
+        return std::find_if(tn.begin(), tn.end(),
+                            [net](const std::pair<int32_t, int32_t> &e) { return e.first == net; });
+    }
+
+    // Add a port on a net to a tile, returning the number of ports already there
+    static int32_t add_tile_net(TileNets &tn, int32_t net)
+    {
+        auto found = find_tile_net(tn, net);
+        if (found == tn.end()) {
+            tn.emplace_back(net, 1);
+            return 0;
+        }
+        return found->second++;
+    }
+
+    // Remove a port on a net from a tile, returning the number of ports left
+    static int32_t remove_tile_net(TileNets &tn, int32_t net)
+    {
+        auto found = find_tile_net(tn, net);
+        NPNR_ASSERT(found != tn.end() && found->second > 0);
+        int32_t left = --found->second;
+        if (left == 0) {
+            *found = tn.back();
+            tn.pop_back();
+        }
+        return left;
+    }
+
     void setup_nets_by_tile()
     {
         total_net_share = 0;
-        nets_by_tile.resize(max_x + 1, std::vector<dict<IdString, int>>(max_y + 1));
+        nets_by_tile.assign((max_x + 1) * (max_y + 1), {});
         for (auto &cell : ctx->cells) {
             CellInfo *ci = cell.second.get();
             if (ci->isPseudo() || (int(ci->ports.size()) > large_cell_thresh))
                 continue;
-            Loc loc = ctx->getBelLocation(ci->bel);
-            auto &nbt = nets_by_tile.at(loc.x).at(loc.y);
+            auto &tn = tile_nets(ctx->getBelLocation(ci->bel));
             for (const auto &port : ci->ports) {
                 if (port.second.net == nullptr)
                     continue;
                 if (port.second.net->driver.cell == nullptr || ctx->getBelGlobalBuf(port.second.net->driver.cell->bel))
                     continue;
-                int &s = nbt[port.second.net->name];
-                if (s > 0)
+                if (add_tile_net(tn, port.second.net->udata) > 0)
                     ++total_net_share;
-                ++s;
             }
         }
     }
@@ -1169,23 +1219,18 @@ class SAPlacer
         if (int(ci->ports.size()) > large_cell_thresh)
             return 0;
         int loss = 0, gain = 0;
-        auto &nbt_old = nets_by_tile.at(old_loc.x).at(old_loc.y);
-        auto &nbt_new = nets_by_tile.at(new_loc.x).at(new_loc.y);
+        auto &tn_old = tile_nets(old_loc);
+        auto &tn_new = tile_nets(new_loc);
 
         for (const auto &port : ci->ports) {
             if (port.second.net == nullptr)
                 continue;
             if (port.second.net->driver.cell == nullptr || ctx->getBelGlobalBuf(port.second.net->driver.cell->bel))
                 continue;
-            int &o = nbt_old[port.second.net->name];
-            --o;
-            NPNR_ASSERT(o >= 0);
-            if (o > 0)
+            if (remove_tile_net(tn_old, port.second.net->udata) > 0)
                 ++loss;
-            int &n = nbt_new[port.second.net->name];
-            if (n > 0)
+            if (add_tile_net(tn_new, port.second.net->udata) > 0)
                 ++gain;
-            ++n;
         }
         int delta = gain - loss;
         total_net_share += delta;
@@ -1225,6 +1270,7 @@ class SAPlacer
     std::vector<decltype(NetInfo::udata)> old_udata;
     bool require_legal = true;
     const int legalise_dia = 4;
+    const int handover_dia = 3;
     Placer1Cfg cfg;
 
     TimingAnalyser tmg;
@@ -1240,13 +1286,35 @@ Placer1Cfg::Placer1Cfg(Context *ctx)
     timing_driven = ctx->setting<bool>("timing_driven");
     hpwl_scale_x = 1;
     hpwl_scale_y = 1;
+#if !defined(NPNR_DISABLE_THREADS)
+    parallelRefine = ctx->setting<bool>("placer1/parallelRefine", false);
+#else
+    parallelRefine = false;
+#endif
 }
 
 bool placer1(Context *ctx, Placer1Cfg cfg)
 {
     try {
-        SAPlacer placer(ctx, cfg);
-        placer.place();
+        bool handed_over;
+        double temp;
+        int diameter;
+        {
+            SAPlacer placer(ctx, cfg);
+            placer.place();
+            handed_over = placer.handed_over;
+            temp = placer.get_temp();
+            diameter = placer.get_diameter();
+        }
+        if (handed_over) {
+            ParallelRefineCfg refine_cfg(ctx);
+            refine_cfg.hpwl_scale_x = cfg.hpwl_scale_x;
+            refine_cfg.hpwl_scale_y = cfg.hpwl_scale_y;
+            refine_cfg.start_temp = std::max(temp, 1e-7);
+            refine_cfg.start_radius = diameter;
+            if (!parallel_refine(ctx, refine_cfg))
+                return false;
+        }
         log_info("Checksum: 0x%08x\n", ctx->checksum());
 #ifndef NDEBUG
         ctx->lock();
@@ -1267,8 +1335,16 @@ bool placer1(Context *ctx, Placer1Cfg cfg)
 bool placer1_refine(Context *ctx, Placer1Cfg cfg)
 {
     try {
-        SAPlacer placer(ctx, cfg);
-        placer.place(true);
+        if (cfg.parallelRefine) {
+            ParallelRefineCfg refine_cfg(ctx);
+            refine_cfg.hpwl_scale_x = cfg.hpwl_scale_x;
+            refine_cfg.hpwl_scale_y = cfg.hpwl_scale_y;
+            if (!parallel_refine(ctx, refine_cfg))
+                return false;
+        } else {
+            SAPlacer placer(ctx, cfg);
+            placer.place(true);
+        }
         log_info("Checksum: 0x%08x\n", ctx->checksum());
 #ifndef NDEBUG
         ctx->lock();
@@ -33,6 +33,8 @@ struct Placer1Cfg
     int timingFanoutThresh;
     bool timing_driven;
     int hpwl_scale_x, hpwl_scale_y;
+    // Hand the low-temperature part of annealing over to the threaded parallel_refine engine
+    bool parallelRefine;
 };
 
 extern bool placer1(Context *ctx, Placer1Cfg cfg);
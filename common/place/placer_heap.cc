@@ -34,6 +34,7 @@
 #include "placer_heap.h"
 #include <Eigen/Core>
 #include <Eigen/IterativeLinearSolvers>
+#include <Eigen/SparseCholesky>
 #include <boost/optional.hpp>
 #include <chrono>
 #include <deque>
@@ -61,71 +62,111 @@ namespace {
 template <typename T> struct EquationSystem
 {
 
-    EquationSystem(size_t rows, size_t cols)
-    {
-        A.resize(cols);
-        rhs.resize(rows);
-    }
+    EquationSystem(size_t rows, size_t cols, const PlacerHeapCfg &cfg) : cols(cols), cfg(cfg) { rhs.resize(rows); }
 
-    // Simple sparse format, easy to convert to CCS for solver
-    std::vector<std::vector<std::pair<int, T>>> A; // col -> (row, x[row, col]) sorted by row
-    std::vector<T> rhs;                            // RHS vector
+    size_t cols;
+    const PlacerHeapCfg &cfg;
+
+    // Coefficients are batched up as triplets, and summed when the matrix is assembled in compressed form
+    std::vector<Eigen::Triplet<T>> A;
+    std::vector<T> rhs; // RHS vector
     void reset()
     {
-        for (auto &col : A)
-            col.clear();
+        A.clear();
         std::fill(rhs.begin(), rhs.end(), T());
     }
 
-    void add_coeff(int row, int col, T val)
+    void add_coeff(int row, int col, T val) { A.emplace_back(row, col, val); }
+
+    void add_rhs(int row, T val) { rhs[row] += val; }
+
+    // The assembled matrix and solvers persist across solves of the same system, so that the symbolic analysis
+    // (ordering for the incomplete Cholesky preconditioner or direct solver) is only redone if the sparsity pattern
+    // changes between iterations
+    typedef Eigen::SparseMatrix<T, Eigen::RowMajor> Matrix;
+    Matrix mat;
+    std::vector<typename Matrix::StorageIndex> last_outer, last_inner;
+    int pattern_version = 0;
+
+    template <typename Tprecond> struct CGSolver
     {
-        auto &Ac = A.at(col);
-        // Binary search
-        int b = 0, e = int(Ac.size()) - 1;
-        while (b <= e) {
-            int i = (b + e) / 2;
-            if (Ac.at(i).first == row) {
-                Ac.at(i).second += val;
-                return;
-            }
-            if (Ac.at(i).first > row)
-                e = i - 1;
-            else
-                b = i + 1;
-        }
-        Ac.insert(Ac.begin() + b, std::make_pair(row, val));
+        Eigen::ConjugateGradient<Matrix, Eigen::Lower | Eigen::Upper, Tprecond> solver;
+        int analysed_version = -1;
+    };
+    CGSolver<Eigen::DiagonalPreconditioner<T>> cg_jacobi;
+    CGSolver<Eigen::IncompleteCholesky<T>> cg_ichol;
+    CGSolver<Eigen::IdentityPreconditioner> cg_none;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<T>> ldlt;
+    int ldlt_analysed_version = -1;
+
+    void assemble()
+    {
+        mat.resize(cols, cols);
+        mat.setFromTriplets(A.begin(), A.end());
+        int nnz = int(mat.nonZeros());
+        if (int(last_outer.size()) == int(cols) + 1 && int(last_inner.size()) == nnz &&
+            std::equal(last_outer.begin(), last_outer.end(), mat.outerIndexPtr()) &&
+            std::equal(last_inner.begin(), last_inner.end(), mat.innerIndexPtr()))
+            return;
+        last_outer.assign(mat.outerIndexPtr(), mat.outerIndexPtr() + cols + 1);
+        last_inner.assign(mat.innerIndexPtr(), mat.innerIndexPtr() + nnz);
+        ++pattern_version;
     }
 
-    void add_rhs(int row, T val) { rhs[row] += val; }
+    template <typename Tsolver>
+    Eigen::VectorXd solve_cg(Tsolver &cg, const Eigen::VectorXd &vb, const Eigen::VectorXd &vx, float tolerance)
+    {
+        cg.solver.setTolerance(tolerance);
+        if (cg.analysed_version != pattern_version) {
+            cg.solver.analyzePattern(mat);
+            cg.analysed_version = pattern_version;
+        }
+        cg.solver.factorize(mat);
+        return cg.solver.solveWithGuess(vb, vx);
+    }
 
     void solve(std::vector<T> &x, float tolerance)
     {
         using namespace Eigen;
         if (x.empty())
             return;
-        NPNR_ASSERT(x.size() == A.size());
+        NPNR_ASSERT(x.size() == cols);
 
         VectorXd vx(x.size()), vb(rhs.size());
-        SparseMatrix<T> mat(A.size(), A.size());
-
-        std::vector<int> colnnz;
-        for (auto &Ac : A)
-            colnnz.push_back(int(Ac.size()));
-        mat.reserve(colnnz);
-        for (int col = 0; col < int(A.size()); col++) {
-            auto &Ac = A.at(col);
-            for (auto &el : Ac)
-                mat.insert(el.first, col) = el.second;
-        }
+        assemble();
 
         for (int i = 0; i < int(x.size()); i++)
             vx[i] = x.at(i);
         for (int i = 0; i < int(rhs.size()); i++)
             vb[i] = rhs.at(i);
 
-        ConjugateGradient<SparseMatrix<T>, Lower | Upper> solver;
-        solver.setTolerance(tolerance);
-        VectorXd xr = solver.compute(mat).solveWithGuess(vb, vx);
+        VectorXd xr;
+        bool solved = false;
+        if (cfg.solver == PlacerHeapCfg::SolverBackend::LDLT) {
+            if (ldlt_analysed_version != pattern_version) {
+                ldlt.analyzePattern(mat);
+                ldlt_analysed_version = pattern_version;
+            }
+            ldlt.factorize(mat);
+            // Without any fixed cells the system is singular, fall back to CG which can still make progress
+            if (ldlt.info() == Success) {
+                xr = ldlt.solve(vb);
+                solved = true;
+            }
+        }
+        if (!solved) {
+            switch (cfg.preconditioner) {
+            case PlacerHeapCfg::Preconditioner::IncompleteCholesky:
+                xr = solve_cg(cg_ichol, vb, vx, tolerance);
+                break;
+            case PlacerHeapCfg::Preconditioner::None:
+                xr = solve_cg(cg_none, vb, vx, tolerance);
+                break;
+            default:
+                xr = solve_cg(cg_jacobi, vb, vx, tolerance);
+                break;
+            }
+        }
         for (int i = 0; i < int(x.size()); i++)
             x.at(i) = xr[i];
         // for (int i = 0; i < int(x.size()); i++)
@@ -189,14 +230,7 @@ class HeAPPlacer
         for (int i = 0; i < 4; i++) {
             setup_solve_cells();
             auto solve_startt = std::chrono::high_resolution_clock::now();
-#ifdef NPNR_DISABLE_THREADS
-            build_solve_direction(false, -1);
-            build_solve_direction(true, -1);
-#else
-            boost::thread xaxis([&]() { build_solve_direction(false, -1); });
-            build_solve_direction(true, -1);
-            xaxis.join();
-#endif
+            ctx->thread_pool().run("heap/solve", 2, [&](int axis) { build_solve_direction(axis == 1, -1); });
             auto solve_endt = std::chrono::high_resolution_clock::now();
             solve_time += std::chrono::duration<double>(solve_endt - solve_startt).count();
 
@@ -259,14 +293,11 @@ class HeAPPlacer
                 auto solve_startt = std::chrono::high_resolution_clock::now();
 
                 // Build the connectivity matrix and run the solver; multithreaded between x and y axes if applicable
-#ifndef NPNR_DISABLE_THREADS
                 if (solve_cells.size() >= 500) {
-                    boost::thread xaxis([&]() { build_solve_direction(false, (iter == 0) ? -1 : iter); });
-                    build_solve_direction(true, (iter == 0) ? -1 : iter);
-                    xaxis.join();
-                } else
-#endif
-                {
+                    ctx->thread_pool().run("heap/solve", 2, [&](int axis) {
+                        build_solve_direction(axis == 1, (iter == 0) ? -1 : iter);
+                    });
+                } else {
                     build_solve_direction(false, (iter == 0) ? -1 : iter);
                     build_solve_direction(true, (iter == 0) ? -1 : iter);
                 }
@@ -700,8 +731,8 @@ class HeAPPlacer
     // Build and solve in one direction
     void build_solve_direction(bool yaxis, int iter)
     {
+        EquationSystem<double> esx(solve_cells.size(), solve_cells.size(), cfg);
         for (int i = 0; i < 5; i++) {
-            EquationSystem<double> esx(solve_cells.size(), solve_cells.size());
             build_equations(esx, yaxis, iter);
             solve_equations(esx, yaxis);
         }
@@ -2169,6 +2200,24 @@ PlacerHeapCfg::PlacerHeapCfg(Context *ctx)
     netShareWeight = ctx->setting<float>("placerHeap/netShareWeight", 0);
     disableCtrlSet = ctx->setting<bool>("placerHeap/noCtrlSet", false);
 
+    std::string solver_name = str_or_default(ctx->settings, ctx->id("placerHeap/solver"), "cg");
+    if (solver_name == "cg")
+        solver = SolverBackend::ConjugateGradient;
+    else if (solver_name == "ldlt")
+        solver = SolverBackend::LDLT;
+    else
+        log_error("Unknown placer heap solver '%s', expected 'cg' or 'ldlt'\n", solver_name.c_str());
+    std::string precond_name = str_or_default(ctx->settings, ctx->id("placerHeap/preconditioner"), "jacobi");
+    if (precond_name == "jacobi")
+        preconditioner = Preconditioner::Jacobi;
+    else if (precond_name == "ichol")
+        preconditioner = Preconditioner::IncompleteCholesky;
+    else if (precond_name == "none")
+        preconditioner = Preconditioner::None;
+    else
+        log_error("Unknown placer heap preconditioner '%s', expected 'jacobi', 'ichol' or 'none'\n",
+                  precond_name.c_str());
+
     timing_driven = ctx->setting<bool>("timing_driven");
     solverTolerance = 1e-5;
     placeAllAtOnce = false;
@@ -42,6 +42,21 @@ struct PlacerHeapCfg
     float timingWeight;
     bool timing_driven;
     float solverTolerance;
+
+    // Engine used to solve the system of equations each iteration. The direct solver falls back to conjugate gradient
+    // if the system is singular.
+    enum class SolverBackend
+    {
+        ConjugateGradient,
+        LDLT,
+    } solver;
+    // Preconditioner for the conjugate gradient solver
+    enum class Preconditioner
+    {
+        Jacobi,
+        IncompleteCholesky,
+        None,
+    } preconditioner;
     bool placeAllAtOnce;
     float netShareWeight;
     bool parallelRefine;
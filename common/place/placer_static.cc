@@ -20,6 +20,7 @@
 #include "placer_static.h"
 #include "static_util.h"
 
+#include <array>
 #include <boost/optional.hpp>
 #include <chrono>
 #include <deque>
@@ -34,19 +35,11 @@
 #include "parallel_refine.h"
 #include "place_common.h"
 #include "placer1.h"
+#include "static_fft.h"
+#include "static_kernels.h"
 #include "timing.h"
 #include "util.h"
 
-#include "fftsg.h"
-
-#ifndef NPNR_DISABLE_THREADS
-#include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <thread>
-
-#endif
-
 NEXTPNR_NAMESPACE_BEGIN
 
 using namespace StaticUtil;
@@ -126,16 +119,25 @@ struct PlacerBin
     // ...
 };
 
-struct PlacerPort
+// Per-port wirelength model state for all nets, one contiguous range per net and one array per axis so the
+// exponent and gradient kernels can stream over it
+struct PlacerPorts
 {
-    // for wirelength data
-    static constexpr float invalid = std::numeric_limits<float>::lowest();
-
-    PortRef ref;
-    RealPair max_exp{invalid, invalid};
-    RealPair min_exp{invalid, invalid};
-    bool has_max_exp(Axis axis) const { return max_exp.at(axis) != invalid; }
-    bool has_min_exp(Axis axis) const { return min_exp.at(axis) != invalid; }
+    std::vector<CellInfo *> cells;
+    std::array<std::vector<float>, 2> loc;
+    std::array<std::vector<float>, 2> min_exp, max_exp;
+    std::array<std::vector<float>, 2> grad; // d(wirelength)/d(loc)
+
+    void resize(size_t size)
+    {
+        cells.resize(size);
+        for (int axis = 0; axis < 2; axis++) {
+            loc.at(axis).resize(size);
+            min_exp.at(axis).resize(size);
+            max_exp.at(axis).resize(size);
+            grad.at(axis).resize(size);
+        }
+    }
 };
 
 struct PlacerNet
@@ -146,98 +148,13 @@ struct PlacerNet
     RealPair min_exp, x_min_exp;
     RealPair max_exp, x_max_exp;
     RealPair wa_wl;
-    // lines up with user indexes; plus one for driver
-    std::vector<PlacerPort> ports;
+    // range of this net in PlacerPorts
+    int32_t port_begin = 0, port_count = 0;
+    // lines up with user indexes; plus one for driver. Index into PlacerPorts, or -1 for removed users
+    std::vector<int32_t> port_idx;
     int hpwl() { return (b1.x - b0.x) + (b1.y - b0.y); }
 };
 
-#ifdef NPNR_DISABLE_THREADS
-struct ThreadPool
-{
-    ThreadPool(int) {};
-
-    void run(int N, std::function<void(int)> func)
-    {
-        for (int i = 0; i < N; i++)
-            func(i);
-    };
-};
-#else
-struct ThreadPool
-{
-    ThreadPool(int thread_count)
-    {
-        done.resize(thread_count, false);
-        for (int i = 0; i < thread_count; i++) {
-            threads.emplace_back([this, i]() { this->worker(i); });
-        }
-    }
-    std::vector<std::thread> threads;
-    std::condition_variable cv_start, cv_done;
-    std::mutex mutex;
-
-    bool work_available = false;
-    bool shutdown = false;
-    std::vector<bool> done;
-    std::function<void(int)> work;
-    int work_count;
-
-    ~ThreadPool()
-    {
-        {
-            std::lock_guard lk(mutex);
-            shutdown = true;
-        }
-        cv_start.notify_all();
-        for (auto &t : threads)
-            t.join();
-    }
-
-    void run(int N, std::function<void(int)> func)
-    {
-        {
-            std::lock_guard lk(mutex);
-            work = func;
-            work_count = N;
-            work_available = true;
-            std::fill(done.begin(), done.end(), false);
-        }
-        cv_start.notify_all();
-        {
-            std::unique_lock lk(mutex);
-            cv_done.wait(lk, [this] { return std::all_of(done.begin(), done.end(), [](bool x) { return x; }); });
-            work_available = false;
-        }
-    }
-
-    void worker(int idx)
-    {
-        while (true) {
-            std::unique_lock lk(mutex);
-            cv_start.wait(lk, [this, idx] { return (work_available && !done.at(idx)) || shutdown; });
-            if (shutdown) {
-                lk.unlock();
-                break;
-            } else if (work_available && !done.at(idx)) {
-                int work_per_thread = (work_count + int(threads.size()) - 1) / threads.size();
-                int begin = work_per_thread * idx;
-                int end = std::min(work_count, work_per_thread * (idx + 1));
-                lk.unlock();
-
-                for (int j = begin; j < end; j++) {
-                    work(j);
-                }
-
-                lk.lock();
-                done.at(idx) = true;
-                lk.unlock();
-                cv_done.notify_one();
-            }
-        }
-    }
-};
-#endif
-
 class StaticPlacer
 {
     Context *ctx;
@@ -248,11 +165,11 @@ class StaticPlacer
     std::vector<PlacerMacro> macros;
     std::vector<PlacerGroup> groups;
     std::vector<PlacerNet> nets;
+    PlacerPorts ports;
     idict<ClusterId> cluster2idx;
 
     FastBels fast_bels;
     TimingAnalyser tmg;
-    ThreadPool pool;
 
     int width, height;
     int iter = 0;
@@ -343,12 +260,19 @@ class StaticPlacer
             auto &nd = nets.back();
             nd.ni = ni;
             nd.skip = (ni->driver.cell == nullptr || cfg.glbBufTypes.count(ni->driver.cell->type));
-            nd.ports.resize(ni->users.capacity() + 1); // +1 for the driver
-            nd.ports.back().ref = ni->driver;
+            nd.port_idx.resize(ni->users.capacity() + 1, -1); // +1 for the driver
+            nd.port_begin = ports.cells.size();
             for (auto usr : ni->users.enumerate()) {
-                nd.ports.at(usr.index.idx()).ref = usr.value;
+                nd.port_idx.at(usr.index.idx()) = ports.cells.size();
+                ports.cells.push_back(usr.value.cell);
             }
+            if (ni->driver.cell) {
+                nd.port_idx.back() = ports.cells.size();
+                ports.cells.push_back(ni->driver.cell);
+            }
+            nd.port_count = ports.cells.size() - nd.port_begin;
         }
+        ports.resize(ports.cells.size());
     }
 
     int add_cell(StaticRect rect, int group, RealPair pos, CellInfo *ci = nullptr)
@@ -567,30 +491,29 @@ class StaticPlacer
     }
 
     // TODO: dark node insertion when we have obstructions or non-rectangular placement regions
-    int m;
+    int mx, my; // bin grid dimensions
     double bin_w, bin_h;
 
-    std::vector<float> cs_table_fft;
-    std::vector<int> work_area_fft;
+    // twiddle factors for the DCTs along each axis, built once
+    StaticFFT::DCTPlan dct_x, dct_y;
 
     void prepare_density_bins()
     {
-        // TODO: a m x m grid follows the paper and makes the DCTs easier, but is it actually ideal for non-square
-        // FPGAs?
-        m = 1 << int(std::ceil(std::log2(std::max(width, height))));
-        bin_w = double(width) / m;
-        bin_h = double(height) / m;
+        // One bin per tile where possible; rounding up to a size the FFT handles efficiently
+        mx = StaticFFT::fft_size(width);
+        my = StaticFFT::fft_size(height);
+        bin_w = double(width) / mx;
+        bin_h = double(height) / my;
 
         for (auto &g : groups) {
-            g.density.reset(m, m, 0);
-            g.density_fft.reset(m, m, 0);
-            g.electro_phi.reset(m, m, 0);
-            g.electro_fx.reset(m, m, 0);
-            g.electro_fy.reset(m, m, 0);
+            g.density.reset(mx, my, 0);
+            g.density_fft.reset(mx, my, 0);
+            g.electro_phi.reset(mx, my, 0);
+            g.electro_fx.reset(mx, my, 0);
+            g.electro_fy.reset(mx, my, 0);
         }
-        cs_table_fft.resize(m * 3 / 2, 0);
-        work_area_fft.resize(std::round(std::sqrt(m)) + 2, 0);
-        work_area_fft.at(0) = 0;
+        dct_x = StaticFFT::DCTPlan(mx);
+        dct_y = StaticFFT::DCTPlan(my);
     }
 
     template <typename TFunc> void iter_slithers(RealPair pos, StaticRect rect, TFunc func)
@@ -612,7 +535,7 @@ class StaticPlacer
         double y0 = pos.y, y1 = pos.y + height;
         for (int y = int(y0 / bin_h); y <= int(y1 / bin_h); y++) {
             for (int x = int(x0 / bin_w); x <= int(x1 / bin_w); x++) {
-                if (x < 0 || x >= m || y < 0 || y >= m)
+                if (x < 0 || x >= mx || y < 0 || y >= my)
                     continue;
                 double slither_w = 1.0, slither_h = 1.0;
                 if (y == int(y0 / bin_h)) // y slithers
@@ -693,8 +616,42 @@ class StaticPlacer
         log_info("overlap: %s\n", overlap_str.c_str());
     }
 
+    // Apply a 1D transform along each axis of a bin grid; splitting the lines across the thread pool and transforming
+    // them in pairs
+    void dct2d(FFTArray &a, StaticFFT::Transform kind_x, StaticFFT::Transform kind_y)
+    {
+        float **data = a.data();
+        // Lines along y are contiguous
+        ctx->thread_pool().run_ranges("static/dct_y", (mx + 1) / 2, 4, [&](int begin, int end) {
+            std::vector<std::complex<float>> work;
+            for (int i = begin; i < end; i++) {
+                int x = 2 * i;
+                dct_y.run(kind_y, data[x], (x + 1 < mx) ? data[x + 1] : nullptr, work);
+            }
+        });
+        // Lines along x are gathered into a buffer, in blocks of rows to make better use of cache lines
+        const int block = 16;
+        ctx->thread_pool().run_ranges("static/dct_x", (my + block - 1) / block, 1, [&](int begin, int end) {
+            std::vector<std::complex<float>> work;
+            std::vector<float> lines(block * mx);
+            for (int b = begin; b < end; b++) {
+                int y0 = b * block, y1 = std::min(y0 + block, my);
+                for (int x = 0; x < mx; x++)
+                    for (int y = y0; y < y1; y++)
+                        lines[(y - y0) * mx + x] = data[x][y];
+                for (int y = y0; y < y1; y += 2)
+                    dct_x.run(kind_x, &lines[(y - y0) * mx], (y + 1 < y1) ? &lines[(y + 1 - y0) * mx] : nullptr,
+                              work);
+                for (int x = 0; x < mx; x++)
+                    for (int y = y0; y < y1; y++)
+                        data[x][y] = lines[(y - y0) * mx + x];
+            }
+        });
+    }
+
     void run_fft(int group)
     {
+        using StaticFFT::Transform;
         // get data into form that fft wants
         auto &g = groups.at(group);
         for (auto entry : g.density)
@@ -704,21 +661,21 @@ class StaticPlacer
         // Based on
         // https://github.com/ALIGN-analoglayout/ALIGN-public/blob/master/PlaceRouteHierFlow/EA_placer/FFT/fft.cpp
         // initial DCT for coefficients
-        ddct2d(m, m, -1, g.density_fft.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
+        dct2d(g.density_fft, Transform::DCT2, Transform::DCT2);
         // postprocess coefficients
-        for (int x = 0; x < m; x++)
+        for (int x = 0; x < mx; x++)
             g.density_fft.at(x, 0) *= 0.5f;
-        for (int y = 0; y < m; y++)
+        for (int y = 0; y < my; y++)
             g.density_fft.at(0, y) *= 0.5f;
-        for (int x = 0; x < m; x++)
-            for (int y = 0; y < m; y++)
-                g.density_fft.at(x, y) *= (4.0f / (m * m));
+        for (int x = 0; x < mx; x++)
+            for (int y = 0; y < my; y++)
+                g.density_fft.at(x, y) *= (4.0f / (mx * my));
         // scale inputs to IDCT for potentials and field
-        for (int x = 0; x < m; x++) {
-            float wx = pi * (x / float(m));
+        parallel_for("static/potential", mx, 16, [&](int x) {
+            float wx = pi * (x / float(mx));
             float wx2 = wx * wx;
-            for (int y = 0; y < m; y++) {
-                float wy = pi * (y / float(m));
+            for (int y = 0; y < my; y++) {
+                float wy = pi * (y / float(my));
                 float wy2 = wy * wy;
 
                 float dens = g.density_fft.at(x, y);
@@ -734,11 +691,11 @@ class StaticPlacer
                 g.electro_fx.at(x, y) = ex;
                 g.electro_fy.at(x, y) = ey;
             }
-        }
+        });
         // IDCT for potential; 2D derivatives for field
-        ddct2d(m, m, 1, g.electro_phi.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
-        ddsct2d(m, m, 1, g.electro_fx.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
-        ddcst2d(m, m, 1, g.electro_fy.data(), nullptr, work_area_fft.data(), cs_table_fft.data());
+        dct2d(g.electro_phi, Transform::DCT3, Transform::DCT3);
+        dct2d(g.electro_fx, Transform::DST3, Transform::DCT3);
+        dct2d(g.electro_fy, Transform::DCT3, Transform::DST3);
         if (fft_debug) {
             g.electro_phi.write_csv(stringf("out_bin_phi_%d_%d.csv", iter, group));
             g.electro_fx.write_csv(stringf("out_bin_ex_%d_%d.csv", iter, group));
@@ -760,61 +717,60 @@ class StaticPlacer
         }
     }
 
+    // Run func(i) for i in [0, N) on the shared thread pool, in chunks of at least min_chunk
+    void parallel_for(const char *name, int N, int min_chunk, std::function<void(int)> func)
+    {
+        ctx->thread_pool().run_ranges(name, N, min_chunk, [&](int begin, int end) {
+            for (int i = begin; i < end; i++)
+                func(i);
+        });
+    }
+
     RealPair wl_coeff{0.5f, 0.5f};
 
     void update_nets(bool ref)
     {
-        static constexpr float min_wirelen_force = -3000.f;
-        pool.run(2 * nets.size(), [&](int i) {
+        parallel_for("static/update_nets", 2 * nets.size(), 64, [&](int i) {
             auto &net = nets.at(i / 2);
             auto axis = (i % 2) ? Axis::Y : Axis::X;
             if (net.skip)
                 return;
-            net.min_exp.at(axis) = 0;
-            net.x_min_exp.at(axis) = 0;
-            net.max_exp.at(axis) = 0;
-            net.x_max_exp.at(axis) = 0;
-            // update bounding box
-            compute_bounds(net, axis, ref);
-            // compute rough center to subtract from exponents to avoid FP issues (from replace)
-            float c = (net.b1.at(axis) + net.b0.at(axis)) / 2.f;
-            for (auto &port : net.ports) {
-                if (!port.ref.cell)
-                    continue;
-                RealPair loc = cell_loc(port.ref.cell, ref);
-                // update weighted-average model exponents
-                float emin = (c - loc.at(axis)) * wl_coeff.at(axis);
-                float emax = (loc.at(axis) - c) * wl_coeff.at(axis);
-
-                if (emin > min_wirelen_force) {
-                    port.min_exp.at(axis) = std::exp(emin);
-                    net.min_exp.at(axis) += port.min_exp.at(axis);
-                    net.x_min_exp.at(axis) += loc.at(axis) * port.min_exp.at(axis);
-                } else {
-                    port.min_exp.at(axis) = PlacerPort::invalid;
-                }
-                if (emax > min_wirelen_force) {
-                    port.max_exp.at(axis) = std::exp(emax);
-                    net.max_exp.at(axis) += port.max_exp.at(axis);
-                    net.x_max_exp.at(axis) += loc.at(axis) * port.max_exp.at(axis);
-                    NPNR_ASSERT(std::isfinite(net.x_max_exp.at(axis)));
-                } else {
-                    port.max_exp.at(axis) = PlacerPort::invalid;
-                }
+            int a = int(axis);
+            float *loc = ports.loc.at(a).data() + net.port_begin;
+            float *min_exp = ports.min_exp.at(a).data() + net.port_begin;
+            float *max_exp = ports.max_exp.at(a).data() + net.port_begin;
+            CellInfo *const *cells = ports.cells.data() + net.port_begin;
+            // gather port locations and update bounding box
+            float b0 = std::numeric_limits<float>::max(), b1 = std::numeric_limits<float>::lowest();
+            for (int j = 0; j < net.port_count; j++) {
+                loc[j] = cell_loc(cells[j], ref).at(axis);
+                b0 = std::min(b0, loc[j]);
+                b1 = std::max(b1, loc[j]);
             }
-            net.wa_wl.at(axis) =
-                    (net.x_max_exp.at(axis) / net.max_exp.at(axis)) - (net.x_min_exp.at(axis) / net.min_exp.at(axis));
+            net.b0.at(axis) = b0;
+            net.b1.at(axis) = b1;
+            // compute rough center to subtract from exponents to avoid FP issues (from replace)
+            float c = (b1 + b0) / 2.f;
+            // update weighted-average model exponents, and their gradients
+            auto sums = StaticKernels::wa_exp(loc, min_exp, max_exp, net.port_count, c, wl_coeff.at(axis));
+            NPNR_ASSERT(std::isfinite(sums.x_max_exp));
+            net.min_exp.at(axis) = sums.min_exp;
+            net.x_min_exp.at(axis) = sums.x_min_exp;
+            net.max_exp.at(axis) = sums.max_exp;
+            net.x_max_exp.at(axis) = sums.x_max_exp;
+            net.wa_wl.at(axis) = (sums.x_max_exp / sums.max_exp) - (sums.x_min_exp / sums.min_exp);
+            StaticKernels::wa_grad(loc, min_exp, max_exp, ports.grad.at(a).data() + net.port_begin, net.port_count,
+                                   wl_coeff.at(axis), sums);
         });
     }
 
     std::vector<std::pair<CellInfo *, RealPair>> gathered_wirelen_grad;
 
-    float wirelen_grad(CellInfo *cell, Axis axis, bool ref)
+    float wirelen_grad(CellInfo *cell, Axis axis)
     {
         float gradient = 0;
         if (cell->udata == -1)
             return 0;
-        RealPair loc = cell_loc(cell, ref);
         for (auto &port : cell->ports) {
             NetInfo *ni = port.second.net;
             if (!ni)
@@ -822,24 +778,9 @@ class StaticPlacer
             auto &nd = nets.at(ni->udata);
             if (nd.skip)
                 continue;
-            auto &pd = nd.ports.at(port.second.type == PORT_OUT ? (nd.ports.size() - 1) : port.second.user_idx.idx());
-            // From Replace
-            // TODO: check these derivatives on paper
-            double d_min = 0, d_max = 0;
-            if (pd.has_min_exp(axis)) {
-                double min_sum = nd.min_exp.at(axis), x_min_sum = nd.x_min_exp.at(axis);
-                d_min = (min_sum * (pd.min_exp.at(axis) * (1.0f - wl_coeff.at(axis) * loc.at(axis))) +
-                         wl_coeff.at(axis) * pd.min_exp.at(axis) * x_min_sum) /
-                        (min_sum * min_sum);
-                NPNR_ASSERT(std::isfinite(d_min));
-            }
-            if (pd.has_max_exp(axis)) {
-                double max_sum = nd.max_exp.at(axis), x_max_sum = nd.x_max_exp.at(axis);
-                d_max = (max_sum * (pd.max_exp.at(axis) * (1.0f + wl_coeff.at(axis) * loc.at(axis))) -
-                         wl_coeff.at(axis) * pd.max_exp.at(axis) * x_max_sum) /
-                        (max_sum * max_sum);
-                NPNR_ASSERT(std::isfinite(d_max));
-            }
+            int pi = nd.port_idx.at(port.second.type == PORT_OUT ? (nd.port_idx.size() - 1)
+                                                                  : port.second.user_idx.idx());
+            float d = ports.grad.at(int(axis)).at(pi);
             float crit = 0.0;
             if (cfg.timing_driven) {
                 if (port.second.type == PORT_IN) {
@@ -852,7 +793,7 @@ class StaticPlacer
                 }
             }
             float weight = 1.0 + 5 * std::pow(crit, 2);
-            gradient += weight * (d_min - d_max);
+            gradient += weight * d;
         }
 
         NPNR_ASSERT(std::isfinite(gradient));
@@ -865,7 +806,7 @@ class StaticPlacer
     void update_gradients(bool ref = true, bool set_prev = true, bool init_penalty = false)
     {
         // TODO: skip non-group cells more efficiently?
-        pool.run(groups.size(), [&](int group) {
+        parallel_for("static/density", groups.size(), 1, [&](int group) {
             compute_density(group, ref);
             run_fft(group);
         });
@@ -898,11 +839,11 @@ class StaticPlacer
             }
         }
         // Compute wirelength gradients for cells in parallel, this is a slow part
-        pool.run(gathered_wirelen_grad.size(), [&](int i) {
+        parallel_for("static/wirelen_grad", gathered_wirelen_grad.size(), 64, [&](int i) {
             auto &entry = gathered_wirelen_grad.at(i);
             CellInfo *ci = entry.first;
-            float wl_gx = wirelen_grad(ci, Axis::X, ref);
-            float wl_gy = wirelen_grad(ci, Axis::Y, ref);
+            float wl_gx = wirelen_grad(ci, Axis::X);
+            float wl_gy = wirelen_grad(ci, Axis::Y);
             entry.second = RealPair(wl_gx, wl_gy);
         });
         // Second loop: sum up wirelength gradients across concrete cell instances
@@ -1470,7 +1411,7 @@ class StaticPlacer
 
   public:
     StaticPlacer(Context *ctx, PlacerStaticCfg cfg)
-            : ctx(ctx), cfg(cfg), fast_bels(ctx, true, 8), tmg(ctx), pool(ctx->setting<int>("threads", 8))
+            : ctx(ctx), cfg(cfg), fast_bels(ctx, true, 8), tmg(ctx)
     {
         groups.resize(cfg.cell_groups.size());
         tmg.setup_only = true;
@@ -1480,6 +1421,8 @@ class StaticPlacer
     void place()
     {
         log_info("Running Static placer...\n");
+        if (ctx->verbose)
+            log_info("⌁ using %s wirelength kernels\n", StaticKernels::isa_name());
         init_bels();
         prepare_cells();
         init_cells();
@@ -0,0 +1,241 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "static_fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include "nextpnr_assertions.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace StaticFFT {
+
+int fft_size(int min_size)
+{
+    for (int n = std::max(min_size, 1);; n++) {
+        int r = n;
+        for (int p : {2, 3, 5})
+            while (r % p == 0)
+                r /= p;
+        if (r == 1)
+            return n;
+    }
+}
+
+DCTPlan::DCTPlan(int n) : n(n)
+{
+    if (n <= 1)
+        return;
+    // Factorise as in kissfft: radix 4 first, then 2, then odd factors
+    int rem = n, p = 4;
+    while (rem > 1) {
+        while (rem % p != 0) {
+            if (p == 4)
+                p = 2;
+            else if (p == 2)
+                p = 3;
+            else
+                p += 2;
+            if (p * p > rem)
+                p = rem;
+        }
+        rem /= p;
+        factors.push_back(p);
+        factors.push_back(rem);
+    }
+    const double pi = 3.141592653589793;
+    twiddles.resize(n);
+    quarter.resize(n);
+    for (int k = 0; k < n; k++) {
+        twiddles.at(k) = std::polar<double>(1.0, -2.0 * pi * k / n);
+        quarter.at(k) = std::polar<double>(1.0, -pi * k / (2.0 * n));
+    }
+}
+
+namespace {
+// std::complex multiplication checks for NaN and infinity and is not inlined without -ffast-math
+inline std::complex<float> cmul(std::complex<float> a, std::complex<float> b)
+{
+    return std::complex<float>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+} // namespace
+
+void DCTPlan::fft_stage(cpx *out, const cpx *in, int fstride, const int *stage, cpx *scratch) const
+{
+    const int p = stage[0], m = stage[1];
+    // Decimation in time: transform the p interleaved subsequences into consecutive blocks of m outputs
+    if (m == 1) {
+        for (int q = 0; q < p; q++)
+            out[q] = in[q * fstride];
+    } else {
+        for (int q = 0; q < p; q++)
+            fft_stage(out + q * m, in + q * fstride, fstride * p, stage + 2, scratch);
+    }
+    // Then combine them with radix-p butterflies
+    const cpx *tw = twiddles.data();
+    if (p == 2) {
+        for (int k = 0; k < m; k++) {
+            cpx t = cmul(out[k + m], tw[k * fstride]);
+            out[k + m] = out[k] - t;
+            out[k] += t;
+        }
+    } else if (p == 3) {
+        const float s60 = tw[fstride * m].imag(); // -sin(2*pi/3)
+        for (int k = 0; k < m; k++) {
+            cpx s1 = cmul(out[k + m], tw[k * fstride]);
+            cpx s2 = cmul(out[k + 2 * m], tw[2 * k * fstride]);
+            cpx s3 = s1 + s2, s0 = s1 - s2;
+            cpx a = out[k] - 0.5f * s3;
+            out[k] += s3;
+            cpx b = cpx(-s0.imag() * s60, s0.real() * s60);
+            out[k + m] = a + b;
+            out[k + 2 * m] = a - b;
+        }
+    } else if (p == 4) {
+        for (int k = 0; k < m; k++) {
+            cpx s0 = cmul(out[k + m], tw[k * fstride]);
+            cpx s1 = cmul(out[k + 2 * m], tw[2 * k * fstride]);
+            cpx s2 = cmul(out[k + 3 * m], tw[3 * k * fstride]);
+            cpx s5 = out[k] - s1;
+            cpx s6 = out[k] + s1;
+            cpx s3 = s0 + s2, s4 = s0 - s2;
+            out[k] = s6 + s3;
+            out[k + 2 * m] = s6 - s3;
+            out[k + m] = cpx(s5.real() + s4.imag(), s5.imag() - s4.real());
+            out[k + 3 * m] = cpx(s5.real() - s4.imag(), s5.imag() + s4.real());
+        }
+    } else if (p == 5) {
+        const cpx ya = tw[fstride * m], yb = tw[2 * fstride * m];
+        for (int k = 0; k < m; k++) {
+            cpx s0 = out[k];
+            cpx s1 = cmul(out[k + m], tw[k * fstride]);
+            cpx s2 = cmul(out[k + 2 * m], tw[2 * k * fstride]);
+            cpx s3 = cmul(out[k + 3 * m], tw[3 * k * fstride]);
+            cpx s4 = cmul(out[k + 4 * m], tw[4 * k * fstride]);
+            cpx s7 = s1 + s4, s10 = s1 - s4;
+            cpx s8 = s2 + s3, s9 = s2 - s3;
+            out[k] = s0 + s7 + s8;
+            cpx s5 = s0 + cpx(s7.real() * ya.real() + s8.real() * yb.real(),
+                              s7.imag() * ya.real() + s8.imag() * yb.real());
+            cpx s6 = cpx(s10.imag() * ya.imag() + s9.imag() * yb.imag(),
+                         -s10.real() * ya.imag() - s9.real() * yb.imag());
+            out[k + m] = s5 - s6;
+            out[k + 4 * m] = s5 + s6;
+            cpx s11 = s0 + cpx(s7.real() * yb.real() + s8.real() * ya.real(),
+                               s7.imag() * yb.real() + s8.imag() * ya.real());
+            cpx s12 = cpx(-s10.imag() * yb.imag() + s9.imag() * ya.imag(),
+                          s10.real() * yb.imag() - s9.real() * ya.imag());
+            out[k + 2 * m] = s11 + s12;
+            out[k + 3 * m] = s11 - s12;
+        }
+    } else {
+        for (int u = 0; u < m; u++) {
+            for (int q = 0; q < p; q++)
+                scratch[q] = out[u + q * m];
+            for (int q1 = 0; q1 < p; q1++) {
+                int k = u + q1 * m;
+                int tw_idx = 0;
+                cpx acc = scratch[0];
+                for (int q = 1; q < p; q++) {
+                    tw_idx += fstride * k;
+                    if (tw_idx >= n)
+                        tw_idx -= n;
+                    acc += cmul(scratch[q], tw[tw_idx]);
+                }
+                out[k] = acc;
+            }
+        }
+    }
+}
+
+void DCTPlan::fft(const cpx *in, cpx *out, cpx *scratch) const { fft_stage(out, in, 1, factors.data(), scratch); }
+
+void DCTPlan::run(Transform kind, float *a, float *b, std::vector<cpx> &work) const
+{
+    if (n <= 1) {
+        if (n == 1 && kind == Transform::DST3) {
+            a[0] = 0;
+            if (b)
+                b[0] = 0;
+        }
+        return;
+    }
+    int max_radix = 0;
+    for (size_t i = 0; i < factors.size(); i += 2)
+        max_radix = std::max(max_radix, factors.at(i));
+    if (int(work.size()) < 2 * n + max_radix)
+        work.resize(2 * n + max_radix);
+    cpx *in = work.data(), *out = work.data() + n, *scratch = work.data() + 2 * n;
+
+    // Both transforms have real inputs or outputs, so two of them can share one complex FFT: one in the real part and
+    // one in the imaginary part
+    if (kind == Transform::DCT2) {
+        // Even samples in order followed by odd samples reversed; then rotate the spectrum by a quarter sample
+        for (int j = 0; 2 * j < n; j++)
+            in[j] = cpx(a[2 * j], b ? b[2 * j] : 0.0f);
+        for (int j = 0; 2 * j + 1 < n; j++)
+            in[n - 1 - j] = cpx(a[2 * j + 1], b ? b[2 * j + 1] : 0.0f);
+        fft(in, out, scratch);
+        for (int k = 0; k < n; k++) {
+            cpx z = out[k], zc = std::conj(out[k == 0 ? 0 : (n - k)]);
+            cpx za = 0.5f * (z + zc), zb = cpx(0.0f, -0.5f) * (z - zc);
+            a[k] = za.real() * quarter[k].real() - za.imag() * quarter[k].imag();
+            if (b)
+                b[k] = zb.real() * quarter[k].real() - zb.imag() * quarter[k].imag();
+        }
+        return;
+    }
+
+    // DCT3 inverts the steps above, as the inverse of DCT2 is a DCT3 with the first input doubled and scaled by 2/n.
+    // The inverse DFT is the conjugate of a forward DFT of the conjugate; and as it is real, so is the forward DFT.
+    // DST3 is a DCT3 of the reversed input with every other output negated, as
+    //   sin(pi * (n - j) * (k + 1/2) / n) = (-1)^k * cos(pi * j * (k + 1/2) / n)
+    auto prepare = [&](const float *data, int j) {
+        if (kind == Transform::DCT3)
+            return (j == 0) ? cpx(2.0f * data[0]) : cmul(quarter[j], cpx(data[j], data[n - j]));
+        else
+            return (j == 0) ? cpx(0.0f) : cmul(quarter[j], cpx(data[n - j], data[j]));
+    };
+    for (int j = 0; j < n; j++) {
+        in[j] = prepare(a, j);
+        if (b) {
+            cpx t = prepare(b, j);
+            in[j] += cpx(-t.imag(), t.real());
+        }
+    }
+    fft(in, out, scratch);
+    float sign = 0.5f;
+    for (int j = 0; 2 * j < n; j++) {
+        a[2 * j] = sign * out[j].real();
+        if (b)
+            b[2 * j] = sign * out[j].imag();
+    }
+    if (kind == Transform::DST3)
+        sign = -sign;
+    for (int j = 0; 2 * j + 1 < n; j++) {
+        a[2 * j + 1] = sign * out[n - 1 - j].real();
+        if (b)
+            b[2 * j + 1] = sign * out[n - 1 - j].imag();
+    }
+}
+
+} // namespace StaticFFT
+
+NEXTPNR_NAMESPACE_END
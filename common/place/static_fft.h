@@ -0,0 +1,76 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef STATIC_FFT_H
+#define STATIC_FFT_H
+
+#include <complex>
+#include <vector>
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace StaticFFT {
+
+enum class Transform
+{
+    DCT2, // out[k] = sum_j in[j] * cos(pi * (j + 1/2) * k / n)
+    DCT3, // out[k] = sum_j in[j] * cos(pi * j * (k + 1/2) / n)
+    DST3, // out[k] = sum_j in[j] * sin(pi * j * (k + 1/2) / n)
+};
+
+// Smallest size >= min_size with no prime factors other than 2, 3 and 5, which the FFT handles efficiently
+int fft_size(int min_size);
+
+// Precomputed twiddle factors for the real trigonometric transforms above, of one length. These are computed through a
+// mixed-radix complex FFT of the same length (Makhoul's method), so any length works; but lengths with large prime
+// factors are slow.
+//
+// A plan is immutable once constructed, and so may be used from several threads at once as long as each has its own
+// work buffer.
+class DCTPlan
+{
+  public:
+    explicit DCTPlan(int n = 0);
+
+    int size() const { return n; }
+
+    // Transform a[0..n), and also b[0..n) if not null, in place. work is resized as needed
+    void run(Transform kind, float *a, float *b, std::vector<std::complex<float>> &work) const;
+
+  private:
+    typedef std::complex<float> cpx;
+
+    int n;
+    // pairs of (radix, remaining length) from the outermost stage inwards
+    std::vector<int> factors;
+    // exp(-2*pi*i*k/n)
+    std::vector<cpx> twiddles;
+    // exp(-i*pi*k/(2n))
+    std::vector<cpx> quarter;
+
+    void fft(const cpx *in, cpx *out, cpx *scratch) const;
+    void fft_stage(cpx *out, const cpx *in, int fstride, const int *stage, cpx *scratch) const;
+};
+
+} // namespace StaticFFT
+
+NEXTPNR_NAMESPACE_END
+
+#endif
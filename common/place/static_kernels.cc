@@ -0,0 +1,308 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "static_kernels.h"
+
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NPNR_STATIC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace StaticKernels {
+
+namespace {
+
+// Below this exp(x) is not representable as a normal float, and the term is dropped
+const float exp_lo = -87.3365447f;
+const float exp_hi = 88.3762626f;
+
+// Scalar fallback
+
+float exp_term(float e) { return (e < exp_lo) ? 0.0f : std::exp(e); }
+
+WASums wa_exp_scalar(const float *loc, float *min_exp, float *max_exp, int n, float c, float coeff)
+{
+    WASums s;
+    for (int i = 0; i < n; i++) {
+        float x = loc[i];
+        float emin = exp_term((c - x) * coeff), emax = exp_term((x - c) * coeff);
+        min_exp[i] = emin;
+        max_exp[i] = emax;
+        s.min_exp += emin;
+        s.x_min_exp += x * emin;
+        s.max_exp += emax;
+        s.x_max_exp += x * emax;
+    }
+    return s;
+}
+
+// The derivative of the weighted-average wirelength, from Replace, rearranged around the weighted mean positions
+// x_min_exp/min_exp and x_max_exp/max_exp so it can be evaluated in single precision:
+//   d/dx_i WA_min = min_exp_i / min_sum * (1 - coeff * (x_i - mean_min))
+//   d/dx_i WA_max = max_exp_i / max_sum * (1 + coeff * (x_i - mean_max))
+struct GradConsts
+{
+    GradConsts(const WASums &s)
+    {
+        inv_min = (s.min_exp > 0) ? (1.0f / s.min_exp) : 0.0f;
+        inv_max = (s.max_exp > 0) ? (1.0f / s.max_exp) : 0.0f;
+        mean_min = s.x_min_exp * inv_min;
+        mean_max = s.x_max_exp * inv_max;
+    }
+    float inv_min, inv_max, mean_min, mean_max;
+};
+
+void wa_grad_scalar(const float *loc, const float *min_exp, const float *max_exp, float *grad, int n, float coeff,
+                    const WASums &sums)
+{
+    GradConsts k(sums);
+    for (int i = 0; i < n; i++) {
+        float d_min = min_exp[i] * k.inv_min * (1.0f - coeff * (loc[i] - k.mean_min));
+        float d_max = max_exp[i] * k.inv_max * (1.0f + coeff * (loc[i] - k.mean_max));
+        grad[i] = d_min - d_max;
+    }
+}
+
+#ifdef NPNR_STATIC_X86_KERNELS
+
+// Cephes-style expf: range reduction to [-ln2/2, ln2/2], a degree 5 polynomial, then scaling by 2^n through the
+// exponent bits. Accurate to about 1ulp across the normal range; inputs below exp_lo give zero.
+
+const float exp_log2e = 1.44269504088896341f;
+const float exp_c1 = 0.693359375f;
+const float exp_c2 = -2.12194440e-4f;
+const float exp_p0 = 1.9875691500e-4f;
+const float exp_p1 = 1.3981999507e-3f;
+const float exp_p2 = 8.3334519073e-3f;
+const float exp_p3 = 4.1665795894e-2f;
+const float exp_p4 = 1.6666665459e-1f;
+const float exp_p5 = 5.0000001201e-1f;
+
+__attribute__((target("avx2,fma"))) inline __m256 exp_avx2(__m256 x)
+{
+    __m256 under = _mm256_cmp_ps(x, _mm256_set1_ps(exp_lo), _CMP_LT_OQ);
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(exp_lo)), _mm256_set1_ps(exp_hi));
+    __m256 fx = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(exp_log2e), _mm256_set1_ps(0.5f)));
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(exp_c1), x);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(exp_c2), x);
+    __m256 y = _mm256_set1_ps(exp_p0);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(exp_p1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(exp_p2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(exp_p3));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(exp_p4));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(exp_p5));
+    y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+    __m256i pow2n = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(fx), _mm256_set1_epi32(127)), 23);
+    y = _mm256_mul_ps(y, _mm256_castsi256_ps(pow2n));
+    return _mm256_andnot_ps(under, y);
+}
+
+__attribute__((target("avx2,fma"))) inline float hsum_avx2(__m256 v)
+{
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+// The vector kernels handle the ragged end of each net with masked loads and stores rather than falling back to scalar
+// code, as most nets are smaller than one vector and mixing in scalar libm calls is much slower
+
+__attribute__((target("avx2,fma"))) inline __m256i tail_mask_avx2(int remaining)
+{
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(remaining), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2,fma"))) WASums wa_exp_avx2(const float *loc, float *min_exp, float *max_exp, int n,
+                                                       float c, float coeff)
+{
+    __m256 vc = _mm256_set1_ps(c), vk = _mm256_set1_ps(coeff);
+    __m256 s_min = _mm256_setzero_ps(), s_xmin = _mm256_setzero_ps();
+    __m256 s_max = _mm256_setzero_ps(), s_xmax = _mm256_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        __m256i mask = tail_mask_avx2(n - i);
+        __m256 x = _mm256_maskload_ps(loc + i, mask);
+        __m256 emin = _mm256_and_ps(exp_avx2(_mm256_mul_ps(_mm256_sub_ps(vc, x), vk)), _mm256_castsi256_ps(mask));
+        __m256 emax = _mm256_and_ps(exp_avx2(_mm256_mul_ps(_mm256_sub_ps(x, vc), vk)), _mm256_castsi256_ps(mask));
+        _mm256_maskstore_ps(min_exp + i, mask, emin);
+        _mm256_maskstore_ps(max_exp + i, mask, emax);
+        s_min = _mm256_add_ps(s_min, emin);
+        s_xmin = _mm256_fmadd_ps(x, emin, s_xmin);
+        s_max = _mm256_add_ps(s_max, emax);
+        s_xmax = _mm256_fmadd_ps(x, emax, s_xmax);
+    }
+    WASums s;
+    s.min_exp = hsum_avx2(s_min);
+    s.x_min_exp = hsum_avx2(s_xmin);
+    s.max_exp = hsum_avx2(s_max);
+    s.x_max_exp = hsum_avx2(s_xmax);
+    return s;
+}
+
+__attribute__((target("avx2,fma"))) void wa_grad_avx2(const float *loc, const float *min_exp, const float *max_exp,
+                                                      float *grad, int n, float coeff, const WASums &sums)
+{
+    GradConsts k(sums);
+    __m256 vk = _mm256_set1_ps(coeff), one = _mm256_set1_ps(1.0f);
+    __m256 inv_min = _mm256_set1_ps(k.inv_min), inv_max = _mm256_set1_ps(k.inv_max);
+    __m256 mean_min = _mm256_set1_ps(k.mean_min), mean_max = _mm256_set1_ps(k.mean_max);
+    for (int i = 0; i < n; i += 8) {
+        __m256i mask = tail_mask_avx2(n - i);
+        __m256 x = _mm256_maskload_ps(loc + i, mask);
+        __m256 d_min = _mm256_mul_ps(_mm256_mul_ps(_mm256_maskload_ps(min_exp + i, mask), inv_min),
+                                     _mm256_fnmadd_ps(vk, _mm256_sub_ps(x, mean_min), one));
+        __m256 d_max = _mm256_mul_ps(_mm256_mul_ps(_mm256_maskload_ps(max_exp + i, mask), inv_max),
+                                     _mm256_fmadd_ps(vk, _mm256_sub_ps(x, mean_max), one));
+        _mm256_maskstore_ps(grad + i, mask, _mm256_sub_ps(d_min, d_max));
+    }
+}
+
+// GCC 12 warns about the deliberately undefined pass-through operands used inside its AVX-512 intrinsics
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f"))) inline __m512 exp_avx512(__m512 x)
+{
+    __mmask16 keep = _mm512_cmp_ps_mask(x, _mm512_set1_ps(exp_lo), _CMP_GE_OQ);
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(exp_lo)), _mm512_set1_ps(exp_hi));
+    __m512 fx = _mm512_roundscale_ps(_mm512_fmadd_ps(x, _mm512_set1_ps(exp_log2e), _mm512_set1_ps(0.5f)),
+                                     _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(exp_c1), x);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(exp_c2), x);
+    __m512 y = _mm512_set1_ps(exp_p0);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(exp_p1));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(exp_p2));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(exp_p3));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(exp_p4));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(exp_p5));
+    y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0f)));
+    __m512i pow2n = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(fx), _mm512_set1_epi32(127)), 23);
+    y = _mm512_mul_ps(y, _mm512_castsi512_ps(pow2n));
+    return _mm512_maskz_mov_ps(keep, y);
+}
+
+__attribute__((target("avx512f"))) inline __mmask16 tail_mask_avx512(int remaining)
+{
+    return (remaining >= 16) ? __mmask16(0xFFFF) : __mmask16((1U << remaining) - 1);
+}
+
+__attribute__((target("avx512f"))) WASums wa_exp_avx512(const float *loc, float *min_exp, float *max_exp, int n,
+                                                        float c, float coeff)
+{
+    __m512 vc = _mm512_set1_ps(c), vk = _mm512_set1_ps(coeff);
+    __m512 s_min = _mm512_setzero_ps(), s_xmin = _mm512_setzero_ps();
+    __m512 s_max = _mm512_setzero_ps(), s_xmax = _mm512_setzero_ps();
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 x = _mm512_maskz_loadu_ps(mask, loc + i);
+        __m512 emin = _mm512_maskz_mov_ps(mask, exp_avx512(_mm512_mul_ps(_mm512_sub_ps(vc, x), vk)));
+        __m512 emax = _mm512_maskz_mov_ps(mask, exp_avx512(_mm512_mul_ps(_mm512_sub_ps(x, vc), vk)));
+        _mm512_mask_storeu_ps(min_exp + i, mask, emin);
+        _mm512_mask_storeu_ps(max_exp + i, mask, emax);
+        s_min = _mm512_add_ps(s_min, emin);
+        s_xmin = _mm512_fmadd_ps(x, emin, s_xmin);
+        s_max = _mm512_add_ps(s_max, emax);
+        s_xmax = _mm512_fmadd_ps(x, emax, s_xmax);
+    }
+    WASums s;
+    s.min_exp = _mm512_reduce_add_ps(s_min);
+    s.x_min_exp = _mm512_reduce_add_ps(s_xmin);
+    s.max_exp = _mm512_reduce_add_ps(s_max);
+    s.x_max_exp = _mm512_reduce_add_ps(s_xmax);
+    return s;
+}
+
+__attribute__((target("avx512f"))) void wa_grad_avx512(const float *loc, const float *min_exp, const float *max_exp,
+                                                       float *grad, int n, float coeff, const WASums &sums)
+{
+    GradConsts k(sums);
+    __m512 vk = _mm512_set1_ps(coeff), one = _mm512_set1_ps(1.0f);
+    __m512 inv_min = _mm512_set1_ps(k.inv_min), inv_max = _mm512_set1_ps(k.inv_max);
+    __m512 mean_min = _mm512_set1_ps(k.mean_min), mean_max = _mm512_set1_ps(k.mean_max);
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 mask = tail_mask_avx512(n - i);
+        __m512 x = _mm512_maskz_loadu_ps(mask, loc + i);
+        __m512 d_min = _mm512_mul_ps(_mm512_mul_ps(_mm512_maskz_loadu_ps(mask, min_exp + i), inv_min),
+                                     _mm512_fnmadd_ps(vk, _mm512_sub_ps(x, mean_min), one));
+        __m512 d_max = _mm512_mul_ps(_mm512_mul_ps(_mm512_maskz_loadu_ps(mask, max_exp + i), inv_max),
+                                     _mm512_fmadd_ps(vk, _mm512_sub_ps(x, mean_max), one));
+        _mm512_mask_storeu_ps(grad + i, mask, _mm512_sub_ps(d_min, d_max));
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+struct KernelTable
+{
+    decltype(&wa_exp_scalar) exp = wa_exp_scalar;
+    decltype(&wa_grad_scalar) grad = wa_grad_scalar;
+    const char *name = "scalar";
+
+    KernelTable()
+    {
+#ifdef NPNR_STATIC_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            exp = wa_exp_avx512;
+            grad = wa_grad_avx512;
+            name = "avx512";
+        } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            exp = wa_exp_avx2;
+            grad = wa_grad_avx2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+const KernelTable &kernels()
+{
+    static const KernelTable table;
+    return table;
+}
+
+} // namespace
+
+WASums wa_exp(const float *loc, float *min_exp, float *max_exp, int n, float c, float coeff)
+{
+    return kernels().exp(loc, min_exp, max_exp, n, c, coeff);
+}
+
+void wa_grad(const float *loc, const float *min_exp, const float *max_exp, float *grad, int n, float coeff,
+             const WASums &sums)
+{
+    kernels().grad(loc, min_exp, max_exp, grad, n, coeff, sums);
+}
+
+const char *isa_name() { return kernels().name; }
+
+} // namespace StaticKernels
+
+NEXTPNR_NAMESPACE_END
@@ -0,0 +1,52 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef STATIC_KERNELS_H
+#define STATIC_KERNELS_H
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace StaticKernels {
+
+// Sums for the weighted-average wirelength model of one net along one axis
+struct WASums
+{
+    float min_exp = 0, x_min_exp = 0;
+    float max_exp = 0, x_max_exp = 0;
+};
+
+// For the n port locations in loc, store exp((c - x) * coeff) into min_exp and exp((x - c) * coeff) into max_exp,
+// and return their sums and location-weighted sums. Terms that underflow are stored as zero.
+WASums wa_exp(const float *loc, float *min_exp, float *max_exp, int n, float c, float coeff);
+
+// Store the derivative of the weighted-average wirelength with respect to each port location into grad, given the
+// exponents and sums computed by wa_exp
+void wa_grad(const float *loc, const float *min_exp, const float *max_exp, float *grad, int n, float coeff,
+             const WASums &sums);
+
+// Name of the instruction set the kernels were selected for at startup ("avx512", "avx2" or "scalar")
+const char *isa_name();
+
+} // namespace StaticKernels
+
+NEXTPNR_NAMESPACE_END
+
+#endif
@@ -64,7 +64,7 @@ struct RealPair
 inline RealPair operator+(RealPair a, RealPair b) { return RealPair(a.x + b.x, a.y + b.y); }
 inline RealPair operator-(RealPair a, RealPair b) { return RealPair(a.x - b.x, a.y - b.y); }
 
-// array2d; but as ourafft wants it
+// array2d; but stored as separate contiguous columns, which the DCT passes work on
 struct FFTArray
 {
     FFTArray(int width = 0, int height = 0) : m_width(width), m_height(height)
@@ -82,7 +82,7 @@ struct FFTArray
 
     void reset(int width, int height, float value = 0)
     {
-        if (width != m_height || height != m_height) {
+        if (width != m_width || height != m_height) {
             destroy();
             m_width = width;
             m_height = height;
@@ -0,0 +1,157 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "route_check.h"
+
+#include "log.h"
+#include "nextpnr.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+namespace {
+
+// Names can't be built on worker threads (they share the Context's string ring buffer), so failures only record the
+// object concerned and are logged afterwards
+struct NetFailure
+{
+    const char *what = nullptr;
+    WireId wire;
+    PipId pip;
+};
+
+bool skip_net(const NetInfo *net)
+{
+#ifdef ARCH_ECP5
+    // ECP5 global nets currently appear part-unrouted due to arch database limitations
+    if (net->is_global)
+        return true;
+#endif
+    return net->driver.cell == nullptr && net->constant_value == IdString();
+}
+
+NetFailure fail_wire(const char *what, WireId wire)
+{
+    NetFailure f;
+    f.what = what;
+    f.wire = wire;
+    return f;
+}
+
+NetFailure fail_pip(const char *what, PipId pip)
+{
+    NetFailure f;
+    f.what = what;
+    f.pip = pip;
+    return f;
+}
+
+NetFailure check_net(const Context *ctx, const NetInfo *net, pool<WireId> &done, std::vector<WireId> &path)
+{
+    for (auto &it : net->wires) {
+        if (ctx->getBoundWireNet(it.first) != net)
+            return fail_wire("wire not bound to the net:", it.first);
+        PipId pip = it.second.pip;
+        if (pip == PipId())
+            continue;
+        if (ctx->getPipDstWire(pip) != it.first)
+            return fail_pip("pip does not drive its wire:", pip);
+        if (ctx->getBoundPipNet(pip) != net)
+            return fail_pip("pip not bound to the net:", pip);
+        // Locked routing may have been placed regardless of the usual rules, so only check what the router bound
+        if (it.second.strength < STRENGTH_LOCKED && !ctx->checkPipAvailForNet(pip, net))
+            return fail_pip("unavailable pip:", pip);
+    }
+
+    WireId src_wire = ctx->getNetinfoSourceWire(net);
+    if (src_wire == WireId() && net->constant_value == IdString())
+        return fail_wire("no source wire", WireId());
+
+    // Trace each sink back to the driver; wires in done are known to lead there already
+    done.clear();
+    for (auto &usr : net->users) {
+        for (WireId dst_wire : ctx->getNetinfoSinkWires(net, usr)) {
+            path.clear();
+            WireId cursor = dst_wire;
+            while (true) {
+                auto it = net->wires.find(cursor);
+                if (it == net->wires.end())
+                    return fail_wire("unrouted wire on the path to a sink:", cursor);
+                if (done.count(cursor))
+                    break;
+                path.push_back(cursor);
+                if (cursor == src_wire || (net->constant_value != IdString() &&
+                                           ctx->getWireConstantValue(cursor) == net->constant_value))
+                    break;
+                if (it->second.pip == PipId())
+                    return fail_wire("wire without a driving pip:", cursor);
+                if (path.size() > net->wires.size())
+                    return fail_wire("loop through wire:", cursor);
+                cursor = ctx->getPipSrcWire(it->second.pip);
+            }
+            for (WireId w : path)
+                done.insert(w);
+        }
+    }
+
+    // Anything else the router bound is a stub, which router1 would have ripped up
+    for (auto &it : net->wires)
+        if (it.second.strength < STRENGTH_LOCKED && !done.count(it.first))
+            return fail_wire("stub wire:", it.first);
+
+    return NetFailure();
+}
+
+} // namespace
+
+int check_routing(Context *ctx)
+{
+    std::vector<NetInfo *> nets;
+    for (auto &net : ctx->nets)
+        if (!skip_net(net.second.get()))
+            nets.push_back(net.second.get());
+
+    std::vector<NetFailure> failures(nets.size());
+    ctx->thread_pool().run_ranges("route_check", int(nets.size()), 64, [&](int begin, int end) {
+        pool<WireId> done;
+        std::vector<WireId> path;
+        for (int i = begin; i < end; i++)
+            failures.at(i) = check_net(ctx, nets.at(i), done, path);
+    });
+
+    const int max_logged = 10;
+    int failed = 0;
+    for (size_t i = 0; i < nets.size(); i++) {
+        const NetFailure &f = failures.at(i);
+        if (f.what == nullptr)
+            continue;
+        if (failed++ >= max_logged)
+            continue;
+        if (f.pip != PipId())
+            log_info("    net %s: %s %s\n", ctx->nameOf(nets.at(i)), f.what, ctx->nameOfPip(f.pip));
+        else if (f.wire != WireId())
+            log_info("    net %s: %s %s\n", ctx->nameOf(nets.at(i)), f.what, ctx->nameOfWire(f.wire));
+        else
+            log_info("    net %s: %s\n", ctx->nameOf(nets.at(i)), f.what);
+    }
+    if (failed > max_logged)
+        log_info("    ... and %d more nets\n", failed - max_logged);
+    return failed;
+}
+
+NEXTPNR_NAMESPACE_END
@@ -98,19 +98,38 @@ struct QueuedWire
     };
 };
 
+struct PerWireData
+{
+    // Search state of the arc currently being routed; only meaningful if visit_epoch matches Router1::curr_epoch
+    uint32_t visit_epoch = 0;
+    PipId pip;
+    delay_t delay = 0, penalty = 0, bonus = 0;
+
+    // Number of times the wire was ripped up
+    int score = 0;
+    // Arcs whose route uses the wire
+    pool<arc_key> arcs;
+};
+
 struct Router1
 {
     Context *ctx;
     const Router1Cfg &cfg;
 
     std::priority_queue<arc_entry, std::vector<arc_entry>, arc_entry::Less> arc_queue;
-    dict<WireId, pool<arc_key>> wire_to_arcs;
     dict<arc_key, pool<WireId>> arc_to_wires;
     pool<arc_key> queued_arcs;
 
     std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> queue;
 
-    dict<WireId, int> wireScores;
+    // If the arch provides a dense wire index, use it to index the per-wire state directly; otherwise fall back to a
+    // hash map built once at startup
+    bool dense_wires = false;
+    dict<WireId, int> wire_to_idx;
+    std::vector<PerWireData> flat_wires;
+    // Bumped for every arc routed, so the visited state of all wires is reset without touching them
+    uint32_t curr_epoch = 0;
+
     dict<NetInfo *, int, hash_ptr_ops> netScores;
 
     int arcs_with_ripup = 0;
@@ -126,8 +145,47 @@ struct Router1
         timing_driven = ctx->setting<bool>("timing_driven");
         tmg.setup_only = false;
         tmg.with_clock_skew = true;
+        tmg.incremental = true;
         tmg.setup();
         tmg.run();
+        setup_wires();
+    }
+
+    void setup_wires()
+    {
+        int dense_count = ctx->getDenseWireCount();
+        if (dense_count >= 0) {
+            dense_wires = true;
+            flat_wires.resize(dense_count);
+        } else {
+            for (auto wire : ctx->getWires())
+                wire_to_idx.emplace(wire, int(wire_to_idx.size()));
+            flat_wires.resize(wire_to_idx.size());
+        }
+    }
+
+    int wire_idx(WireId w) const { return dense_wires ? ctx->getDenseWireIndex(w) : wire_to_idx.at(w); }
+
+    PerWireData &wire_data(WireId w) { return flat_wires[wire_idx(w)]; }
+
+    void reset_visited()
+    {
+        if (++curr_epoch == 0) {
+            for (auto &wd : flat_wires)
+                wd.visit_epoch = 0;
+            curr_epoch = 1;
+        }
+    }
+
+    bool is_visited(const PerWireData &wd) const { return wd.visit_epoch == curr_epoch; }
+
+    void set_visited(PerWireData &wd, const QueuedWire &qw)
+    {
+        wd.visit_epoch = curr_epoch;
+        wd.pip = qw.pip;
+        wd.delay = qw.delay;
+        wd.penalty = qw.penalty;
+        wd.bonus = qw.bonus;
     }
 
     void arc_queue_insert(const arc_key &arc, WireId src_wire, WireId dst_wire)
@@ -199,12 +257,13 @@ struct Router1
         ctx->sorted_shuffle(wires);
 
         for (WireId w : wires) {
+            auto &wd = wire_data(w);
             std::vector<arc_key> arcs;
-            for (auto &it : wire_to_arcs[w]) {
+            for (auto &it : wd.arcs) {
                 arc_to_wires[it].erase(w);
                 arcs.push_back(it);
             }
-            wire_to_arcs[w].clear();
+            wd.arcs.clear();
 
             ctx->sorted_shuffle(arcs);
 
@@ -215,7 +274,7 @@ struct Router1
                 log("        unbind wire %s\n", ctx->nameOfWire(w));
 
             ctx->unbindWire(w);
-            wireScores[w]++;
+            wd.score++;
         }
 
         ripup_flag = true;
@@ -233,12 +292,13 @@ struct Router1
             if (n != nullptr)
                 ripup_net(n);
         } else {
+            auto &wd = wire_data(w);
             std::vector<arc_key> arcs;
-            for (auto &it : wire_to_arcs[w]) {
+            for (auto &it : wd.arcs) {
                 arc_to_wires[it].erase(w);
                 arcs.push_back(it);
             }
-            wire_to_arcs[w].clear();
+            wd.arcs.clear();
 
             ctx->sorted_shuffle(arcs);
 
@@ -249,7 +309,7 @@ struct Router1
                 log("      unbind wire %s\n", ctx->nameOfWire(w));
 
             ctx->unbindWire(w);
-            wireScores[w]++;
+            wd.score++;
         }
 
         ripup_flag = true;
@@ -267,12 +327,13 @@ struct Router1
             if (n != nullptr)
                 ripup_net(n);
         } else {
+            auto &wd = wire_data(w);
             std::vector<arc_key> arcs;
-            for (auto &it : wire_to_arcs[w]) {
+            for (auto &it : wd.arcs) {
                 arc_to_wires[it].erase(w);
                 arcs.push_back(it);
             }
-            wire_to_arcs[w].clear();
+            wd.arcs.clear();
 
             ctx->sorted_shuffle(arcs);
 
@@ -283,7 +344,7 @@ struct Router1
                 log("      unbind wire %s\n", ctx->nameOfWire(w));
 
             ctx->unbindWire(w);
-            wireScores[w]++;
+            wd.score++;
         }
 
         ripup_flag = true;
@@ -343,7 +404,7 @@ struct Router1
                         log("[check]     wire: %s\n", ctx->nameOfWire(wire));
 #endif
                         valid_wires_for_net.insert(wire);
-                        log_assert(wire_to_arcs[wire].count(arc));
+                        log_assert(wire_data(wire).arcs.count(arc));
                         log_assert(net_info->wires.count(wire));
                     }
                 }
@@ -355,8 +416,8 @@ struct Router1
             }
         }
 
-        for (auto &it : wire_to_arcs) {
-            for (auto &arc : it.second)
+        for (auto &wd : flat_wires) {
+            for (auto &arc : wd.arcs)
                 log_assert(valid_arcs.count(arc));
         }
 
@@ -431,7 +492,7 @@ struct Router1
                     }
 
                     WireId cursor = dst_wire;
-                    wire_to_arcs[cursor].insert(arc);
+                    wire_data(cursor).arcs.insert(arc);
                     arc_to_wires[arc].insert(cursor);
 
                     while (src_wire != cursor && (net_info->constant_value == IdString() ||
@@ -444,7 +505,7 @@ struct Router1
 
                         NPNR_ASSERT(it->second.pip != PipId());
                         cursor = ctx->getPipSrcWire(it->second.pip);
-                        wire_to_arcs[cursor].insert(arc);
+                        wire_data(cursor).arcs.insert(arc);
                         arc_to_wires[arc].insert(cursor);
                     }
                 }
@@ -460,7 +521,7 @@ struct Router1
             std::vector<WireId> unbind_wires;
 
             for (auto &it : net_info->wires)
-                if (it.second.strength < STRENGTH_LOCKED && wire_to_arcs.count(it.first) == 0)
+                if (it.second.strength < STRENGTH_LOCKED && wire_data(it.first).arcs.empty())
                     unbind_wires.push_back(it.first);
 
             for (auto it : unbind_wires)
@@ -493,7 +554,7 @@ struct Router1
         old_arc_wires.swap(arc_to_wires[arc]);
 
         for (WireId wire : old_arc_wires) {
-            auto &arc_wires = wire_to_arcs.at(wire);
+            auto &arc_wires = wire_data(wire).arcs;
             NPNR_ASSERT(arc_wires.count(arc));
             arc_wires.erase(arc);
             if (arc_wires.empty()) {
@@ -513,7 +574,7 @@ struct Router1
                 ctx->bindWire(src_wire, net_info, STRENGTH_WEAK);
             }
             arc_to_wires[arc].insert(src_wire);
-            wire_to_arcs[src_wire].insert(arc);
+            wire_data(src_wire).arcs.insert(arc);
             return true;
         }
 
@@ -523,7 +584,7 @@ struct Router1
             std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> new_queue;
             queue.swap(new_queue);
         }
-        dict<WireId, QueuedWire> visited;
+        reset_visited();
 
         // A* main loop
 
@@ -546,7 +607,7 @@ struct Router1
             qw.randtag = ctx->rng();
 
             queue.push(qw);
-            visited[qw.wire] = qw;
+            set_visited(wire_data(qw.wire), qw);
         }
 
         while (visitCnt++ < maxVisitCnt && !queue.empty()) {
@@ -629,16 +690,12 @@ struct Router1
                         conflictWireNet = nullptr;
 
                     if (conflictWireWire != WireId()) {
-                        auto scores_it = wireScores.find(conflictWireWire);
-                        if (scores_it != wireScores.end())
-                            penalty_delta += scores_it->second * cfg.wireRipupPenalty;
+                        penalty_delta += wire_data(conflictWireWire).score * cfg.wireRipupPenalty;
                         penalty_delta += cfg.wireRipupPenalty;
                     }
 
                     if (conflictPipWire != WireId()) {
-                        auto scores_it = wireScores.find(conflictPipWire);
-                        if (scores_it != wireScores.end())
-                            penalty_delta += scores_it->second * cfg.wireRipupPenalty;
+                        penalty_delta += wire_data(conflictPipWire).score * cfg.wireRipupPenalty;
                         penalty_delta += cfg.wireRipupPenalty;
                     }
 
@@ -667,10 +724,10 @@ struct Router1
                 if ((best_score >= 0) && (next_score - next_bonus - cfg.estimatePrecision > best_score))
                     continue;
 
-                auto old_visited_it = visited.find(next_wire);
-                if (old_visited_it != visited.end()) {
-                    delay_t old_delay = old_visited_it->second.delay;
-                    delay_t old_score = old_delay + old_visited_it->second.penalty;
+                auto &next_wd = wire_data(next_wire);
+                if (is_visited(next_wd)) {
+                    delay_t old_delay = next_wd.delay;
+                    delay_t old_score = old_delay + next_wd.penalty;
                     NPNR_ASSERT(old_score >= 0);
 
                     if (next_score + ctx->getDelayEpsilon() >= old_score)
@@ -681,7 +738,7 @@ struct Router1
                         log("Found better route to %s. Old vs new delay estimate: %.3f (%.3f) %.3f (%.3f)\n",
                             ctx->nameOfWire(next_wire),
                             ctx->getDelayNS(old_score),
-                            ctx->getDelayNS(old_visited_it->second.delay),
+                            ctx->getDelayNS(next_wd.delay),
                             ctx->getDelayNS(next_score),
                             ctx->getDelayNS(next_delay));
 #endif
@@ -712,7 +769,7 @@ struct Router1
                         ctx->getDelayNS(next_delay));
 #endif
 
-                visited[next_qw.wire] = next_qw;
+                set_visited(next_wd, next_qw);
                 queue.push(next_qw);
 
                 if (next_wire == dst_wire) {
@@ -725,16 +782,17 @@ struct Router1
         if (ctx->debug)
             log("  total number of visited nodes: %d\n", visitCnt);
 
-        if (visited.count(dst_wire) == 0) {
+        auto &dst_wd = wire_data(dst_wire);
+        if (!is_visited(dst_wd)) {
             if (ctx->debug)
                 log("  no route found for this arc\n");
             return false;
         }
 
         if (ctx->debug) {
-            log("  final route delay:   %8.2f\n", ctx->getDelayNS(visited[dst_wire].delay));
-            log("  final route penalty: %8.2f\n", ctx->getDelayNS(visited[dst_wire].penalty));
-            log("  final route bonus:   %8.2f\n", ctx->getDelayNS(visited[dst_wire].bonus));
+            log("  final route delay:   %8.2f\n", ctx->getDelayNS(dst_wd.delay));
+            log("  final route penalty: %8.2f\n", ctx->getDelayNS(dst_wd.penalty));
+            log("  final route bonus:   %8.2f\n", ctx->getDelayNS(dst_wd.bonus));
         }
 
         // bind resulting route (and maybe unroute other nets)
@@ -745,7 +803,8 @@ struct Router1
         delay_t accumulated_path_delay = 0;
         delay_t last_path_delay_delta = 0;
         while (1) {
-            auto pip = visited[cursor].pip;
+            auto &cursor_wd = wire_data(cursor);
+            auto pip = cursor_wd.pip;
 
             if (ctx->debug) {
                 delay_t path_delay_delta = ctx->estimateDelay(cursor, dst_wire) - accumulated_path_delay;
@@ -785,7 +844,7 @@ struct Router1
                 }
             }
 
-            wire_to_arcs[cursor].insert(arc);
+            cursor_wd.arcs.insert(arc);
             arc_to_wires[arc].insert(cursor);
 
             if (pip == PipId())
@@ -824,7 +883,7 @@ struct Router1
         old_arc_wires.swap(arc_to_wires[arc]);
 
         for (WireId wire : old_arc_wires) {
-            auto &arc_wires = wire_to_arcs.at(wire);
+            auto &arc_wires = wire_data(wire).arcs;
             NPNR_ASSERT(arc_wires.count(arc));
             arc_wires.erase(arc);
             if (arc_wires.empty()) {
@@ -844,7 +903,7 @@ struct Router1
                 ctx->bindWire(dst_wire, net_info, STRENGTH_WEAK);
             }
             arc_to_wires[arc].insert(dst_wire);
-            wire_to_arcs[dst_wire].insert(arc);
+            wire_data(dst_wire).arcs.insert(arc);
             return true;
         }
 
@@ -854,7 +913,7 @@ struct Router1
             std::priority_queue<QueuedWire, std::vector<QueuedWire>, QueuedWire::Greater> new_queue;
             queue.swap(new_queue);
         }
-        dict<WireId, QueuedWire> visited;
+        reset_visited();
 
         // A* main loop
 
@@ -873,7 +932,7 @@ struct Router1
             qw.randtag = ctx->rng();
 
             queue.push(qw);
-            visited[qw.wire] = qw;
+            set_visited(wire_data(qw.wire), qw);
         }
 
         while (visitCnt++ < maxVisitCnt && !queue.empty()) {
@@ -958,16 +1017,12 @@ struct Router1
                         conflictWireNet = nullptr;
 
                     if (conflictWireWire != WireId()) {
-                        auto scores_it = wireScores.find(conflictWireWire);
-                        if (scores_it != wireScores.end())
-                            penalty_delta += scores_it->second * cfg.wireRipupPenalty;
+                        penalty_delta += wire_data(conflictWireWire).score * cfg.wireRipupPenalty;
                         penalty_delta += cfg.wireRipupPenalty;
                     }
 
                     if (conflictPipWire != WireId()) {
-                        auto scores_it = wireScores.find(conflictPipWire);
-                        if (scores_it != wireScores.end())
-                            penalty_delta += scores_it->second * cfg.wireRipupPenalty;
+                        penalty_delta += wire_data(conflictPipWire).score * cfg.wireRipupPenalty;
                         penalty_delta += cfg.wireRipupPenalty;
                     }
 
@@ -996,10 +1051,9 @@ struct Router1
                 if ((best_score >= 0) && (next_score - next_bonus - cfg.estimatePrecision > best_score))
                     continue;
 
-                auto old_visited_it = visited.find(next_wire);
-                if (old_visited_it != visited.end()) {
+                auto &next_wd = wire_data(next_wire);
+                if (is_visited(next_wd))
                     continue;
-                }
 
                 QueuedWire next_qw;
                 next_qw.wire = next_wire;
@@ -1009,7 +1063,7 @@ struct Router1
                 next_qw.bonus = next_bonus;
                 next_qw.randtag = ctx->rng();
 
-                visited[next_qw.wire] = next_qw;
+                set_visited(next_wd, next_qw);
                 queue.push(next_qw);
 
                 if (ctx->getWireConstantValue(next_wire) == net_info->constant_value) {
@@ -1031,10 +1085,11 @@ struct Router1
             return false;
         }
 
+        auto &dst_wd = wire_data(dst_wire);
         if (ctx->debug) {
-            log("  final route delay:   %8.2f\n", ctx->getDelayNS(visited[dst_wire].delay));
-            log("  final route penalty: %8.2f\n", ctx->getDelayNS(visited[dst_wire].penalty));
-            log("  final route bonus:   %8.2f\n", ctx->getDelayNS(visited[dst_wire].bonus));
+            log("  final route delay:   %8.2f\n", ctx->getDelayNS(dst_wd.delay));
+            log("  final route penalty: %8.2f\n", ctx->getDelayNS(dst_wd.penalty));
+            log("  final route bonus:   %8.2f\n", ctx->getDelayNS(dst_wd.bonus));
         }
 
         // bind resulting route (and maybe unroute other nets)
@@ -1051,11 +1106,11 @@ struct Router1
             ctx->bindWire(cursor, net_info, STRENGTH_WEAK);
         }
 
-        wire_to_arcs[cursor].insert(arc);
+        wire_data(cursor).arcs.insert(arc);
         arc_to_wires[arc].insert(cursor);
 
         while (1) {
-            auto pip = visited[cursor].pip;
+            auto pip = wire_data(cursor).pip;
 
             if (pip == PipId()) {
                 NPNR_ASSERT(cursor == dst_wire);
@@ -1080,7 +1135,7 @@ struct Router1
                 ctx->bindPip(pip, net_info, STRENGTH_WEAK);
             }
 
-            wire_to_arcs[next].insert(arc);
+            wire_data(next).arcs.insert(arc);
             arc_to_wires[arc].insert(next);
 
             cursor = next;
@@ -1267,7 +1322,8 @@ bool router1(Context *ctx, const Router1Cfg &cfg)
                 log_info("    %d arcs ripped up due to negative slack WNS=%.02fns TNS=%.02fns.\n",
                          int(router.arc_queue.size()), ctx->getDelayNS(wns), ctx->getDelayNS(tns));
                 iter_cnt = 0;
-                router.wireScores.clear();
+                for (auto &wd : router.flat_wires)
+                    wd.score = 0;
                 router.netScores.clear();
             }
         }
@@ -29,18 +29,21 @@
 #include "router2.h"
 
 #include <algorithm>
+#include <atomic>
 #include <boost/container/flat_map.hpp>
 #include <chrono>
 #include <deque>
 #include <fstream>
 #include <limits>
 #include <mutex>
+#include <numeric>
 #include <queue>
 #include <set>
 
 #include "log.h"
 #include "nextpnr.h"
 #include "nextpnr_assertions.h"
+#include "route_check.h"
 #include "router1.h"
 #include "timing.h"
 #include "util.h"
@@ -99,6 +102,8 @@ struct Router2
         bool unavailable = false;
         // This wire has to be used for this net
         int reserved_net = -1;
+        // Index into flat_resources of the resource driving this wire, if any
+        int resource = -1;
         // The notional location of the wire, to guarantee thread safety
         int16_t x = 0, y = 0;
         // Visit data
@@ -122,6 +127,7 @@ struct Router2
     {
         tmg.setup_only = false;
         tmg.with_clock_skew = true;
+        tmg.incremental = true;
         tmg.setup();
     }
 
@@ -204,13 +210,42 @@ struct Router2
         }
     }
 
+    // If the arch provides a dense wire index, use a flat array to map it to our own wire index; otherwise fall back
+    // to a hash map
+    bool dense_wires = false;
+    std::vector<int> dense_wire_to_idx;
     dict<WireId, int> wire_to_idx;
     std::vector<PerWireData> flat_wires;
 
-    PerWireData &wire_data(WireId w) { return flat_wires[wire_to_idx.at(w)]; }
+    // CSR-style routing graph, so that expansion doesn't need any wire lookups. For each wire, the destination wires
+    // of its downhill pips (and source wires of its uphill pips) are stored in the same order as getPipsDownhill
+    // (getPipsUphill) returns them, starting at the offset given by dh_start (uh_start)
+    std::vector<int> dh_start, dh_wires;
+    std::vector<int> uh_start, uh_wires;
+
+    int wire_idx(WireId w) const
+    {
+        return dense_wires ? dense_wire_to_idx[ctx->getDenseWireIndex(w)] : wire_to_idx.at(w);
+    }
+
+    PerWireData &wire_data(WireId w) { return flat_wires[wire_idx(w)]; }
+
+    // Cheap check before hash lookups into the wires of a net; as a net's own wires always count towards the
+    // congestion of a wire, a wire with zero congestion can't be used by the net
+    dict<WireId, std::pair<PipId, int>>::iterator find_net_wire(PerNetData &nd, const PerWireData &wd)
+    {
+        if (wd.curr_cong == 0)
+            return nd.wires.end();
+        return nd.wires.find(wd.w);
+    }
 
     void setup_wires()
     {
+        int dense_count = ctx->getDenseWireCount();
+        if (dense_count >= 0) {
+            dense_wires = true;
+            dense_wire_to_idx.resize(dense_count, -1);
+        }
         // Set up per-wire structures, so that MT parts don't have to do any memory allocation
         // This is possibly quite wasteful and not cache-optimal; further consideration necessary
         for (auto wire : ctx->getWires()) {
@@ -235,10 +270,31 @@ struct Router2
             pwd.x = (wire_loc.x0 + wire_loc.x1) / 2;
             pwd.y = (wire_loc.y0 + wire_loc.y1) / 2;
 
-            wire_to_idx[wire] = int(flat_wires.size());
+            auto resource = wire_to_resource.find(wire);
+            if (resource != wire_to_resource.end())
+                pwd.resource = resource->second;
+
+            if (dense_wires)
+                dense_wire_to_idx.at(ctx->getDenseWireIndex(wire)) = int(flat_wires.size());
+            else
+                wire_to_idx[wire] = int(flat_wires.size());
             flat_wires.push_back(pwd);
         }
 
+        // Build the flattened routing graph
+        dh_start.reserve(flat_wires.size() + 1);
+        uh_start.reserve(flat_wires.size() + 1);
+        for (auto &wd : flat_wires) {
+            dh_start.push_back(int(dh_wires.size()));
+            for (auto pip : ctx->getPipsDownhill(wd.w))
+                dh_wires.push_back(wire_idx(ctx->getPipDstWire(pip)));
+            uh_start.push_back(int(uh_wires.size()));
+            for (auto pip : ctx->getPipsUphill(wd.w))
+                uh_wires.push_back(wire_idx(ctx->getPipSrcWire(pip)));
+        }
+        dh_start.push_back(int(dh_wires.size()));
+        uh_start.push_back(int(uh_wires.size()));
+
         for (auto &net_pair : ctx->nets) {
             auto *net = net_pair.second.get();
             auto &nd = nets.at(net->udata);
@@ -253,6 +309,207 @@ struct Router2
         }
     }
 
+    // Optional A* lookahead, in the spirit of VPR's map lookahead. For each wire type, a few sample wires are expanded
+    // with Dijkstra over the uncongested routing graph, recording the cheapest cost to reach any wire at each (dx, dy)
+    // offset within lookahead_radius. Offsets further away are extrapolated using the cheapest cost per tile seen.
+    bool use_lookahead = false;
+    int la_radius = 0, la_side = 0;
+    // Lookahead class of each flat wire, index into la_classes
+    std::vector<int> la_wire_class;
+    std::vector<IdString> la_classes;
+    // la_side * la_side entries per class, negative where unknown
+    std::vector<float> la_table;
+    float la_slope = 0;
+
+    float &la_entry(int cls, int dx, int dy)
+    {
+        return la_table[(size_t(cls) * la_side + (dy + la_radius)) * la_side + (dx + la_radius)];
+    }
+
+    // Returns a negative value if the lookahead has nothing to say about this pair of wires
+    float lookahead_cost(int src, int dst)
+    {
+        auto &swd = flat_wires[src], &dwd = flat_wires[dst];
+        int dx = dwd.x - swd.x, dy = dwd.y - swd.y;
+        int cdx = std::min(std::max(dx, -la_radius), la_radius), cdy = std::min(std::max(dy, -la_radius), la_radius);
+        float base = la_entry(la_wire_class[src], cdx, cdy);
+        if (base < 0)
+            return -1;
+        return base + la_slope * (std::abs(dx - cdx) + std::abs(dy - cdy));
+    }
+
+    void lookahead_sample(int src, std::vector<float> &table)
+    {
+        auto &swd = flat_wires[src];
+        table.assign(size_t(la_side) * la_side, -1.0f);
+        dict<int, float> best;
+        std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>,
+                            std::greater<std::pair<float, int>>>
+                queue;
+        best[src] = 0;
+        queue.emplace(0, src);
+        while (!queue.empty()) {
+            auto curr = queue.top();
+            queue.pop();
+            if (best.at(curr.second) < curr.first)
+                continue;
+            auto &cwd = flat_wires[curr.second];
+            float &entry = table[size_t(cwd.y - swd.y + la_radius) * la_side + (cwd.x - swd.x + la_radius)];
+            // Dijkstra visits in cost order, so the first visit to a location is the cheapest
+            if (entry < 0)
+                entry = curr.first;
+            int dh_cursor = dh_start[curr.second];
+            for (PipId dh : ctx->getPipsDownhill(cwd.w)) {
+                int next_idx = dh_wires[dh_cursor++];
+                auto &nwd = flat_wires[next_idx];
+                if (std::abs(nwd.x - swd.x) > la_radius || std::abs(nwd.y - swd.y) > la_radius)
+                    continue;
+                float next_cost = curr.first + cfg.get_base_cost(ctx, nwd.w, dh, 1.0f);
+                auto fnd = best.find(next_idx);
+                if (fnd != best.end() && fnd->second <= next_cost)
+                    continue;
+                best[next_idx] = next_cost;
+                queue.emplace(next_cost, next_idx);
+            }
+        }
+    }
+
+    void build_lookahead()
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int cx = ctx->getGridDimX() / 2, cy = ctx->getGridDimY() / 2;
+        // Pick samples from the wires nearest the centre of the device, to minimise edge effects, but spread them out
+        // a bit as the fabric isn't completely regular
+        std::vector<std::vector<int>> class_wires(la_classes.size());
+        for (int i = 0; i < int(flat_wires.size()); i++)
+            class_wires.at(la_wire_class.at(i)).push_back(i);
+        std::vector<std::pair<int, int>> samples;
+        for (int c = 0; c < int(la_classes.size()); c++) {
+            auto &wires = class_wires.at(c);
+            auto dist = [&](int w) { return std::abs(flat_wires[w].x - cx) + std::abs(flat_wires[w].y - cy); };
+            std::stable_sort(wires.begin(), wires.end(), [&](int a, int b) { return dist(a) < dist(b); });
+            int candidates = std::min<int>(wires.size(), 16 * cfg.lookahead_samples);
+            int count = std::min(candidates, cfg.lookahead_samples);
+            for (int s = 0; s < count; s++)
+                samples.emplace_back(c, wires.at((s * candidates) / count));
+        }
+        std::vector<std::vector<float>> sample_tables(samples.size());
+        ctx->thread_pool().run("router2/lookahead", int(samples.size()), [&](int i) {
+            lookahead_sample(samples.at(i).second, sample_tables.at(i));
+        });
+        // Keep the cheapest cost over all samples of a class, so the estimate errs towards being optimistic
+        la_table.assign(la_classes.size() * la_side * la_side, -1.0f);
+        for (size_t i = 0; i < samples.size(); i++) {
+            float *dst = &la_table[size_t(samples.at(i).first) * la_side * la_side];
+            auto &src = sample_tables.at(i);
+            for (size_t j = 0; j < src.size(); j++)
+                if (src[j] >= 0 && (dst[j] < 0 || src[j] < dst[j]))
+                    dst[j] = src[j];
+        }
+        // Cheapest cost per tile over longer distances, for extrapolation beyond the table
+        la_slope = std::numeric_limits<float>::max();
+        for (int c = 0; c < int(la_classes.size()); c++)
+            for (int dy = -la_radius; dy <= la_radius; dy++)
+                for (int dx = -la_radius; dx <= la_radius; dx++) {
+                    int dist = std::abs(dx) + std::abs(dy);
+                    float cost = la_entry(c, dx, dy);
+                    if (cost >= 0 && 2 * dist >= la_radius)
+                        la_slope = std::min(la_slope, cost / dist);
+                }
+        if (la_slope == std::numeric_limits<float>::max())
+            la_slope = 0;
+        auto end = std::chrono::high_resolution_clock::now();
+        log_info("    built lookahead for %d wire types from %d samples in %.02fs\n", int(la_classes.size()),
+                 int(samples.size()), std::chrono::duration<float>(end - start).count());
+    }
+
+    // The cache is only valid for the same device and lookahead parameters; the wire count is a cheap check that the
+    // device (or its database) hasn't changed under the same name
+    static constexpr uint32_t la_cache_version = 1;
+
+    void write_lookahead_cache(const std::string &filename)
+    {
+        std::ofstream out(filename, std::ios::binary);
+        if (!out)
+            log_error("Failed to open router2 lookahead cache '%s' for writing.\n", filename.c_str());
+        auto write_u32 = [&](uint32_t v) { out.write(reinterpret_cast<const char *>(&v), sizeof(v)); };
+        auto write_str = [&](const std::string &s) {
+            write_u32(uint32_t(s.size()));
+            out.write(s.data(), s.size());
+        };
+        out.write("NPNRR2LA", 8);
+        write_u32(la_cache_version);
+        write_str(ctx->getChipName());
+        write_u32(uint32_t(flat_wires.size()));
+        write_u32(uint32_t(la_radius));
+        write_u32(uint32_t(cfg.lookahead_samples));
+        write_u32(uint32_t(la_classes.size()));
+        for (auto cls : la_classes)
+            write_str(cls.str(ctx));
+        out.write(reinterpret_cast<const char *>(&la_slope), sizeof(la_slope));
+        out.write(reinterpret_cast<const char *>(la_table.data()), la_table.size() * sizeof(float));
+        if (!out)
+            log_error("Failed to write router2 lookahead cache '%s'.\n", filename.c_str());
+    }
+
+    bool read_lookahead_cache(const std::string &filename)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+            return false;
+        auto read_u32 = [&]() {
+            uint32_t v = 0;
+            in.read(reinterpret_cast<char *>(&v), sizeof(v));
+            return v;
+        };
+        auto read_str = [&]() {
+            std::string s(read_u32(), '\0');
+            in.read(&s[0], s.size());
+            return s;
+        };
+        char magic[8];
+        in.read(magic, 8);
+        if (!in || std::string(magic, 8) != "NPNRR2LA" || read_u32() != la_cache_version ||
+            read_str() != ctx->getChipName() || read_u32() != flat_wires.size() || read_u32() != uint32_t(la_radius) ||
+            read_u32() != uint32_t(cfg.lookahead_samples) || read_u32() != la_classes.size())
+            return false;
+        for (auto cls : la_classes)
+            if (read_str() != cls.str(ctx))
+                return false;
+        in.read(reinterpret_cast<char *>(&la_slope), sizeof(la_slope));
+        la_table.resize(la_classes.size() * la_side * la_side);
+        in.read(reinterpret_cast<char *>(la_table.data()), la_table.size() * sizeof(float));
+        return bool(in);
+    }
+
+    void setup_lookahead()
+    {
+        use_lookahead = true;
+        la_radius = cfg.lookahead_radius;
+        la_side = 2 * la_radius + 1;
+        dict<IdString, int> class_idx;
+        la_wire_class.reserve(flat_wires.size());
+        for (auto &wd : flat_wires) {
+            IdString type = ctx->getWireType(wd.w);
+            auto fnd = class_idx.find(type);
+            if (fnd == class_idx.end()) {
+                fnd = class_idx.emplace(type, int(la_classes.size())).first;
+                la_classes.push_back(type);
+            }
+            la_wire_class.push_back(fnd->second);
+        }
+        if (!cfg.lookahead_cache.empty() && read_lookahead_cache(cfg.lookahead_cache)) {
+            log_info("    loaded lookahead for %d wire types from '%s'\n", int(la_classes.size()),
+                     cfg.lookahead_cache.c_str());
+            return;
+        }
+        build_lookahead();
+        if (!cfg.lookahead_cache.empty()) {
+            write_lookahead_cache(cfg.lookahead_cache);
+            log_info("    wrote lookahead to '%s'\n", cfg.lookahead_cache.c_str());
+        }
+    }
+
     dict<GroupId, int> resource_to_idx;
     dict<WireId, int> wire_to_resource;
     std::vector<PerResourceData> flat_resources;
@@ -459,21 +716,22 @@ struct Router2
         ad.pre_routed = false;
     }
 
-    float score_wire_for_arc(NetInfo *net, store_index<PortRef> user, size_t phys_pin, WireId wire, PipId pip,
+    float score_wire_for_arc(NetInfo *net, store_index<PortRef> user, size_t phys_pin, int wire, PipId pip,
                              float crit_weight)
     {
-        auto &wd = wire_data(wire);
+        auto &wd = flat_wires[wire];
         auto &nd = nets.at(net->udata);
-        float base_cost = cfg.get_base_cost(ctx, wire, pip, crit_weight);
+        float base_cost = cfg.get_base_cost(ctx, wd.w, pip, crit_weight);
         int overuse = wd.curr_cong;
         float hist_cost = 1.0f + crit_weight * (wd.hist_cong_cost - 1.0f);
         float bias_cost = 0;
         float resource_hist_cost = 0.0f;
         float resource_present_cost = 0.0f;
         int source_uses = 0;
-        if (nd.wires.count(wire)) {
+        auto fnd_wire = find_net_wire(nd, wd);
+        if (fnd_wire != nd.wires.end()) {
             overuse -= 1;
-            source_uses = nd.wires.at(wire).second;
+            source_uses = fnd_wire->second.second;
         }
         float present_cost = 1.0f + overuse * curr_cong_weight * crit_weight;
         if (pip != PipId()) {
@@ -482,9 +740,8 @@ struct Router2
                         ((std::abs(pl.x - nd.cx) + std::abs(pl.y - nd.cy)) / float(nd.hpwl));
         }
 
-        auto resource_key = wire_to_resource.find(wire);
-        if (resource_key != wire_to_resource.end()) {
-            auto &rd = flat_resources.at(resource_key->second);
+        if (wd.resource != -1) {
+            auto &rd = flat_resources.at(wd.resource);
             resource_hist_cost = 1.0f + crit_weight * (rd.hist_cong_cost - 1.0f);
             resource_present_cost = 1.0f + rd.value_count.size() * curr_cong_weight * crit_weight;
         }
@@ -498,12 +755,16 @@ struct Router2
         auto &nd = nets.at(net->udata);
         auto &wd = flat_wires[wire];
         int source_uses = 0;
-        if (nd.wires.count(wd.w)) {
-            source_uses = nd.wires.at(wd.w).second;
-        }
+        auto fnd_wire = find_net_wire(nd, wd);
+        if (fnd_wire != nd.wires.end())
+            source_uses = fnd_wire->second.second;
         // FIXME: timing/wirelength balance?
-        delay_t est_delay = ctx->estimateDelay(bwd ? src_sink : wd.w, bwd ? wd.w : src_sink);
-        return (ctx->getDelayNS(est_delay) / (1 + source_uses * crit_weight)) + cfg.ipin_cost_adder;
+        float est_cost = -1;
+        if (use_lookahead)
+            est_cost = bwd ? lookahead_cost(wire_idx(src_sink), wire) : lookahead_cost(wire, wire_idx(src_sink));
+        if (est_cost < 0)
+            est_cost = ctx->getDelayNS(ctx->estimateDelay(bwd ? src_sink : wd.w, bwd ? wd.w : src_sink));
+        return (est_cost / (1 + source_uses * crit_weight)) + cfg.ipin_cost_adder;
     }
 
     bool check_arc_routing(NetInfo *net, store_index<PortRef> usr, size_t phys_pin)
@@ -541,9 +802,8 @@ struct Router2
         WireId src = nets.at(net->udata).src_wire;
         WireId cursor = ad.sink_wire;
         while (cursor != src) {
-            size_t wire_idx = wire_to_idx.at(cursor);
             PipId pip = nd.wires.at(cursor).first;
-            bind_pip_internal(nd, usr, wire_idx, pip);
+            bind_pip_internal(nd, usr, wire_idx(cursor), pip);
             cursor = ctx->getPipSrcWire(pip);
         }
     }
@@ -802,8 +1062,8 @@ struct Router2
         if (dst_wire == WireId())
             ARC_LOG_ERR("No wire found for port %s on destination cell %s.\n", ctx->nameOf(usr.port),
                         ctx->nameOf(usr.cell));
-        int src_wire_idx = const_mode ? -1 : wire_to_idx.at(src_wire);
-        int dst_wire_idx = wire_to_idx.at(dst_wire);
+        int src_wire_idx = const_mode ? -1 : wire_idx(src_wire);
+        int dst_wire_idx = wire_idx(dst_wire);
         // Calculate a timing weight based on criticality
         float crit = get_arc_crit(net, i);
         float crit_weight = std::max<float>(0.05f, (1.0f - std::pow(crit, 2)));
@@ -844,10 +1104,10 @@ struct Router2
                 WireScore base_score;
                 base_score.delay = 0;
                 base_score.cost = 0;
-                int wire_idx = wire_to_idx.at(wire);
-                base_score.togo_cost = get_togo_cost(net, i, wire_idx, dst_wire, false, crit_weight);
-                t.fwd_queue.push(QueuedWire(wire_idx, base_score));
-                set_visited_fwd(t, wire_idx, PipId(), 0.0);
+                int idx = wire_idx(wire);
+                base_score.togo_cost = get_togo_cost(net, i, idx, dst_wire, false, crit_weight);
+                t.fwd_queue.push(QueuedWire(idx, base_score));
+                set_visited_fwd(t, idx, PipId(), 0.0);
             };
             auto &dst_data = flat_wires.at(dst_wire_idx);
             // Look for nearby existing routing
@@ -876,10 +1136,10 @@ struct Router2
                 WireScore base_score;
                 base_score.delay = 0;
                 base_score.cost = 0;
-                int wire_idx = wire_to_idx.at(wire);
-                base_score.togo_cost = get_togo_cost(net, i, wire_idx, src_wire, true, crit_weight);
-                t.bwd_queue.push(QueuedWire(wire_idx, base_score));
-                set_visited_bwd(t, wire_idx, PipId(), 0.0);
+                int idx = wire_idx(wire);
+                base_score.togo_cost = get_togo_cost(net, i, idx, src_wire, true, crit_weight);
+                t.bwd_queue.push(QueuedWire(idx, base_score));
+                set_visited_bwd(t, idx, PipId(), 0.0);
             };
 
             // Seed backwards with the dest wire
@@ -904,31 +1164,24 @@ struct Router2
                         break;
                     }
                     auto &curr_data = flat_wires.at(curr.wire);
+                    int dh_cursor = dh_start[curr.wire];
                     for (PipId dh : ctx->getPipsDownhill(curr_data.w)) {
+                        int next_idx = dh_wires[dh_cursor++];
                         // Skip pips outside of box in bounding-box mode
                         if (is_bb && !hit_test_pip(nd.bb, ctx->getPipLocation(dh)))
                             continue;
                         if (!ctx->checkPipAvailForNet(dh, net))
                             continue;
-                        WireId next = ctx->getPipDstWire(dh);
-                        int next_idx = wire_to_idx.at(next);
-                        WireScore next_score;
-                        next_score.delay = curr.score.delay + cfg.get_base_cost(ctx, next, dh, crit_weight);
-                        next_score.cost = curr.score.cost + score_wire_for_arc(net, i, phys_pin, next, dh, crit_weight);
-                        next_score.togo_cost =
-                                cfg.estimate_weight * get_togo_cost(net, i, next_idx, dst_wire, false, crit_weight);
-                        if (was_visited_fwd(next_idx, next_score.delay)) {
-                            // Don't expand the same node twice.
-                            continue;
-                        }
-                        auto &nwd = flat_wires.at(next_idx);
+                        auto &nwd = flat_wires[next_idx];
                         if (nwd.unavailable)
                             continue;
                         // Reserved for another net
                         if (nwd.reserved_net != -1 && nwd.reserved_net != net->udata)
                             continue;
+                        if (!thread_test_wire(t, nwd))
+                            continue; // thread safety issue
                         // Don't allow the same wire to be bound to the same net with a different driving pip
-                        auto fnd_wire = nd.wires.find(next);
+                        auto fnd_wire = find_net_wire(nd, nwd);
                         if (fnd_wire != nd.wires.end() && fnd_wire->second.first != dh)
                             continue;
                         // Don't allow the same resource to be bound to the same net with a different value
@@ -939,8 +1192,16 @@ struct Router2
                                 fnd_resource->second.value != ctx->getResourceValueForPip(dh))
                                 continue;
                         }
-                        if (!thread_test_wire(t, nwd))
-                            continue; // thread safety issue
+                        WireScore next_score;
+                        next_score.delay = curr.score.delay + cfg.get_base_cost(ctx, nwd.w, dh, crit_weight);
+                        next_score.cost =
+                                curr.score.cost + score_wire_for_arc(net, i, phys_pin, next_idx, dh, crit_weight);
+                        next_score.togo_cost =
+                                cfg.estimate_weight * get_togo_cost(net, i, next_idx, dst_wire, false, crit_weight);
+                        if (was_visited_fwd(next_idx, next_score.delay)) {
+                            // Don't expand the same node twice.
+                            continue;
+                        }
                         set_visited_fwd(t, next_idx, dh, next_score.delay);
                         t.fwd_queue.push(QueuedWire(next_idx, next_score, t.rng.rng()));
                     }
@@ -974,36 +1235,27 @@ struct Router2
                     }
                     // Don't allow the same wire to be bound to the same net with a different driving pip
                     PipId bound_pip;
-                    auto fnd_wire = nd.wires.find(curr_data.w);
+                    auto fnd_wire = find_net_wire(nd, curr_data);
                     if (fnd_wire != nd.wires.end())
                         bound_pip = fnd_wire->second.first;
 
+                    int uh_cursor = uh_start[curr.wire];
                     for (PipId uh : ctx->getPipsUphill(curr_data.w)) {
+                        int next_idx = uh_wires[uh_cursor++];
                         if (bound_pip != PipId() && bound_pip != uh)
                             continue;
                         if (is_bb && !hit_test_pip(nd.bb, ctx->getPipLocation(uh)))
                             continue;
                         if (!ctx->checkPipAvailForNet(uh, net))
                             continue;
-                        WireId next = ctx->getPipSrcWire(uh);
-                        int next_idx = wire_to_idx.at(next);
-                        WireScore next_score;
-                        next_score.delay = curr.score.delay + cfg.get_base_cost(ctx, next, uh, crit_weight);
-                        next_score.cost = curr.score.cost + score_wire_for_arc(net, i, phys_pin, next, uh, crit_weight);
-                        next_score.togo_cost = const_mode
-                                                       ? 0
-                                                       : cfg.estimate_weight * get_togo_cost(net, i, next_idx, src_wire,
-                                                                                             true, crit_weight);
-                        if (was_visited_bwd(next_idx, next_score.delay)) {
-                            // Don't expand the same node twice.
-                            continue;
-                        }
-                        auto &nwd = flat_wires.at(next_idx);
+                        auto &nwd = flat_wires[next_idx];
                         if (nwd.unavailable)
                             continue;
                         // Reserved for another net
                         if (nwd.reserved_net != -1 && nwd.reserved_net != net->udata)
                             continue;
+                        if (!thread_test_wire(t, nwd))
+                            continue; // thread safety issue
                         // Don't allow the same resource to be bound to the same net with a different value
                         auto resource_key = ctx->getResourceKeyForPip(uh);
                         if (resource_key != GroupId()) {
@@ -1012,8 +1264,18 @@ struct Router2
                                 fnd_resource->second.value != ctx->getResourceValueForPip(uh))
                                 continue;
                         }
-                        if (!thread_test_wire(t, nwd))
-                            continue; // thread safety issue
+                        WireScore next_score;
+                        next_score.delay = curr.score.delay + cfg.get_base_cost(ctx, nwd.w, uh, crit_weight);
+                        next_score.cost =
+                                curr.score.cost + score_wire_for_arc(net, i, phys_pin, next_idx, uh, crit_weight);
+                        next_score.togo_cost = const_mode
+                                                       ? 0
+                                                       : cfg.estimate_weight * get_togo_cost(net, i, next_idx, src_wire,
+                                                                                             true, crit_weight);
+                        if (was_visited_bwd(next_idx, next_score.delay)) {
+                            // Don't expand the same node twice.
+                            continue;
+                        }
                         set_visited_bwd(t, next_idx, uh, next_score.delay);
                         t.bwd_queue.push(QueuedWire(next_idx, next_score, t.rng.rng()));
                     }
@@ -1022,6 +1284,7 @@ struct Router2
             if (midpoint_wire != -1)
                 break;
         }
+        total_explored += explored;
         ArcRouteResult result = ARC_SUCCESS;
         if (midpoint_wire != -1) {
             ROUTE_LOG_DBG("   Routed (explored %d wires): ", explored);
@@ -1051,7 +1314,7 @@ struct Router2
                         ROUTE_LOG_DBG("         fwd pip: %s (%d, %d)\n", ctx->nameOfPip(pip),
                                       ctx->getPipLocation(pip).x, ctx->getPipLocation(pip).y);
                     }
-                    cursor_bwd = wire_to_idx.at(ctx->getPipSrcWire(pip));
+                    cursor_bwd = wire_idx(ctx->getPipSrcWire(pip));
                 }
 
                 while (cursor_bwd != src_wire_idx) {
@@ -1069,7 +1332,7 @@ struct Router2
                     bind_pip_internal(nd, i, cursor_bwd, pip);
                     if (pip == PipId())
                         break;
-                    cursor_bwd = wire_to_idx.at(ctx->getPipSrcWire(pip));
+                    cursor_bwd = wire_idx(ctx->getPipSrcWire(pip));
                 }
 
                 NPNR_ASSERT(cursor_bwd == src_wire_idx);
@@ -1091,7 +1354,7 @@ struct Router2
                                   ctx->getPipLocation(pip).y);
                 }
 
-                cursor_fwd = wire_to_idx.at(ctx->getPipDstWire(pip));
+                cursor_fwd = wire_idx(ctx->getPipDstWire(pip));
                 bind_pip_internal(nd, i, cursor_fwd, pip);
                 if (ctx->debug && !is_mt) {
                     auto &wd = flat_wires.at(cursor_fwd);
@@ -1463,7 +1726,7 @@ struct Router2
         for (size_t i = 0; i < nets_by_udata.size(); i++) {
             IdString name = nets_by_udata.at(i)->name;
             for (const auto &wire : nets.at(i).wires) {
-                const auto &wd = flat_wires.at(wire_to_idx.at(wire.first));
+                const auto &wd = wire_data(wire.first);
                 if (wd.curr_cong > 1)
                     congestion_by_net[name] += (wd.curr_cong - 1);
             }
@@ -1473,51 +1736,146 @@ struct Router2
             out << u.first.c_str(ctx) << "," << u.second << std::endl;
     }
 
-    int mid_x = 0, mid_y = 0;
+    // The device is recursively bisected into as many leaf regions as there are threads. Nets that fit entirely
+    // inside a leaf are routed in parallel; nets that cross a split line are routed at the deepest node that still
+    // contains them. Nodes at the same depth cover disjoint regions, so these can also be routed in parallel, working
+    // level-by-level back up the tree until only the nets crossing the root split remain.
+    struct PartitionNode
+    {
+        BoundingBox bb;
+        int depth = 0;
+        // Child nodes, or -1 for a leaf
+        int child[2] = {-1, -1};
+        // The first child covers coordinates <= split_pos along the split axis, the second those > split_pos
+        bool split_x = false;
+        int split_pos = 0;
+
+        bool is_leaf() const { return child[0] == -1; }
+    };
+
+    std::vector<PartitionNode> partition;
+    // Groups of mutually disjoint partition nodes, in the order they are routed
+    std::vector<std::vector<int>> partition_levels;
 
-    void partition_nets()
+    struct PartitionLevelStats
     {
-        // Create a histogram of positions in X and Y positions
-        std::map<int, int> cxs, cys;
-        for (auto &n : nets) {
-            if (n.cx != -1)
-                ++cxs[n.cx];
-            if (n.cy != -1)
-                ++cys[n.cy];
+        int nets = 0;
+        float time = 0;
+    };
+    std::vector<PartitionLevelStats> partition_stats;
+    // Wires popped from the A* queues over all arcs, a measure of how well directed the search is
+    std::atomic<int64_t> total_explored{0};
+
+    void split_partition(int node, const std::vector<int> &node_nets, int leaves)
+    {
+        if (leaves <= 1)
+            return;
+        BoundingBox bb = partition.at(node).bb;
+        int x1 = std::min(bb.x1, ctx->getGridDimX() - 1), y1 = std::min(bb.y1, ctx->getGridDimY() - 1);
+        // Split along the longer axis of the region
+        bool split_x = (x1 - bb.x0) >= (y1 - bb.y0);
+        int lo = split_x ? bb.x0 : bb.y0, hi = split_x ? x1 : y1;
+        if (hi <= lo)
+            return; // region too small to split any further
+        // Create a histogram of net positions along the split axis
+        std::map<int, int> hist;
+        for (int n : node_nets) {
+            int c = split_x ? nets.at(n).cx : nets.at(n).cy;
+            if (c != -1)
+                ++hist[c];
         }
-        // 4-way split for now
-        int accum_x = 0, accum_y = 0;
-        int halfway = int(nets.size()) / 2;
-        for (auto &p : cxs) {
-            if (accum_x < halfway && (accum_x + p.second) >= halfway)
-                mid_x = p.first;
-            accum_x += p.second;
+        // Split so that the nets are divided in proportion to the number of leaves on each side
+        int left_leaves = leaves / 2;
+        int target = int((int64_t(node_nets.size()) * left_leaves) / leaves);
+        int split = lo + (hi - lo) / 2;
+        int accum = 0;
+        for (auto &p : hist) {
+            if (accum < target && (accum + p.second) >= target)
+                split = p.first;
+            accum += p.second;
         }
-        for (auto &p : cys) {
-            if (accum_y < halfway && (accum_y + p.second) >= halfway)
-                mid_y = p.first;
-            accum_y += p.second;
+        split = std::max(lo, std::min(hi - 1, split));
+
+        std::vector<int> child_nets[2];
+        for (int n : node_nets) {
+            int c = split_x ? nets.at(n).cx : nets.at(n).cy;
+            child_nets[c <= split ? 0 : 1].push_back(n);
         }
+        for (int i = 0; i < 2; i++) {
+            PartitionNode child;
+            child.bb = bb;
+            child.depth = partition.at(node).depth + 1;
+            if (split_x && i == 0)
+                child.bb.x1 = split;
+            else if (split_x)
+                child.bb.x0 = split + 1;
+            else if (i == 0)
+                child.bb.y1 = split;
+            else
+                child.bb.y0 = split + 1;
+            partition.at(node).child[i] = int(partition.size());
+            partition.push_back(child);
+        }
+        partition.at(node).split_x = split_x;
+        partition.at(node).split_pos = split;
+        split_partition(partition.at(node).child[0], child_nets[0], left_leaves);
+        split_partition(partition.at(node).child[1], child_nets[1], leaves - left_leaves);
+    }
+
+    void partition_nets()
+    {
+        partition.clear();
+        partition.emplace_back();
+        partition.back().bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+        std::vector<int> all_nets(nets.size());
+        std::iota(all_nets.begin(), all_nets.end(), 0);
+        split_partition(0, all_nets, cfg.threads);
+
+        // All leaves are disjoint and routed first, then the interior nodes from the bottom of the tree up. The root
+        // is routed single-threaded at the end, so isn't included here.
+        partition_levels.clear();
+        int max_depth = 0;
+        for (auto &pn : partition)
+            max_depth = std::max(max_depth, pn.depth);
+        partition_levels.emplace_back();
+        for (int i = 1; i < int(partition.size()); i++)
+            if (partition.at(i).is_leaf())
+                partition_levels.back().push_back(i);
+        for (int d = max_depth - 1; d >= 1; d--) {
+            partition_levels.emplace_back();
+            for (int i = 1; i < int(partition.size()); i++)
+                if (!partition.at(i).is_leaf() && partition.at(i).depth == d)
+                    partition_levels.back().push_back(i);
+        }
+        partition_stats.clear();
+        partition_stats.resize(partition_levels.size() + 1);
+
         if (ctx->verbose) {
-            log_info("    x splitpoint: %d\n", mid_x);
-            log_info("    y splitpoint: %d\n", mid_y);
+            log_info("    partitioned into %d regions over %d levels\n", int(partition_levels.front().size()),
+                     int(partition_levels.size()));
+            for (auto &pn : partition) {
+                if (pn.is_leaf())
+                    continue;
+                log_info("        depth %d: %c splitpoint %d\n", pn.depth, pn.split_x ? 'x' : 'y', pn.split_pos);
+            }
         }
-        std::vector<int> bins(5, 0);
-        for (auto &n : nets) {
-            if (n.bb.x0 < mid_x && n.bb.x1 < mid_x && n.bb.y0 < mid_y && n.bb.y1 < mid_y)
-                ++bins[0]; // TL
-            else if (n.bb.x0 >= mid_x && n.bb.x1 >= mid_x && n.bb.y0 < mid_y && n.bb.y1 < mid_y)
-                ++bins[1]; // TR
-            else if (n.bb.x0 < mid_x && n.bb.x1 < mid_x && n.bb.y0 >= mid_y && n.bb.y1 >= mid_y)
-                ++bins[2]; // BL
-            else if (n.bb.x0 >= mid_x && n.bb.x1 >= mid_x && n.bb.y0 >= mid_y && n.bb.y1 >= mid_y)
-                ++bins[3]; // BR
+    }
+
+    // Find the deepest partition node that fully contains the bounding box of a net
+    int find_partition(const PerNetData &nd)
+    {
+        int node = 0;
+        while (!partition.at(node).is_leaf()) {
+            auto &pn = partition.at(node);
+            int lo = pn.split_x ? nd.bb.x0 : nd.bb.y0, hi = pn.split_x ? nd.bb.x1 : nd.bb.y1;
+            if (hi < pn.split_pos)
+                node = pn.child[0];
+            else if (lo > pn.split_pos)
+                node = pn.child[1];
             else
-                ++bins[4]; // cross-boundary
+                break;
         }
-        if (ctx->verbose)
-            for (int i = 0; i < 5; i++)
-                log_info("        bin %d N=%d\n", i, bins[i]);
+        return node;
     }
 
     void router_thread(ThreadContext &t, bool is_mt)
@@ -1532,7 +1890,7 @@ struct Router2
     void do_route()
     {
         // Don't multithread if fewer than 200 nets (heuristic)
-        if (route_queue.size() < 200) {
+        if (route_queue.size() < 200 || partition.size() == 1) {
             ThreadContext st;
             st.rng.rngseed(ctx->rng64());
             st.bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
@@ -1541,103 +1899,51 @@ struct Router2
             }
             return;
         }
-        const int Nq = 4, Nv = 2, Nh = 2;
-        const int N = Nq + Nv + Nh;
-        std::vector<ThreadContext> tcs(N + 1);
-        for (auto &th : tcs) {
-            th.rng.rngseed(ctx->rng64());
-        }
-        int le_x = mid_x;
-        int rs_x = mid_x;
-        int le_y = mid_y;
-        int rs_y = mid_y;
-        // Set up thread bounding boxes
-        tcs.at(0).bb = BoundingBox(0, 0, mid_x, mid_y);
-        tcs.at(1).bb = BoundingBox(mid_x + 1, 0, std::numeric_limits<int>::max(), le_y);
-        tcs.at(2).bb = BoundingBox(0, mid_y + 1, mid_x, std::numeric_limits<int>::max());
-        tcs.at(3).bb =
-                BoundingBox(mid_x + 1, mid_y + 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(4).bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), mid_y);
-        tcs.at(5).bb = BoundingBox(0, mid_y + 1, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(6).bb = BoundingBox(0, 0, mid_x, std::numeric_limits<int>::max());
-        tcs.at(7).bb = BoundingBox(mid_x + 1, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        tcs.at(8).bb = BoundingBox(0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
-
-        for (auto n : route_queue) {
-            auto &nd = nets.at(n);
-            auto ni = nets_by_udata.at(n);
-            int bin = N;
-            // Quadrants
-            if (nd.bb.x0 < le_x && nd.bb.x1 < le_x && nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = 0;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x && nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = 1;
-            else if (nd.bb.x0 < le_x && nd.bb.x1 < le_x && nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = 2;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x && nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = 3;
-            // Vertical split
-            else if (nd.bb.y0 < le_y && nd.bb.y1 < le_y)
-                bin = Nq + 0;
-            else if (nd.bb.y0 >= rs_y && nd.bb.y1 >= rs_y)
-                bin = Nq + 1;
-            // Horizontal split
-            else if (nd.bb.x0 < le_x && nd.bb.x1 < le_x)
-                bin = Nq + Nv + 0;
-            else if (nd.bb.x0 >= rs_x && nd.bb.x1 >= rs_x)
-                bin = Nq + Nv + 1;
-            tcs.at(bin).route_nets.push_back(ni);
+        std::vector<ThreadContext> tcs(partition.size());
+        for (size_t i = 0; i < partition.size(); i++) {
+            tcs.at(i).rng.rngseed(ctx->rng64());
+            tcs.at(i).bb = partition.at(i).bb;
         }
+
+        for (auto n : route_queue)
+            tcs.at(find_partition(nets.at(n))).route_nets.push_back(nets_by_udata.at(n));
         if (ctx->verbose)
-            log_info("%d/%d nets not multi-threadable\n", int(tcs.at(N).route_nets.size()), int(route_queue.size()));
-#ifdef NPNR_DISABLE_THREADS
-        // Singlethreaded routing - quadrants
-        for (int i = 0; i < Nq; i++) {
-            router_thread(tcs.at(i), /*is_mt=*/false);
-        }
-        // Vertical splits
-        for (int i = Nq; i < Nq + Nv; i++) {
-            router_thread(tcs.at(i), /*is_mt=*/false);
-        }
-        // Horizontal splits
-        for (int i = Nq + Nv; i < Nq + Nv + Nh; i++) {
-            router_thread(tcs.at(i), /*is_mt=*/false);
-        }
-#else
-        // Multithreaded part of routing - quadrants
-        std::vector<boost::thread> threads;
-        for (int i = 0; i < Nq; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i), /*is_mt=*/true); });
-        }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-        // Vertical splits
-        for (int i = Nq; i < Nq + Nv; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i), /*is_mt=*/true); });
-        }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-        // Horizontal splits
-        for (int i = Nq + Nv; i < Nq + Nv + Nh; i++) {
-            threads.emplace_back([this, &tcs, i]() { router_thread(tcs.at(i), /*is_mt=*/true); });
+            log_info("%d/%d nets not multi-threadable\n", int(tcs.at(0).route_nets.size()), int(route_queue.size()));
+
+        for (size_t l = 0; l < partition_levels.size(); l++) {
+            auto &level = partition_levels.at(l);
+            auto level_start = std::chrono::high_resolution_clock::now();
+            int level_nets = 0;
+            for (int i : level)
+                level_nets += int(tcs.at(i).route_nets.size());
+            ctx->thread_pool().run("router2/partition", int(level.size()), [this, &tcs, &level](int i) {
+                auto &tc = tcs.at(level.at(i));
+                if (!tc.route_nets.empty())
+                    router_thread(tc, /*is_mt=*/true);
+            });
+            auto level_end = std::chrono::high_resolution_clock::now();
+            float level_time = std::chrono::duration<float>(level_end - level_start).count();
+            partition_stats.at(l).nets += level_nets;
+            partition_stats.at(l).time += level_time;
+            if (ctx->verbose)
+                log_info("        level %d: %d regions, %d nets, %.02fs\n", int(l), int(level.size()), level_nets,
+                         level_time);
         }
-        for (auto &t : threads)
-            t.join();
-        threads.clear();
-#endif
-        // Singlethreaded part of routing - nets that cross partitions
+        // Singlethreaded part of routing - nets that cross the root split
         // or don't fit within bounding box
-        for (auto st_net : tcs.at(N).route_nets)
-            route_net(tcs.at(N), st_net, false);
+        auto st_start = std::chrono::high_resolution_clock::now();
+        int st_nets = int(tcs.at(0).route_nets.size());
+        for (auto st_net : tcs.at(0).route_nets)
+            route_net(tcs.at(0), st_net, false);
         // Failed nets
-        for (int i = 0; i < N; i++)
+        for (int i = 1; i < int(tcs.size()); i++) {
+            st_nets += int(tcs.at(i).failed_nets.size());
             for (auto fail : tcs.at(i).failed_nets)
-                route_net(tcs.at(N), fail, false);
+                route_net(tcs.at(0), fail, false);
+        }
+        auto st_end = std::chrono::high_resolution_clock::now();
+        partition_stats.back().nets += st_nets;
+        partition_stats.back().time += std::chrono::duration<float>(st_end - st_start).count();
     }
 
     delay_t get_route_delay(int net, store_index<PortRef> usr_idx, int phys_idx)
@@ -1690,6 +1996,8 @@ struct Router2
         setup_resources();
         setup_nets();
         setup_wires();
+        if (cfg.lookahead)
+            setup_lookahead();
         find_all_reserved_wires();
         partition_nets();
         curr_cong_weight = cfg.init_curr_cong_weight;
@@ -1794,6 +2102,7 @@ struct Router2
             ++iter;
             if (curr_cong_weight < 1e9)
                 curr_cong_weight += cfg.curr_cong_mult;
+            ctx->yield();
         } while (!failed_nets.empty());
         if (cfg.perf_profile) {
             std::vector<std::pair<int, IdString>> nets_by_runtime;
@@ -1808,10 +2117,36 @@ struct Router2
                     nets_by_runtime.at(i).first / 1000.0);
             }
         }
+        if (cfg.perf_profile || ctx->verbose) {
+            log_info("Router2 time by partition level:\n");
+            for (int l = 0; l < int(partition_stats.size()); l++) {
+                auto &ps = partition_stats.at(l);
+                if (l == int(partition_stats.size()) - 1)
+                    log_info("    single-threaded: %8d nets %8.02fs\n", ps.nets, ps.time);
+                else
+                    log_info("    level %2d (%3d): %8d nets %8.02fs\n", l, int(partition_levels.at(l).size()), ps.nets,
+                             ps.time);
+            }
+            log_info("Router2 explored %lld wires in total\n", (long long)total_explored.load());
+        }
         auto rend = std::chrono::high_resolution_clock::now();
         log_info("Router2 time %.02fs\n", std::chrono::duration<float>(rend - rstart).count());
 
-        log_info("Running router1 to check that route is legal...\n");
+        log_info("Checking that route is legal...\n");
+        int illegal_nets = check_routing(ctx);
+        if (illegal_nets == 0) {
+            log_info("Route is legal.\n");
+#ifndef NDEBUG
+            ctx->check();
+            log_assert(ctx->checkRoutedDesign());
+#endif
+            log_info("Checksum: 0x%08x\n", ctx->checksum());
+            timing_analysis(ctx, true /* slack_histogram */, true /* print_fmax */, true /* print_path */,
+                            true /* warn_on_failure */, true /* update_results */);
+            return;
+        }
+
+        log_info("%d nets need repair, running router1...\n", illegal_nets);
 
         lock.unlock();
 
@@ -1846,11 +2181,16 @@ Router2Cfg::Router2Cfg(Context *ctx)
         curr_cong_mult = ctx->setting<float>("router2/currCongWeightMult", 2.0f);
         estimate_weight = ctx->setting<float>("router2/estimateWeight", 1.25f);
     }
+    threads = std::max(1, ctx->setting<int>("threads", 4));
     perf_profile = ctx->setting<bool>("router2/perfProfile", false);
     if (ctx->settings.count(ctx->id("router2/heatmap")))
         heatmap = ctx->settings.at(ctx->id("router2/heatmap")).as_string();
     else
         heatmap = "";
+    lookahead = ctx->setting<bool>("router2/lookahead", false);
+    lookahead_radius = ctx->setting<int>("router2/lookaheadRadius", 12);
+    lookahead_samples = ctx->setting<int>("router2/lookaheadSamples", 4);
+    lookahead_cache = str_or_default(ctx->settings, ctx->id("router2/lookaheadCache"), "");
 }
 
 NEXTPNR_NAMESPACE_END
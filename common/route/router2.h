@@ -54,6 +54,16 @@ struct Router2Cfg
     // of choosing a less congestion/delay-optimal route
     float estimate_weight;
 
+    // Number of regions the device is partitioned into for multithreaded routing
+    int threads;
+
+    // Use a precomputed per-wire-type lookahead table, rather than estimateDelay, for the A* cost estimate
+    bool lookahead;
+    // Maximum (dx, dy) offset covered by the lookahead table, and number of sample wires expanded per wire type
+    int lookahead_radius, lookahead_samples;
+    // File the lookahead is loaded from, or saved to if missing or built for a different device; empty for no cache
+    std::string lookahead_cache;
+
     // Print additional performance profiling information
     bool perf_profile = false;
 
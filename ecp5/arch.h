@@ -474,14 +474,10 @@ struct Arch : BaseArch<ArchRanges>
 
     struct LogicTileStatus
     {
-        // Per-SLICE valid and dirty bits
-        struct SliceStatus
-        {
-            bool valid = true, dirty = true;
-        } slices[4];
+        // Per-SLICE legality
+        CachedLegality slices[4];
         // Per-tile legality check for control set legality
-        bool tile_valid = true;
-        bool tile_dirty = true;
+        CachedLegality tile;
         // Fast index from z-pos to cell
         std::array<CellInfo *, 8 * (1 << lc_idx_shift)> cells;
     };
@@ -569,11 +565,11 @@ struct Arch : BaseArch<ArchRanges>
             LogicTileStatus *lts = tile_status.at(tile_index(bel)).lts;
             NPNR_ASSERT(lts != nullptr);
             int z = loc_info(bel)->bel_data[bel.index].z;
-            lts->slices[(z >> lc_idx_shift) / 2].dirty = true;
+            lts->slices[(z >> lc_idx_shift) / 2].invalidate();
             if (act_cell->type == id_TRELLIS_FF)
-                lts->tile_dirty = true; // because FF CLK/LSR signals are tile-wide
+                lts->tile.invalidate(); // because FF CLK/LSR signals are tile-wide
             if (act_cell->type == id_TRELLIS_COMB && (act_cell->combInfo.flags & ArchCellInfo::COMB_LUTRAM))
-                lts->tile_dirty = true; // because RAM shares CLK/LSR signals with FFs
+                lts->tile.invalidate(); // because RAM shares CLK/LSR signals with FFs
             lts->cells[z] = new_cell;
         }
     }
@@ -1013,6 +1009,8 @@ struct Arch : BaseArch<ArchRanges>
 
     // Helper function for above
     bool slices_compatible(LogicTileStatus *lts) const;
+    bool slice_valid(const LogicTileStatus *lts, int sl) const;
+    bool tile_ctrlset_valid(const LogicTileStatus *lts) const;
 
     void assign_arch_info_for_cell(CellInfo *ci);
     void assignArchInfo() override;
@@ -37,144 +37,136 @@ bool Arch::slices_compatible(LogicTileStatus *lts) const
 {
     if (lts == nullptr)
         return true;
-    for (int sl = 0; sl < 4; sl++) {
-        if (!lts->slices[sl].dirty) {
-            if (!lts->slices[sl].valid)
+    for (int sl = 0; sl < 4; sl++)
+        if (!lts->slices[sl].get(legality_stats, [&]() { return slice_valid(lts, sl); }))
+            return false;
+    return lts->tile.get(legality_stats, [&]() { return tile_ctrlset_valid(lts); });
+}
+
+bool Arch::slice_valid(const LogicTileStatus *lts, int sl) const
+{
+    bool found_ff = false;
+    uint8_t last_ff_flags = 0;
+    IdString last_ce_sig;
+    bool ramw_used = false;
+    if (sl == 2 && lts->cells[((sl * 2) << lc_idx_shift) | BEL_RAMW] != nullptr)
+        ramw_used = true;
+    for (int l = 0; l < 2; l++) {
+        bool comb_m_used = false;
+        CellInfo *comb = lts->cells[((sl * 2 + l) << lc_idx_shift) | BEL_COMB];
+        if (comb != nullptr) {
+            uint8_t flags = comb->combInfo.flags;
+            if (ramw_used && !(flags & ArchCellInfo::COMB_RAMW_BLOCK))
                 return false;
-            continue;
-        }
-        lts->slices[sl].dirty = false;
-        lts->slices[sl].valid = false;
-        bool found_ff = false;
-        uint8_t last_ff_flags = 0;
-        IdString last_ce_sig;
-        bool ramw_used = false;
-        if (sl == 2 && lts->cells[((sl * 2) << lc_idx_shift) | BEL_RAMW] != nullptr)
-            ramw_used = true;
-        for (int l = 0; l < 2; l++) {
-            bool comb_m_used = false;
-            CellInfo *comb = lts->cells[((sl * 2 + l) << lc_idx_shift) | BEL_COMB];
-            if (comb != nullptr) {
-                uint8_t flags = comb->combInfo.flags;
-                if (ramw_used && !(flags & ArchCellInfo::COMB_RAMW_BLOCK))
+            if (flags & ArchCellInfo::COMB_MUX5) {
+                // MUX5 uses M signal and must be in LC 0
+                comb_m_used = true;
+                if (l != 0)
                     return false;
-                if (flags & ArchCellInfo::COMB_MUX5) {
-                    // MUX5 uses M signal and must be in LC 0
-                    comb_m_used = true;
-                    if (l != 0)
-                        return false;
-                }
-                if (flags & ArchCellInfo::COMB_MUX6) {
-                    // MUX6+ uses M signal and must be in LC 1
-                    comb_m_used = true;
-                    if (l != 1)
-                        return false;
-                    if (comb->combInfo.mux_fxad != nullptr &&
-                        (comb->combInfo.mux_fxad->combInfo.flags & ArchCellInfo::COMB_MUX5)) {
-                        // LUT6 structure must be rooted at SLICE 0 or 2
-                        if (sl != 0 && sl != 2)
-                            return false;
-                    }
-                }
-                // LUTRAM must be in bottom two SLICEs only
-                if ((flags & ArchCellInfo::COMB_LUTRAM) && (sl > 1))
+            }
+            if (flags & ArchCellInfo::COMB_MUX6) {
+                // MUX6+ uses M signal and must be in LC 1
+                comb_m_used = true;
+                if (l != 1)
                     return false;
-                if (l == 1) {
-                    // Carry usage must be the same for LCs 0 and 1 in a SLICE
-                    CellInfo *comb0 = lts->cells[((sl * 2 + 0) << lc_idx_shift) | BEL_COMB];
-                    if (comb0 &&
-                        ((comb0->combInfo.flags & ArchCellInfo::COMB_CARRY) != (flags & ArchCellInfo::COMB_CARRY)))
+                if (comb->combInfo.mux_fxad != nullptr &&
+                    (comb->combInfo.mux_fxad->combInfo.flags & ArchCellInfo::COMB_MUX5)) {
+                    // LUT6 structure must be rooted at SLICE 0 or 2
+                    if (sl != 0 && sl != 2)
                         return false;
                 }
             }
-
-            CellInfo *ff = lts->cells[((sl * 2 + l) << lc_idx_shift) | BEL_FF];
-            if (ff != nullptr) {
-                uint8_t flags = ff->ffInfo.flags;
-                if (comb_m_used && (flags & ArchCellInfo::FF_M_USED))
+            // LUTRAM must be in bottom two SLICEs only
+            if ((flags & ArchCellInfo::COMB_LUTRAM) && (sl > 1))
+                return false;
+            if (l == 1) {
+                // Carry usage must be the same for LCs 0 and 1 in a SLICE
+                CellInfo *comb0 = lts->cells[((sl * 2 + 0) << lc_idx_shift) | BEL_COMB];
+                if (comb0 &&
+                    ((comb0->combInfo.flags & ArchCellInfo::COMB_CARRY) != (flags & ArchCellInfo::COMB_CARRY)))
                     return false;
-                if (found_ff) {
-                    if ((flags & ArchCellInfo::FF_GSREN) != (last_ff_flags & ArchCellInfo::FF_GSREN))
-                        return false;
-                    if ((flags & ArchCellInfo::FF_CECONST) != (last_ff_flags & ArchCellInfo::FF_CECONST))
-                        return false;
-                    if ((flags & ArchCellInfo::FF_CEINV) != (last_ff_flags & ArchCellInfo::FF_CEINV))
-                        return false;
-                    if (ff->ffInfo.ce_sig != last_ce_sig)
-                        return false;
-                } else {
-                    found_ff = true;
-                    last_ff_flags = flags;
-                    last_ce_sig = ff->ffInfo.ce_sig;
-                }
             }
         }
 
-        lts->slices[sl].valid = true;
+        CellInfo *ff = lts->cells[((sl * 2 + l) << lc_idx_shift) | BEL_FF];
+        if (ff != nullptr) {
+            uint8_t flags = ff->ffInfo.flags;
+            if (comb_m_used && (flags & ArchCellInfo::FF_M_USED))
+                return false;
+            if (found_ff) {
+                if ((flags & ArchCellInfo::FF_GSREN) != (last_ff_flags & ArchCellInfo::FF_GSREN))
+                    return false;
+                if ((flags & ArchCellInfo::FF_CECONST) != (last_ff_flags & ArchCellInfo::FF_CECONST))
+                    return false;
+                if ((flags & ArchCellInfo::FF_CEINV) != (last_ff_flags & ArchCellInfo::FF_CEINV))
+                    return false;
+                if (ff->ffInfo.ce_sig != last_ce_sig)
+                    return false;
+            } else {
+                found_ff = true;
+                last_ff_flags = flags;
+                last_ce_sig = ff->ffInfo.ce_sig;
+            }
+        }
     }
-    if (lts->tile_dirty) {
-        bool found_global_ff = false;
-        bool found_global_dpram = false;
-        bool global_lsrinv = false;
-        bool global_clkinv = false;
-        bool global_async = false;
+    return true;
+}
 
-        IdString clk_sig, lsr_sig;
+bool Arch::tile_ctrlset_valid(const LogicTileStatus *lts) const
+{
+    bool found_global_ff = false;
+    bool found_global_dpram = false;
+    bool global_lsrinv = false;
+    bool global_clkinv = false;
+    bool global_async = false;
 
-        lts->tile_dirty = false;
-        lts->tile_valid = false;
+    IdString clk_sig, lsr_sig;
 
 #define CHECK_EQUAL(x, y)                                                                                              \
     do {                                                                                                               \
         if ((x) != (y))                                                                                                \
             return false;                                                                                              \
     } while (0)
-        for (int i = 0; i < 8; i++) {
-            if (i < 4) {
-                // DPRAM
-                CellInfo *comb = lts->cells[(i << lc_idx_shift) | BEL_COMB];
-                if (comb != nullptr && (comb->combInfo.flags & ArchCellInfo::COMB_LUTRAM)) {
-                    if (found_global_dpram) {
-                        CHECK_EQUAL(bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WCKINV), global_clkinv);
-                        CHECK_EQUAL(bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WREINV), global_lsrinv);
-                    } else {
-                        global_clkinv = bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WCKINV);
-                        global_lsrinv = bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WREINV);
-                        found_global_dpram = true;
-                    }
-                }
-            }
-            // FF
-            CellInfo *ff = lts->cells[(i << lc_idx_shift) | BEL_FF];
-            if (ff != nullptr) {
+    for (int i = 0; i < 8; i++) {
+        if (i < 4) {
+            // DPRAM
+            CellInfo *comb = lts->cells[(i << lc_idx_shift) | BEL_COMB];
+            if (comb != nullptr && (comb->combInfo.flags & ArchCellInfo::COMB_LUTRAM)) {
                 if (found_global_dpram) {
-                    CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_CLKINV), global_clkinv);
-                    CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_LSRINV), global_lsrinv);
-                }
-                if (found_global_ff) {
-                    CHECK_EQUAL(ff->ffInfo.clk_sig, clk_sig);
-                    CHECK_EQUAL(ff->ffInfo.lsr_sig, lsr_sig);
-                    CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_CLKINV), global_clkinv);
-                    CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_LSRINV), global_lsrinv);
-                    CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_ASYNC), global_async);
-
+                    CHECK_EQUAL(bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WCKINV), global_clkinv);
+                    CHECK_EQUAL(bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WREINV), global_lsrinv);
                 } else {
-                    clk_sig = ff->ffInfo.clk_sig;
-                    lsr_sig = ff->ffInfo.lsr_sig;
-                    global_clkinv = bool(ff->ffInfo.flags & ArchCellInfo::FF_CLKINV);
-                    global_lsrinv = bool(ff->ffInfo.flags & ArchCellInfo::FF_LSRINV);
-                    global_async = bool(ff->ffInfo.flags & ArchCellInfo::FF_ASYNC);
-                    found_global_ff = true;
+                    global_clkinv = bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WCKINV);
+                    global_lsrinv = bool(comb->combInfo.flags & ArchCellInfo::COMB_RAM_WREINV);
+                    found_global_dpram = true;
                 }
             }
         }
-#undef CHECK_EQUAL
-        lts->tile_valid = true;
-    } else {
-        if (!lts->tile_valid)
-            return false;
-    }
+        // FF
+        CellInfo *ff = lts->cells[(i << lc_idx_shift) | BEL_FF];
+        if (ff != nullptr) {
+            if (found_global_dpram) {
+                CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_CLKINV), global_clkinv);
+                CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_LSRINV), global_lsrinv);
+            }
+            if (found_global_ff) {
+                CHECK_EQUAL(ff->ffInfo.clk_sig, clk_sig);
+                CHECK_EQUAL(ff->ffInfo.lsr_sig, lsr_sig);
+                CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_CLKINV), global_clkinv);
+                CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_LSRINV), global_lsrinv);
+                CHECK_EQUAL(bool(ff->ffInfo.flags & ArchCellInfo::FF_ASYNC), global_async);
 
+            } else {
+                clk_sig = ff->ffInfo.clk_sig;
+                lsr_sig = ff->ffInfo.lsr_sig;
+                global_clkinv = bool(ff->ffInfo.flags & ArchCellInfo::FF_CLKINV);
+                global_lsrinv = bool(ff->ffInfo.flags & ArchCellInfo::FF_LSRINV);
+                global_async = bool(ff->ffInfo.flags & ArchCellInfo::FF_ASYNC);
+                found_global_ff = true;
+            }
+        }
+    }
+#undef CHECK_EQUAL
     return true;
 }
 
@@ -60,8 +60,9 @@ class Ecp5Packer
     void flush_cells()
     {
         for (auto pcell : packed_cells) {
-            ctx->cells.erase(pcell);
+            ctx->markCellForDeletion(pcell);
         }
+        ctx->flushDeletions();
         for (auto &ncell : new_cells) {
             ctx->cells[ncell->name] = std::move(ncell);
         }
@@ -193,9 +194,9 @@ class Ecp5Packer
     {
         Arch::LogicTileStatus lts;
         std::fill(lts.cells.begin(), lts.cells.end(), nullptr);
-        lts.tile_dirty = true;
+        lts.tile.invalidate();
         for (auto &sl : lts.slices)
-            sl.dirty = true;
+            sl.invalidate();
 
         auto process_cell = [&](CellInfo *ci) {
             if (get_macro_cell_xy(ci) != get_macro_cell_xy(comb))
@@ -1039,8 +1040,6 @@ class Ecp5Packer
         vcc_net->driver.port = id_Z;
         vcc_cell->ports.at(id_Z).net = vcc_net.get();
 
-        std::vector<IdString> dead_nets;
-
         bool gnd_used = false, vcc_used = false;
 
         for (auto &net : ctx->nets) {
@@ -1049,16 +1048,17 @@ class Ecp5Packer
                 IdString drv_cell = ni->driver.cell->name;
                 set_net_constant(ctx, ni, gnd_net.get(), false);
                 gnd_used = true;
-                dead_nets.push_back(net.first);
-                ctx->cells.erase(drv_cell);
+                ctx->markNetForDeletion(net.first);
+                ctx->markCellForDeletion(drv_cell);
             } else if (ni->driver.cell != nullptr && ni->driver.cell->type == id_VCC) {
                 IdString drv_cell = ni->driver.cell->name;
                 set_net_constant(ctx, ni, vcc_net.get(), true);
                 vcc_used = true;
-                dead_nets.push_back(net.first);
-                ctx->cells.erase(drv_cell);
+                ctx->markNetForDeletion(net.first);
+                ctx->markCellForDeletion(drv_cell);
             }
         }
+        ctx->flushDeletions();
 
         if (gnd_used) {
             ctx->cells[gnd_cell->name] = std::move(gnd_cell);
@@ -1068,10 +1068,6 @@ class Ecp5Packer
             ctx->cells[vcc_cell->name] = std::move(vcc_cell);
             ctx->nets[vcc_net->name] = std::move(vcc_net);
         }
-
-        for (auto dn : dead_nets) {
-            ctx->nets.erase(dn);
-        }
     }
 
     void autocreate_empty_port(CellInfo *cell, IdString port)
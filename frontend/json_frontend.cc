@@ -19,58 +19,490 @@
 
 #include "json_frontend.h"
 #include "frontend_base.h"
-#include "json11.hpp"
 #include "log.h"
 #include "nextpnr.h"
 
+#include <algorithm>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <filesystem>
 #include <streambuf>
+#include <string_view>
 
 NEXTPNR_NAMESPACE_BEGIN
 
-using namespace json11;
+namespace {
+
+// A read-only view of a JSON document in memory, usually a memory mapped file. Unlike a DOM parser, nothing is built up
+// front: values are referred to by their offset into the buffer and objects and arrays are scanned as they are visited,
+// so memory use doesn't scale with the size of the netlist. validate() must be called once before anything else, the
+// other functions assume the document is well formed.
+struct JsonDocument
+{
+    JsonDocument(const char *data, size_t size, const std::string &filename)
+            : data(data), size(size), filename(filename) {};
+    const char *data;
+    size_t size;
+    const std::string &filename;
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+    static constexpr int max_depth = 200;
+
+    NPNR_NORETURN void error(size_t pos, const char *msg) const
+    {
+        int line = 1 + int(std::count(data, data + std::min(pos, size), '\n'));
+        log_error("Failed to parse JSON file '%s': %s on line %d.\n", filename.c_str(), msg, line);
+    }
+
+    char at(size_t pos) const { return pos < size ? data[pos] : '\0'; }
+
+    bool matches(size_t pos, const char *lit) const
+    {
+        size_t len = std::strlen(lit);
+        return pos + len <= size && std::memcmp(data + pos, lit, len) == 0;
+    }
+
+    // Skip whitespace, and comments as accepted by json11 in JsonParse::COMMENTS mode
+    size_t skip_ws(size_t pos) const
+    {
+        while (pos < size) {
+            char c = data[pos];
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                ++pos;
+            } else if (c == '/' && at(pos + 1) == '/') {
+                while (pos < size && data[pos] != '\n')
+                    ++pos;
+            } else if (c == '/' && at(pos + 1) == '*') {
+                size_t start = pos;
+                pos += 2;
+                while (pos + 1 < size && !(data[pos] == '*' && data[pos + 1] == '/'))
+                    ++pos;
+                if (pos + 1 >= size)
+                    error(start, "unterminated comment");
+                pos += 2;
+            } else {
+                break;
+            }
+        }
+        return pos;
+    }
+
+    // Skip the string whose opening quote is at pos, returning the offset after the closing quote
+    size_t skip_string(size_t pos, bool *has_escapes = nullptr) const
+    {
+        if (at(pos) != '"')
+            error(pos, "expected string");
+        ++pos;
+        while (true) {
+            const char *quote = static_cast<const char *>(std::memchr(data + pos, '"', size - pos));
+            if (quote == nullptr)
+                error(pos, "unterminated string");
+            const char *bs = static_cast<const char *>(std::memchr(data + pos, '\\', quote - (data + pos)));
+            if (bs == nullptr)
+                return (quote - data) + 1;
+            if (has_escapes != nullptr)
+                *has_escapes = true;
+            // Skip over the escaped character, which might be a quote
+            pos = (bs - data) + 2;
+            if (pos > size)
+                error(pos, "unterminated string");
+        }
+    }
+
+    uint32_t read_hex4(size_t pos) const
+    {
+        uint32_t value = 0;
+        for (size_t i = pos; i < pos + 4; i++) {
+            char c = at(i);
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= (c - '0');
+            else if (c >= 'a' && c <= 'f')
+                value |= (c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                value |= (c - 'A' + 10);
+            else
+                error(i, "bad \\u escape");
+        }
+        return value;
+    }
+
+    static void encode_utf8(uint32_t cp, std::string &out)
+    {
+        if (cp < 0x80) {
+            out.push_back(char(cp));
+        } else if (cp < 0x800) {
+            out.push_back(char(0xC0 | (cp >> 6)));
+            out.push_back(char(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(char(0xE0 | (cp >> 12)));
+            out.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (cp >> 18)));
+            out.push_back(char(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    // Decode the string whose opening quote is at pos into out, returning the offset after the closing quote
+    size_t read_string(size_t pos, std::string &out) const
+    {
+        bool has_escapes = false;
+        size_t end = skip_string(pos, &has_escapes);
+        if (!has_escapes) {
+            out.assign(data + pos + 1, end - pos - 2);
+            return end;
+        }
+        out.clear();
+        for (size_t i = pos + 1; i < end - 1; i++) {
+            char c = data[i];
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            char e = data[++i];
+            switch (e) {
+            case '"':
+            case '\\':
+            case '/':
+                out.push_back(e);
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u': {
+                uint32_t cp = read_hex4(i + 1);
+                i += 4;
+                // Combine UTF-16 surrogate pairs
+                if (cp >= 0xD800 && cp <= 0xDBFF && at(i + 1) == '\\' && at(i + 2) == 'u') {
+                    uint32_t low = read_hex4(i + 3);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                encode_utf8(cp, out);
+                break;
+            }
+            default:
+                error(i, "invalid escape character");
+            }
+        }
+        return end;
+    }
+
+    // The key string at pos; only decoded (into tmp) if it contains escapes
+    std::string_view read_key(size_t pos, std::string &tmp) const
+    {
+        bool has_escapes = false;
+        size_t end = skip_string(pos, &has_escapes);
+        if (!has_escapes)
+            return std::string_view(data + pos + 1, end - pos - 2);
+        read_string(pos, tmp);
+        return tmp;
+    }
+
+    size_t skip_number(size_t pos) const
+    {
+        size_t start = pos;
+        if (at(pos) == '-')
+            ++pos;
+        if (at(pos) == '0') {
+            ++pos;
+        } else if (at(pos) >= '1' && at(pos) <= '9') {
+            while (at(pos) >= '0' && at(pos) <= '9')
+                ++pos;
+        } else {
+            error(start, "invalid number");
+        }
+        if (at(pos) == '.') {
+            ++pos;
+            if (!(at(pos) >= '0' && at(pos) <= '9'))
+                error(start, "invalid number");
+            while (at(pos) >= '0' && at(pos) <= '9')
+                ++pos;
+        }
+        if (at(pos) == 'e' || at(pos) == 'E') {
+            ++pos;
+            if (at(pos) == '+' || at(pos) == '-')
+                ++pos;
+            if (!(at(pos) >= '0' && at(pos) <= '9'))
+                error(start, "invalid number");
+            while (at(pos) >= '0' && at(pos) <= '9')
+                ++pos;
+        }
+        return pos;
+    }
+
+    bool is_number(size_t pos) const
+    {
+        char c = at(pos);
+        return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    double read_number(size_t pos) const
+    {
+        size_t end = skip_number(pos);
+        std::string token(data + pos, end - pos);
+        return std::strtod(token.c_str(), nullptr);
+    }
+
+    // Equivalent of Json::int_value(), 0 for anything that isn't a number
+    int int_value(size_t pos) const
+    {
+        if (pos == npos || !is_number(pos))
+            return 0;
+        double value = read_number(pos);
+        return (value >= INT_MIN && value <= INT_MAX) ? int(value) : 0;
+    }
+
+    // Equivalent of Json::string_value(), empty for anything that isn't a string
+    std::string string_value(size_t pos) const
+    {
+        std::string result;
+        if (pos != npos && at(pos) == '"')
+            read_string(pos, result);
+        return result;
+    }
+
+    // Skip the value starting at pos, checking its syntax, and returning the offset after the end of it
+    size_t skip_value(size_t pos, int depth = 0) const
+    {
+        if (depth > max_depth)
+            error(pos, "exceeded maximum nesting depth");
+        char c = at(pos);
+        if (c == '{' || c == '[') {
+            char close = (c == '{') ? '}' : ']';
+            pos = skip_ws(pos + 1);
+            if (at(pos) == close)
+                return pos + 1;
+            while (true) {
+                if (c == '{') {
+                    pos = skip_ws(skip_string(pos));
+                    if (at(pos) != ':')
+                        error(pos, "expected ':' in object");
+                    pos = skip_ws(pos + 1);
+                }
+                pos = skip_ws(skip_value(pos, depth + 1));
+                if (at(pos) == close)
+                    return pos + 1;
+                if (at(pos) != ',')
+                    error(pos, (c == '{') ? "expected ',' or '}' in object" : "expected ',' or ']' in array");
+                pos = skip_ws(pos + 1);
+            }
+        } else if (c == '"') {
+            return skip_string(pos);
+        } else if (is_number(pos)) {
+            return skip_number(pos);
+        } else if (matches(pos, "true") || matches(pos, "null")) {
+            return pos + 4;
+        } else if (matches(pos, "false")) {
+            return pos + 5;
+        }
+        error(pos, "expected value");
+    }
+
+    // Check the whole document, returning the offset of the root value
+    size_t validate() const
+    {
+        size_t root = skip_ws(0);
+        size_t end = skip_ws(skip_value(root));
+        if (end != size)
+            error(end, "unexpected trailing characters");
+        return root;
+    }
+
+    // Call Func(key_pos, value_pos) for each member of the object at pos, in file order. Does nothing if pos isn't an
+    // object, matching the empty object_items() json11 gives in that case.
+    template <typename TFunc> void foreach_member_raw(size_t pos, TFunc Func) const
+    {
+        if (pos == npos || at(pos) != '{')
+            return;
+        pos = skip_ws(pos + 1);
+        if (at(pos) == '}')
+            return;
+        while (true) {
+            size_t key = pos;
+            size_t value = skip_ws(skip_ws(skip_string(pos)) + 1);
+            Func(key, value);
+            pos = skip_ws(skip_value(value));
+            if (at(pos) == '}')
+                return;
+            pos = skip_ws(pos + 1);
+        }
+    }
+
+    // Call Func(value_pos) for each element of the array at pos
+    template <typename TFunc> void foreach_element(size_t pos, TFunc Func) const
+    {
+        if (pos == npos || at(pos) != '[')
+            return;
+        pos = skip_ws(pos + 1);
+        if (at(pos) == ']')
+            return;
+        while (true) {
+            Func(pos);
+            pos = skip_ws(skip_value(pos));
+            if (at(pos) == ']')
+                return;
+            pos = skip_ws(pos + 1);
+        }
+    }
+
+    // Call Func(const std::string &key, value_pos) for each member of the object at pos. Members are visited in sorted
+    // key order with the last of any duplicates winning, like the std::map behind json11 objects; so the order cells
+    // and nets are created in doesn't depend on the parser.
+    template <typename TFunc> void foreach_member(size_t pos, TFunc Func) const
+    {
+        struct Member
+        {
+            std::string_view key;
+            size_t value;
+        };
+        std::vector<Member> members;
+        std::deque<std::string> decoded_keys;
+        std::string tmp;
+        foreach_member_raw(pos, [&](size_t key, size_t value) {
+            std::string_view key_str = read_key(key, tmp);
+            if (key_str.data() == tmp.data()) {
+                decoded_keys.push_back(tmp);
+                key_str = decoded_keys.back();
+            }
+            members.push_back(Member{key_str, value});
+        });
+        std::stable_sort(members.begin(), members.end(),
+                         [](const Member &a, const Member &b) { return a.key < b.key; });
+        std::string key;
+        for (size_t i = 0; i < members.size(); i++) {
+            if (i + 1 < members.size() && members.at(i + 1).key == members.at(i).key)
+                continue;
+            key.assign(members.at(i).key);
+            Func(key, members.at(i).value);
+        }
+    }
+
+    // Offset of the value of member key of the object at pos, or npos if there is no such member
+    size_t find_member(size_t pos, std::string_view key) const
+    {
+        size_t result = npos;
+        std::string tmp;
+        foreach_member_raw(pos, [&](size_t k, size_t value) {
+            if (read_key(k, tmp) == key)
+                result = value;
+        });
+        return result;
+    }
+};
+
+// Module data, with the location of each section found in a single scan of the module
+struct JsonModule
+{
+    size_t attributes = JsonDocument::npos, ports = JsonDocument::npos, cells = JsonDocument::npos,
+           netnames = JsonDocument::npos, settings = JsonDocument::npos;
+};
+
+struct JsonCell
+{
+    std::string type;
+    size_t attributes = JsonDocument::npos, parameters = JsonDocument::npos, port_directions = JsonDocument::npos,
+           connections = JsonDocument::npos;
+};
+
+// Module port or netname entry
+struct JsonObject
+{
+    size_t pos = JsonDocument::npos;
+};
+
+// Bit vectors are small, so are decoded on access. Signals are stored as their non-negative index, constants as
+// -1 - their character
+struct JsonBitVector
+{
+    static constexpr int invalid_constant = INT_MIN;
+    std::vector<int> bits;
+};
 
 struct JsonFrontendImpl
 {
     // See specification in frontend_base.h
-    JsonFrontendImpl(Json &root) : root(root) {};
-    Json &root;
-    typedef const Json &ModuleDataType;
-    typedef const Json &ModulePortDataType;
-    typedef const Json &CellDataType;
-    typedef const Json &NetnameDataType;
-    typedef const Json::array &BitVectorDataType;
+    JsonFrontendImpl(const JsonDocument &doc, size_t modules) : doc(doc), modules(modules) {};
+    const JsonDocument &doc;
+    size_t modules;
+    typedef JsonModule ModuleDataType;
+    typedef JsonObject ModulePortDataType;
+    typedef JsonCell CellDataType;
+    typedef JsonObject NetnameDataType;
+    typedef JsonBitVector BitVectorDataType;
 
     template <typename TFunc> void foreach_module(TFunc Func) const
     {
-        for (const auto &mod : root.object_items())
-            Func(mod.first, mod.second);
+        doc.foreach_member(modules, [&](const std::string &name, size_t pos) {
+            JsonModule mod;
+            std::string tmp;
+            doc.foreach_member_raw(pos, [&](size_t key, size_t value) {
+                std::string_view key_str = doc.read_key(key, tmp);
+                if (key_str == "attributes")
+                    mod.attributes = value;
+                else if (key_str == "ports")
+                    mod.ports = value;
+                else if (key_str == "cells")
+                    mod.cells = value;
+                else if (key_str == "netnames")
+                    mod.netnames = value;
+                else if (key_str == "settings")
+                    mod.settings = value;
+            });
+            Func(name, mod);
+        });
     }
 
-    template <typename TFunc> void foreach_port(ModuleDataType &mod, TFunc Func) const
+    template <typename TFunc> void foreach_port(const ModuleDataType &mod, TFunc Func) const
     {
-        const auto &ports = mod["ports"];
-        if (ports.is_null())
-            return;
-        for (const auto &port : ports.object_items())
-            Func(port.first, port.second);
+        doc.foreach_member(mod.ports, [&](const std::string &name, size_t pos) { Func(name, JsonObject{pos}); });
     }
 
-    template <typename TFunc> void foreach_cell(ModuleDataType &mod, TFunc Func) const
+    template <typename TFunc> void foreach_cell(const ModuleDataType &mod, TFunc Func) const
     {
-        const auto &cells = mod["cells"];
-        if (cells.is_null())
-            return;
-        for (const auto &cell : cells.object_items())
-            Func(cell.first, cell.second);
+        JsonCell cell;
+        std::string tmp;
+        doc.foreach_member(mod.cells, [&](const std::string &name, size_t pos) {
+            cell = JsonCell();
+            doc.foreach_member_raw(pos, [&](size_t key, size_t value) {
+                std::string_view key_str = doc.read_key(key, tmp);
+                if (key_str == "type")
+                    cell.type = doc.string_value(value);
+                else if (key_str == "attributes")
+                    cell.attributes = value;
+                else if (key_str == "parameters")
+                    cell.parameters = value;
+                else if (key_str == "port_directions")
+                    cell.port_directions = value;
+                else if (key_str == "connections")
+                    cell.connections = value;
+            });
+            Func(name, cell);
+        });
     }
 
-    template <typename TFunc> void foreach_netname(ModuleDataType &mod, TFunc Func) const
+    template <typename TFunc> void foreach_netname(const ModuleDataType &mod, TFunc Func) const
     {
-        const auto &netnames = mod["netnames"];
-        if (netnames.is_null())
-            return;
-        for (const auto &netname : netnames.object_items())
-            Func(netname.first, netname.second);
+        doc.foreach_member(mod.netnames, [&](const std::string &name, size_t pos) { Func(name, JsonObject{pos}); });
     }
 
     PortType lookup_portdir(const std::string &dir) const
@@ -85,126 +517,167 @@ struct JsonFrontendImpl
             NPNR_ASSERT_FALSE("invalid json port direction");
     }
 
-    PortType get_port_dir(ModulePortDataType &port) const { return lookup_portdir(port["direction"].string_value()); }
-
-    int get_array_offset(const Json &obj) const
+    PortType get_port_dir(const ModulePortDataType &port) const
     {
-        auto offset = obj["offset"];
-        return offset.is_null() ? 0 : offset.int_value();
+        return lookup_portdir(doc.string_value(doc.find_member(port.pos, "direction")));
     }
 
-    bool is_array_upto(const Json &obj) const
+    int get_array_offset(const JsonObject &obj) const { return doc.int_value(doc.find_member(obj.pos, "offset")); }
+
+    bool is_array_upto(const JsonObject &obj) const { return doc.int_value(doc.find_member(obj.pos, "upto")) != 0; }
+
+    BitVectorDataType parse_bits(size_t pos) const
     {
-        auto upto = obj["upto"];
-        return upto.is_null() ? false : bool(upto.int_value());
+        JsonBitVector result;
+        std::string tmp;
+        doc.foreach_element(pos, [&](size_t bit) {
+            if (doc.is_number(bit)) {
+                result.bits.push_back(doc.int_value(bit));
+            } else if (doc.at(bit) == '"') {
+                doc.read_string(bit, tmp);
+                result.bits.push_back((tmp.size() == 1) ? (-1 - int((unsigned char)tmp.at(0)))
+                                                        : JsonBitVector::invalid_constant);
+            } else {
+                doc.error(bit, "expected signal number or constant in bit vector");
+            }
+        });
+        return result;
     }
 
-    BitVectorDataType &get_port_bits(ModulePortDataType &port) const { return port["bits"].array_items(); }
+    BitVectorDataType get_port_bits(const ModulePortDataType &port) const
+    {
+        return parse_bits(doc.find_member(port.pos, "bits"));
+    }
 
-    const std::string &get_cell_type(CellDataType &cell) const { return cell["type"].string_value(); }
+    const std::string &get_cell_type(const CellDataType &cell) const { return cell.type; }
 
-    Property parse_property(const Json &val) const
+    Property parse_property(size_t pos) const
     {
-        if (val.is_number()) {
-            if (val.int_value() != val.number_value())
+        if (doc.is_number(pos)) {
+            double value = doc.read_number(pos);
+            if (!(value >= INT_MIN && value <= INT_MAX) || int(value) != value)
                 log_error("Found an out-of-range integer parameter in the JSON file.\n"
                           "Please regenerate the input file with an up-to-date version of yosys.\n");
-            return Property(val.int_value(), 32);
+            return Property(int(value), 32);
         } else {
-            return Property::from_string(val.string_value());
+            return Property::from_string(doc.string_value(pos));
         }
     }
 
-    template <typename TFunc> void foreach_attr(const Json &obj, TFunc Func) const
+    template <typename TFunc> void foreach_property(size_t pos, TFunc Func) const
     {
-        const auto &attrs = obj["attributes"];
-        if (attrs.is_null())
-            return;
-        for (const auto &attr : attrs.object_items()) {
-            Func(attr.first, parse_property(attr.second));
-        }
+        doc.foreach_member(pos, [&](const std::string &name, size_t value) { Func(name, parse_property(value)); });
     }
 
-    template <typename TFunc> void foreach_param(const Json &obj, TFunc Func) const
+    template <typename TFunc> void foreach_attr(const JsonModule &obj, TFunc Func) const
     {
-        const auto &params = obj["parameters"];
-        if (params.is_null())
-            return;
-        for (const auto &param : params.object_items()) {
-            Func(param.first, parse_property(param.second));
-        }
+        foreach_property(obj.attributes, Func);
     }
 
-    template <typename TFunc> void foreach_setting(const Json &obj, TFunc Func) const
+    template <typename TFunc> void foreach_attr(const JsonCell &obj, TFunc Func) const
     {
-        const auto &settings = obj["settings"];
-        if (settings.is_null())
-            return;
-        for (const auto &setting : settings.object_items()) {
-            Func(setting.first, parse_property(setting.second));
-        }
+        foreach_property(obj.attributes, Func);
+    }
+
+    template <typename TFunc> void foreach_attr(const JsonObject &obj, TFunc Func) const
+    {
+        foreach_property(doc.find_member(obj.pos, "attributes"), Func);
+    }
+
+    template <typename TFunc> void foreach_param(const CellDataType &obj, TFunc Func) const
+    {
+        foreach_property(obj.parameters, Func);
     }
 
-    template <typename TFunc> void foreach_port_dir(CellDataType &cell, TFunc Func) const
+    template <typename TFunc> void foreach_setting(const ModuleDataType &obj, TFunc Func) const
     {
-        for (const auto &pdir : cell["port_directions"].object_items())
-            Func(pdir.first, lookup_portdir(pdir.second.string_value()));
+        foreach_property(obj.settings, Func);
     }
 
-    template <typename TFunc> void foreach_port_conn(CellDataType &cell, TFunc Func) const
+    template <typename TFunc> void foreach_port_dir(const CellDataType &cell, TFunc Func) const
     {
-        for (const auto &pconn : cell["connections"].object_items())
-            Func(pconn.first, pconn.second.array_items());
+        doc.foreach_member(cell.port_directions, [&](const std::string &name, size_t value) {
+            Func(name, lookup_portdir(doc.string_value(value)));
+        });
     }
 
-    BitVectorDataType &get_net_bits(NetnameDataType &net) const { return net["bits"].array_items(); }
+    template <typename TFunc> void foreach_port_conn(const CellDataType &cell, TFunc Func) const
+    {
+        doc.foreach_member(cell.connections,
+                           [&](const std::string &name, size_t value) { Func(name, parse_bits(value)); });
+    }
+
+    BitVectorDataType get_net_bits(const NetnameDataType &net) const
+    {
+        return parse_bits(doc.find_member(net.pos, "bits"));
+    }
 
-    int get_vector_length(BitVectorDataType &bits) const { return int(bits.size()); }
+    int get_vector_length(const BitVectorDataType &bits) const { return int(bits.bits.size()); }
 
-    bool is_vector_bit_undef(BitVectorDataType &bits, int i) const
+    bool is_vector_bit_undef(const BitVectorDataType &bits, int i) const
     {
-        NPNR_ASSERT(i < int(bits.size()));
-        return bits[i] == "x";
+        NPNR_ASSERT(i < int(bits.bits.size()));
+        return bits.bits[i] == (-1 - int('x'));
     }
 
-    bool is_vector_bit_constant(BitVectorDataType &bits, int i) const
+    bool is_vector_bit_constant(const BitVectorDataType &bits, int i) const
     {
-        NPNR_ASSERT(i < int(bits.size()));
-        return bits[i].is_string();
+        NPNR_ASSERT(i < int(bits.bits.size()));
+        return bits.bits[i] < 0;
     }
 
-    char get_vector_bit_constval(BitVectorDataType &bits, int i) const
+    char get_vector_bit_constval(const BitVectorDataType &bits, int i) const
     {
-        auto s = bits.at(i).string_value();
-        NPNR_ASSERT(s.size() == 1);
-        return s.at(0);
+        int bit = bits.bits.at(i);
+        NPNR_ASSERT(bit < 0 && bit != JsonBitVector::invalid_constant);
+        return char(-1 - bit);
     }
 
-    int get_vector_bit_signal(BitVectorDataType &bits, int i) const
+    int get_vector_bit_signal(const BitVectorDataType &bits, int i) const
     {
-        NPNR_ASSERT(bits.at(i).is_number());
-        return bits.at(i).int_value();
+        int bit = bits.bits.at(i);
+        NPNR_ASSERT(bit >= 0);
+        return bit;
     }
 };
 
-bool parse_json(std::istream &in, const std::string &filename, Context *ctx)
+bool parse_json_buffer(const char *data, size_t size, const std::string &filename, Context *ctx)
 {
-    Json root;
-    {
-        if (!in)
-            log_error("Failed to open JSON file '%s'.\n", filename.c_str());
-        std::string json_str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-        std::string error;
-        root = Json::parse(json_str, error, JsonParse::COMMENTS);
-        if (root.is_null())
-            log_error("Failed to parse JSON file '%s': %s.\n", filename.c_str(), error.c_str());
-        root = root["modules"];
-        if (root.is_null())
-            log_error("JSON file '%s' doesn't look like a netlist (doesn't contain \"modules\" key)\n",
-                      filename.c_str());
-    }
-    GenericFrontend<JsonFrontendImpl>(ctx, JsonFrontendImpl(root), /*split_io=*/true)();
+    JsonDocument doc(data, size, filename);
+    size_t root = doc.validate();
+    size_t modules = doc.find_member(root, "modules");
+    if (modules == JsonDocument::npos || doc.matches(modules, "null"))
+        log_error("JSON file '%s' doesn't look like a netlist (doesn't contain \"modules\" key)\n", filename.c_str());
+    GenericFrontend<JsonFrontendImpl>(ctx, JsonFrontendImpl(doc, modules), /*split_io=*/true)();
     return true;
 }
 
+} // namespace
+
+bool parse_json(std::istream &in, const std::string &filename, Context *ctx)
+{
+    if (!in)
+        log_error("Failed to open JSON file '%s'.\n", filename.c_str());
+    std::string json_str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return parse_json_buffer(json_str.data(), json_str.size(), filename, ctx);
+}
+
+bool parse_json(const std::string &filename, Context *ctx)
+{
+    // Map regular files rather than reading them, so the netlist is never copied into memory. Anything else (pipes,
+    // empty files that can't be mapped) goes through the stream path.
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(filename, ec) && std::filesystem::file_size(filename, ec) > 0 && !ec) {
+        boost::iostreams::mapped_file_source file;
+        try {
+            file.open(filename);
+        } catch (std::exception &e) {
+            log_error("Failed to open JSON file '%s': %s.\n", filename.c_str(), e.what());
+        }
+        return parse_json_buffer(file.data(), file.size(), filename, ctx);
+    }
+    auto f = open_ifstream_and_log_error(filename, "JSON file");
+    return parse_json(f, filename, ctx);
+}
+
 NEXTPNR_NAMESPACE_END
@@ -22,5 +22,7 @@
 NEXTPNR_NAMESPACE_BEGIN
 
 bool parse_json(std::istream &in, const std::string &filename, Context *ctx);
+// Parse a JSON netlist from a file, memory mapping it where possible
+bool parse_json(const std::string &filename, Context *ctx);
 
 NEXTPNR_NAMESPACE_END
@@ -286,6 +286,8 @@ struct Arch : BaseArch<ArchRanges>
     NetInfo *getConflictingWireNet(WireId wire) const override;
     DelayQuad getWireDelay(WireId wire) const override { return DelayQuad(0); }
     linear_range<WireId> getWires() const override;
+    int getDenseWireCount() const override { return int(wires.size()); }
+    int getDenseWireIndex(WireId wire) const override { return wire.index; }
     const std::vector<BelPin> &getWireBelPins(WireId wire) const override;
 
     PipId getPipByName(IdStringList name) const override;
@@ -76,8 +76,9 @@ static void pack_lut_lutffs(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -106,8 +107,9 @@ static void pack_nonlut_ffs(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -154,8 +156,6 @@ static void pack_constants(Context *ctx)
     vcc_net->driver.port = ctx->id("F");
     vcc_cell->ports.at(ctx->id("F")).net = vcc_net.get();
 
-    std::vector<IdString> dead_nets;
-
     bool gnd_used = false, vcc_used = false;
 
     for (auto &net : ctx->nets) {
@@ -164,16 +164,17 @@ static void pack_constants(Context *ctx)
             IdString drv_cell = ni->driver.cell->name;
             set_net_constant(ctx, ni, gnd_net.get(), false);
             gnd_used = true;
-            dead_nets.push_back(net.first);
-            ctx->cells.erase(drv_cell);
+            ctx->markNetForDeletion(net.first);
+            ctx->markCellForDeletion(drv_cell);
         } else if (ni->driver.cell != nullptr && ni->driver.cell->type == ctx->id("VCC")) {
             IdString drv_cell = ni->driver.cell->name;
             set_net_constant(ctx, ni, vcc_net.get(), true);
             vcc_used = true;
-            dead_nets.push_back(net.first);
-            ctx->cells.erase(drv_cell);
+            ctx->markNetForDeletion(net.first);
+            ctx->markCellForDeletion(drv_cell);
         }
     }
+    ctx->flushDeletions();
 
     if (gnd_used) {
         ctx->cells[gnd_cell->name] = std::move(gnd_cell);
@@ -184,10 +185,6 @@ static void pack_constants(Context *ctx)
         ctx->cells[vcc_cell->name] = std::move(vcc_cell);
         ctx->nets[vcc_net->name] = std::move(vcc_net);
     }
-
-    for (auto dn : dead_nets) {
-        ctx->nets.erase(dn);
-    }
 }
 
 static bool is_nextpnr_iob(Context *ctx, CellInfo *cell)
@@ -259,11 +256,12 @@ static void pack_io(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
     for (auto dnet : delete_nets) {
-        ctx->nets.erase(dnet);
+        ctx->markNetForDeletion(dnet);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -287,8 +287,7 @@ void DesignWidget::newContext(Context *ctx)
     highlightSelected.clear();
     this->ctx = ctx;
     {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         {
             TreeModel::ElementXYRoot<BelId>::ElementMap belMap;
@@ -383,8 +382,7 @@ void DesignWidget::updateTree()
     }
 
     {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         std::vector<IdStringList> cells;
         for (auto &pair : ctx->cells) {
@@ -513,8 +511,7 @@ void DesignWidget::onClickedBel(BelId bel, bool keep)
 {
     boost::optional<TreeModel::Item *> item;
     {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         item = getTreeByElementType(ElementType::BEL)->nodeForId(ctx->getBelName(bel));
         if (!item)
@@ -536,8 +533,7 @@ void DesignWidget::onClickedWire(WireId wire, bool keep)
 {
     boost::optional<TreeModel::Item *> item;
     {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         item = getTreeByElementType(ElementType::WIRE)->nodeForId(ctx->getWireName(wire));
         if (!item)
@@ -558,8 +554,7 @@ void DesignWidget::onClickedPip(PipId pip, bool keep)
 {
     boost::optional<TreeModel::Item *> item;
     {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         item = getTreeByElementType(ElementType::PIP)->nodeForId(ctx->getPipName(pip));
         if (!item)
@@ -624,8 +619,7 @@ void DesignWidget::onSelectionChanged(int num, const QItemSelection &, const QIt
     Q_EMIT selected(getDecals(type, c), false);
 
     if (type == ElementType::BEL) {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         BelId bel = ctx->getBelByName(c);
         QtProperty *topItem = addTopLevelProperty("Bel");
@@ -653,8 +647,7 @@ void DesignWidget::onSelectionChanged(int num, const QItemSelection &, const QIt
             addProperty(portInfoItem, QVariant::String, "Wire", ctx->nameOfWire(wire), ElementType::WIRE);
         }
     } else if (type == ElementType::WIRE) {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         WireId wire = ctx->getWireByName(c);
         QtProperty *topItem = addTopLevelProperty("Wire");
@@ -715,8 +708,7 @@ void DesignWidget::onSelectionChanged(int num, const QItemSelection &, const QIt
             }
         }
     } else if (type == ElementType::PIP) {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         PipId pip = ctx->getPipByName(c);
         QtProperty *topItem = addTopLevelProperty("Pip");
@@ -750,8 +742,7 @@ void DesignWidget::onSelectionChanged(int num, const QItemSelection &, const QIt
         addProperty(delayItem, QVariant::Double, "Min Fall", delay.minFallDelay());
         addProperty(delayItem, QVariant::Double, "Max Fall", delay.maxFallDelay());
     } else if (type == ElementType::NET) {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         NetInfo *net = ctx->nets.at(c[0]).get();
 
@@ -799,8 +790,7 @@ void DesignWidget::onSelectionChanged(int num, const QItemSelection &, const QIt
         }
 
     } else if (type == ElementType::CELL) {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         CellInfo *cell = ctx->cells.at(c[0]).get();
 
@@ -1025,8 +1015,7 @@ void DesignWidget::onSearchInserted()
         if (currentIndex >= currentSearchIndexes.size())
             currentIndex = 0;
     } else {
-        std::lock_guard<std::mutex> lock_ui(ctx->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx->mutex);
+        UiLockGuard lock_ui(ctx);
 
         currentSearch = searchEdit->text();
         currentSearchIndexes = treeModel[tabWidget->currentIndex()]->search(searchEdit->text());
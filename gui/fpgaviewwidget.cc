@@ -402,8 +402,7 @@ void FPGAViewWidget::renderLines(void)
     {
         // Take the UI/Normal mutex on the Context, copy over all we need as
         // fast as we can.
-        std::lock_guard<std::mutex> lock_ui(ctx_->ui_mutex);
-        std::lock_guard<std::mutex> lock(ctx_->mutex);
+        UiLockGuard lock_ui(ctx_);
 
         // For now, collapse any decal changes into change of all decals.
         // TODO(q3k): fix this
@@ -226,8 +226,7 @@ void Model::fetchMore(const QModelIndex &parent)
     if (ctx_ == nullptr)
         return;
 
-    std::lock_guard<std::mutex> lock_ui(ctx_->ui_mutex);
-    std::lock_guard<std::mutex> lock(ctx_->mutex);
+    UiLockGuard lock_ui(ctx_);
 
     nodeFromIndex(parent)->fetchMore();
 }
@@ -20,6 +20,7 @@
 #include "arch.h"
 #include "archdefs.h"
 #include "chipdb.h"
+#include "compressed_chipdb.h"
 #include "log.h"
 #include "nextpnr.h"
 
@@ -130,11 +131,17 @@ void Arch::load_chipdb(const std::string &path)
         blob_file.open(db_path);
         if (db_path.empty() || !blob_file.is_open())
             log_error("Unable to read chipdb %s\n", db_path.c_str());
-        const char *blob = reinterpret_cast<const char *>(blob_file.data());
-        chip_info = get_chip_info(reinterpret_cast<const RelPtr<ChipInfoPOD> *>(blob));
     } catch (...) {
         log_error("Unable to read chipdb %s\n", db_path.c_str());
     }
+    const char *blob = reinterpret_cast<const char *>(blob_file.data());
+    if (is_compressed_chipdb(blob, blob_file.size())) {
+        // Relative pointers stay valid as the whole blob is decompressed into one buffer
+        blob_data = decompress_chipdb(blob, blob_file.size(), db_path);
+        blob_file.close();
+        blob = reinterpret_cast<const char *>(blob_data.get());
+    }
+    chip_info = get_chip_info(reinterpret_cast<const RelPtr<ChipInfoPOD> *>(blob));
     // Check consistency of blob
     if (chip_info->magic != 0x00ca7ca7)
         log_error("chipdb %s does not look like a valid himbächel database!\n", db_path.c_str());
@@ -197,6 +204,10 @@ void Arch::init_tiles()
             tile_name2idx[name] = tile;
         }
     }
+    tile_wire_base.reserve(chip_info->tile_insts.size() + 1);
+    tile_wire_base.push_back(0);
+    for (int tile = 0; tile < chip_info->tile_insts.ssize(); tile++)
+        tile_wire_base.push_back(tile_wire_base.back() + int(chip_tile_info(chip_info, tile).wires.ssize()));
 }
 
 void Arch::late_init()
@@ -481,6 +481,8 @@ struct Arch : BaseArch<ArchRanges>
 
     // Database references
     boost::iostreams::mapped_file_source blob_file;
+    // Only used for compressed chipdbs, which are decompressed into memory rather than mapped
+    std::unique_ptr<uint8_t[]> blob_data;
     const ChipInfoPOD *chip_info;
     const PackageInfoPOD *package_info = nullptr;
     const SpeedGradePOD *speed_grade = nullptr;
@@ -546,6 +548,9 @@ struct Arch : BaseArch<ArchRanges>
         return IdString(chip_wire_info(chip_info, wire).const_value);
     }
     WireRange getWires() const override { return WireRange(chip_info); }
+    // Dense index over all tile wires, only the canonical wire of each node is ever used
+    int getDenseWireCount() const override { return tile_wire_base.back(); }
+    int getDenseWireIndex(WireId wire) const override { return tile_wire_base[wire.tile] + wire.index; }
     bool checkWireAvail(WireId wire) const override
     {
         if (!uarch->checkWireAvail(wire))
@@ -897,6 +902,8 @@ struct Arch : BaseArch<ArchRanges>
     void set_fast_pip_delays(bool fast_mode);
     std::vector<IdString> tile_name;
     dict<IdString, int> tile_name2idx;
+    // Prefix sum of tile wire counts, for dense wire indices
+    std::vector<int> tile_wire_base;
 
     // -------------------------------------------------
     IdString get_tile_type(int tile) const;
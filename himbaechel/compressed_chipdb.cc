@@ -0,0 +1,110 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "compressed_chipdb.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "log.h"
+
+#ifdef HIMBAECHEL_COMPRESSED_CHIPDB
+#include <zlib.h>
+#endif
+#ifndef NPNR_DISABLE_THREADS
+#include <thread>
+#endif
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// The container format is described alongside its writer in bba/main.cc. In short: an 8 byte magic, the uncompressed
+// size, the chunk size and count, and then the file offset of each chunk; all little endian.
+static const char compressed_magic[8] = {'N', 'P', 'N', 'R', 'Z', 'D', 'B', '1'};
+static const size_t compressed_header_size = 24;
+
+bool is_compressed_chipdb(const char *data, size_t size)
+{
+    return size >= compressed_header_size && std::memcmp(data, compressed_magic, sizeof(compressed_magic)) == 0;
+}
+
+#ifdef HIMBAECHEL_COMPRESSED_CHIPDB
+namespace {
+uint64_t read_le(const char *data, int num_bytes)
+{
+    uint64_t value = 0;
+    for (int i = num_bytes - 1; i >= 0; i--)
+        value = (value << 8) | uint8_t(data[i]);
+    return value;
+}
+} // namespace
+#endif
+
+std::unique_ptr<uint8_t[]> decompress_chipdb(const char *data, size_t size, const std::string &filename)
+{
+#ifdef HIMBAECHEL_COMPRESSED_CHIPDB
+    uint64_t raw_size = read_le(data + 8, 8);
+    uint32_t chunk_size = read_le(data + 16, 4);
+    uint32_t num_chunks = read_le(data + 20, 4);
+    // Every chunk but the last must be full, so that no chunk can be decompressed past the end of the blob
+    uint64_t index_end = compressed_header_size + 8 * (uint64_t(num_chunks) + 1);
+    if (chunk_size == 0 || num_chunks != raw_size / chunk_size + (raw_size % chunk_size != 0) || index_end > size)
+        log_error("chipdb %s has a corrupt compression header\n", filename.c_str());
+    std::vector<uint64_t> offsets(num_chunks + 1);
+    for (uint32_t i = 0; i <= num_chunks; i++) {
+        offsets.at(i) = read_le(data + compressed_header_size + 8 * i, 8);
+        if (offsets.at(i) < ((i > 0) ? offsets.at(i - 1) : index_end) || offsets.at(i) > size)
+            log_error("chipdb %s has a corrupt compression index\n", filename.c_str());
+    }
+
+    std::unique_ptr<uint8_t[]> blob(new uint8_t[raw_size]);
+    std::atomic<bool> failed{false};
+    auto decompress_chunks = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            uint64_t start = uint64_t(i) * chunk_size;
+            uLongf expected = std::min<uint64_t>(chunk_size, raw_size - start), actual = expected;
+            int result = uncompress(blob.get() + start, &actual, reinterpret_cast<const Bytef *>(data + offsets.at(i)),
+                                    offsets.at(i + 1) - offsets.at(i));
+            if (result != Z_OK || actual != expected)
+                failed = true;
+        }
+    };
+#ifdef NPNR_DISABLE_THREADS
+    decompress_chunks(0, num_chunks);
+#else
+    uint32_t num_threads = std::max(1U, std::min(std::thread::hardware_concurrency(), num_chunks));
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < num_threads; t++)
+        threads.emplace_back(decompress_chunks, (num_chunks * t) / num_threads, (num_chunks * (t + 1)) / num_threads);
+    decompress_chunks(0, num_chunks / num_threads);
+    for (auto &thread : threads)
+        thread.join();
+#endif
+    if (failed)
+        log_error("chipdb %s failed to decompress\n", filename.c_str());
+    return blob;
+#else
+    NPNR_UNUSED(data);
+    NPNR_UNUSED(size);
+    log_error("chipdb %s is compressed, but nextpnr was built without HIMBAECHEL_COMPRESSED_CHIPDB\n",
+              filename.c_str());
+#endif
+}
+
+NEXTPNR_NAMESPACE_END
@@ -0,0 +1,41 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef HIMBAECHEL_COMPRESSED_CHIPDB_H
+#define HIMBAECHEL_COMPRESSED_CHIPDB_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "nextpnr_namespaces.h"
+
+NEXTPNR_NAMESPACE_BEGIN
+
+// Whether a chipdb file is a compressed container as written by `bbasm --z`, rather than a plain blob
+bool is_compressed_chipdb(const char *data, size_t size);
+
+// Decompress the blob in a compressed chipdb container into a newly allocated buffer. The blob is stored as
+// independently compressed chunks, which are decompressed in parallel. All of it is decompressed up front, as relative
+// pointers may point anywhere in the blob; which is why uncompressed, mapped chipdbs remain the default.
+std::unique_ptr<uint8_t[]> decompress_chipdb(const char *data, size_t size, const std::string &filename);
+
+NEXTPNR_NAMESPACE_END
+
+#endif
@@ -27,3 +27,74 @@ class BBAWriter:
 		print(f"u32 {n} {comment}", file=self.f)
 	def pop(self):
 		print("pop", file=self.f)
+
+class BinaryBBAWriter:
+	"""
+	Writes the compact binary form of the bba format that bbasm also accepts, which is faster to write and to assemble
+	than the text form. Comments are dropped, as bbasm only uses them for debug output. See parseBinary in bba/main.cc
+	for the encoding.
+	"""
+	MAGIC = b"\0BBAbin1"
+	LABEL, REF, U8, U16, U32, STR, PUSH, POP, PRE, POST, NAME = range(1, 12)
+
+	def __init__(self, f):
+		self.f = f
+		self.labels = {}
+		self.buf = bytearray(self.MAGIC)
+	def _int(self, n):
+		buf = self.buf
+		while n >= 0x80:
+			buf.append((n & 0x7f) | 0x80)
+			n >>= 7
+		buf.append(n)
+	def _str(self, op, s):
+		data = s.encode("utf-8")
+		self.buf.append(op)
+		self._int(len(data))
+		self.buf += data
+	def _label(self, name):
+		idx = self.labels.get(name)
+		if idx is None:
+			idx = len(self.labels)
+			self.labels[name] = idx
+			self._str(self.NAME, name)
+		return idx
+	def _flush(self):
+		self.f.write(self.buf)
+		self.buf = bytearray()
+	def pre(self, s):
+		self._str(self.PRE, s)
+	def post(self, s):
+		self._str(self.POST, s)
+	def push(self, s):
+		self._str(self.PUSH, s)
+	def ref(self, r, comment=""):
+		idx = self._label(r)
+		self.buf.append(self.REF)
+		self._int(idx)
+	def slice(self, r, size, comment=""):
+		self.ref(r)
+		self.u32(size)
+	def str(self, s, comment=""):
+		self._str(self.STR, s)
+	def label(self, s):
+		idx = self._label(s)
+		self.buf.append(self.LABEL)
+		self._int(idx)
+		if len(self.buf) > (1 << 20):
+			self._flush()
+	def u8(self, n, comment=""):
+		assert isinstance(n, int), n
+		self.buf.append(self.U8)
+		self._int(n & 0xff)
+	def u16(self, n, comment=""):
+		assert isinstance(n, int), n
+		self.buf.append(self.U16)
+		self._int(n & 0xffff)
+	def u32(self, n, comment=""):
+		assert isinstance(n, int), n
+		self.buf.append(self.U32)
+		self._int(n & 0xffffffff)
+	def pop(self):
+		self.buf.append(self.POP)
+		self._flush()
@@ -1,5 +1,5 @@
 from dataclasses import dataclass, field
-from .bba import BBAWriter
+from .bba import BBAWriter, BinaryBBAWriter
 from enum import Enum
 from typing import Optional
 import abc
@@ -944,10 +944,11 @@ class Chip:
         else:
             bba.u32(0)
 
-    def write_bba(self, filename):
+    def write_bba(self, filename, binary=True):
+        # The binary form is much quicker for bbasm to assemble; the text form is human readable
         self.timing.finalise()
-        with open(filename, "w") as f:
-            bba = BBAWriter(f)
+        with open(filename, "wb" if binary else "w") as f:
+            bba = BinaryBBAWriter(f) if binary else BBAWriter(f)
             bba.pre('#include \"nextpnr.h\"')
             bba.pre('NEXTPNR_NAMESPACE_BEGIN')
             bba.post('NEXTPNR_NAMESPACE_END')
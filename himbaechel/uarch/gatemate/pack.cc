@@ -34,8 +34,9 @@ void GateMatePacker::flush_cells()
         }
         if (ctx->cells[pcell]->bel != BelId())
             ctx->unbindBel(ctx->cells[pcell]->bel);
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     packed_cells.clear();
 }
 
@@ -63,8 +63,9 @@ void NgUltraPacker::flush_cells()
         for (auto &port : ctx->cells[pcell]->ports) {
             ctx->cells[pcell]->disconnectPort(port.first);
         }
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     packed_cells.clear();
 }
 
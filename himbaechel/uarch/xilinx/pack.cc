@@ -42,8 +42,9 @@ void XilinxPacker::flush_cells()
         for (auto &port : ctx->cells[pcell]->ports) {
             ctx->cells[pcell]->disconnectPort(port.first);
         }
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     packed_cells.clear();
 }
 
@@ -546,8 +547,6 @@ void XilinxPacker::pack_constants()
     }
     NetInfo *gnd = ctx->nets[ctx->id("$PACKER_GND_NET")].get(), *vcc = ctx->nets[ctx->id("$PACKER_VCC_NET")].get();
 
-    std::vector<IdString> dead_nets;
-
     std::vector<std::tuple<CellInfo *, IdString, bool>> const_ports;
 
     for (auto &cell : ctx->cells) {
@@ -571,16 +570,16 @@ void XilinxPacker::pack_constants()
                 const_ports.emplace_back(usr.cell, usr.port, false);
                 usr.cell->ports.at(usr.port).net = nullptr;
             }
-            dead_nets.push_back(net.first);
-            ctx->cells.erase(drv_cell);
+            ctx->markNetForDeletion(net.first);
+            ctx->markCellForDeletion(drv_cell);
         } else if (ni->driver.cell != nullptr && ni->driver.cell->type == id_VCC) {
             IdString drv_cell = ni->driver.cell->name;
             for (auto &usr : ni->users) {
                 const_ports.emplace_back(usr.cell, usr.port, true);
                 usr.cell->ports.at(usr.port).net = nullptr;
             }
-            dead_nets.push_back(net.first);
-            ctx->cells.erase(drv_cell);
+            ctx->markNetForDeletion(net.first);
+            ctx->markCellForDeletion(drv_cell);
         }
     }
 
@@ -609,9 +608,7 @@ void XilinxPacker::pack_constants()
         ci->connectPort(pname, cval ? vcc : gnd);
     }
 
-    for (auto dn : dead_nets) {
-        ctx->nets.erase(dn);
-    }
+    ctx->flushDeletions();
 }
 
 void XilinxPacker::rename_net(IdString old, IdString newname)
@@ -125,6 +125,7 @@ Arch::Arch(ArchArgs args) : args(args)
 
     bel_carry.resize(chip_info->bel_data.size());
     bel_to_cell.resize(chip_info->bel_data.size());
+    lc_legality.init(chip_info->width * chip_info->height);
     wire_to_net.resize(chip_info->wire_data.size());
     pip_to_net.resize(chip_info->pip_data.size());
     switches_locked.resize(chip_info->num_switches);
@@ -1253,6 +1254,8 @@ void Arch::assignArchInfo()
         CellInfo *ci = cell.second.get();
         assignCellInfo(ci);
     }
+    // Global net status may have changed, too
+    lc_legality.init(chip_info->width * chip_info->height);
 }
 
 void Arch::assignCellInfo(CellInfo *cell)
@@ -1294,6 +1297,8 @@ void Arch::assignCellInfo(CellInfo *cell)
     } else if (cell->type == id_SB_GB) {
         cell->gbInfo.forPadIn = bool_or_default(cell->attrs, id_FOR_PAD_IN);
     }
+    if (cell->bel != BelId())
+        invalidate_bel_legality(cell->bel);
 }
 
 BoundingBox Arch::getRouteBoundingBox(WireId src, WireId dst) const
@@ -407,6 +407,8 @@ struct Arch : BaseArch<ArchRanges>
 
     std::vector<bool> bel_carry;
     std::vector<CellInfo *> bel_to_cell;
+    // Logic tile legality, by y * width + x
+    mutable TileLegalityCache lc_legality;
     std::vector<NetInfo *> wire_to_net;
     std::vector<NetInfo *> pip_to_net;
     std::vector<WireId> switches_locked;
@@ -456,6 +458,7 @@ struct Arch : BaseArch<ArchRanges>
         bel_carry[bel.index] = (cell->type == id_ICESTORM_LC && cell->lcInfo.carryEnable);
         cell->bel = bel;
         cell->belStrength = strength;
+        invalidate_bel_legality(bel);
         refreshUiBel(bel);
     }
 
@@ -467,9 +470,17 @@ struct Arch : BaseArch<ArchRanges>
         bel_to_cell[bel.index]->belStrength = STRENGTH_NONE;
         bel_to_cell[bel.index] = nullptr;
         bel_carry[bel.index] = false;
+        invalidate_bel_legality(bel);
         refreshUiBel(bel);
     }
 
+    void invalidate_bel_legality(BelId bel)
+    {
+        const auto &data = chip_info->bel_data[bel.index];
+        if (IdString(data.type) == id_ICESTORM_LC)
+            lc_legality.invalidate(data.y * chip_info->width + data.x);
+    }
+
     bool checkBelAvail(BelId bel) const override
     {
         NPNR_ASSERT(bel != BelId());
@@ -610,6 +621,9 @@ struct Arch : BaseArch<ArchRanges>
         return range;
     }
 
+    int getDenseWireCount() const override { return int(chip_info->wire_data.size()); }
+    int getDenseWireIndex(WireId wire) const override { return wire.index; }
+
     // -------------------------------------------------
 
     PipId getPipByName(IdStringList name) const override;
@@ -85,15 +85,17 @@ static inline bool _io_pintype_need_clk_en(unsigned pin_type)
 bool Arch::isBelLocationValid(BelId bel, bool explain_invalid) const
 {
     if (getBelType(bel) == id_ICESTORM_LC) {
-        std::array<const CellInfo *, 8> bel_cells;
-        size_t num_cells = 0;
         Loc bel_loc = getBelLocation(bel);
-        for (auto bel_other : getBelsByTile(bel_loc.x, bel_loc.y)) {
-            CellInfo *ci_other = getBoundBelCell(bel_other);
-            if (ci_other != nullptr)
-                bel_cells[num_cells++] = ci_other;
-        }
-        return logic_cells_compatible(bel_cells.data(), num_cells);
+        return lc_legality.get(bel_loc.y * chip_info->width + bel_loc.x, legality_stats, [&]() {
+            std::array<const CellInfo *, 8> bel_cells;
+            size_t num_cells = 0;
+            for (auto bel_other : getBelsByTile(bel_loc.x, bel_loc.y)) {
+                CellInfo *ci_other = getBoundBelCell(bel_other);
+                if (ci_other != nullptr)
+                    bel_cells[num_cells++] = ci_other;
+            }
+            return logic_cells_compatible(bel_cells.data(), num_cells);
+        });
     } else {
         const CellInfo *cell = getBoundBelCell(bel);
         if (cell == nullptr)
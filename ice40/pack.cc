@@ -89,8 +89,9 @@ static void pack_lut_lutffs(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -122,8 +123,9 @@ static void pack_nonlut_ffs(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -260,8 +262,9 @@ static void pack_carries(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -325,8 +328,9 @@ static void merge_carry_luts(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     log_info("    %4d LUTs merged into carry LCs\n", int(packed_cells.size()));
 }
 
@@ -368,8 +372,9 @@ static void pack_ram(Context *ctx)
     }
 
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -436,8 +441,6 @@ static void pack_constants(Context *ctx)
         vcc_net_info = ctx->nets.find(ctx->id("$PACKER_VCC_NET"))->second.get();
     }
 
-    std::vector<IdString> dead_nets;
-
     bool gnd_used = false;
 
     for (auto &net : ctx->nets) {
@@ -446,15 +449,16 @@ static void pack_constants(Context *ctx)
             IdString drv_cell = ni->driver.cell->name;
             set_net_constant(ctx, ni, gnd_net_info, false);
             gnd_used = true;
-            dead_nets.push_back(net.first);
-            ctx->cells.erase(drv_cell);
+            ctx->markNetForDeletion(net.first);
+            ctx->markCellForDeletion(drv_cell);
         } else if (ni->driver.cell != nullptr && ni->driver.cell->type == id_VCC) {
             IdString drv_cell = ni->driver.cell->name;
             set_net_constant(ctx, ni, vcc_net_info, true);
-            dead_nets.push_back(net.first);
-            ctx->cells.erase(drv_cell);
+            ctx->markNetForDeletion(net.first);
+            ctx->markCellForDeletion(drv_cell);
         }
     }
+    ctx->flushDeletions();
 
     if (gnd_used && (gnd_net_info == gnd_net.get())) {
         ctx->cells[gnd_cell->name] = std::move(gnd_cell);
@@ -466,10 +470,6 @@ static void pack_constants(Context *ctx)
         ctx->cells[vcc_cell->name] = std::move(vcc_cell);
         ctx->nets[vcc_net->name] = std::move(vcc_net);
     }
-
-    for (auto dn : dead_nets) {
-        ctx->nets.erase(dn);
-    }
 }
 
 static BelId find_padin_gbuf(Context *ctx, BelId bel, IdString port_name)
@@ -629,11 +629,12 @@ static void pack_io(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
     for (auto dnet : delete_nets) {
-        ctx->nets.erase(dnet);
+        ctx->markNetForDeletion(dnet);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -1377,8 +1378,9 @@ static void pack_special(Context *ctx)
     }
 
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
@@ -1709,8 +1711,9 @@ void pack_plls(Context *ctx)
         }
     }
     for (auto pcell : packed_cells) {
-        ctx->cells.erase(pcell);
+        ctx->markCellForDeletion(pcell);
     }
+    ctx->flushDeletions();
     for (auto &ncell : new_cells) {
         ctx->cells[ncell->name] = std::move(ncell);
     }
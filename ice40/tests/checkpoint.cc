@@ -0,0 +1,106 @@
+/*
+ *  nextpnr -- Next Generation Place and Route
+ *
+ *  Copyright (C) 2024  The nextpnr Authors
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "cells.h"
+#include "gtest/gtest.h"
+#include "nextpnr.h"
+
+USING_NEXTPNR_NAMESPACE
+
+class CheckpointTest : public ::testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        chipArgs.type = ArchArgs::HX1K;
+        chipArgs.package = "tq144";
+        ctx = new Context(chipArgs);
+        filename = (std::filesystem::temp_directory_path() / "nextpnr-ice40-checkpoint-test.bin").string();
+    }
+
+    virtual void TearDown()
+    {
+        delete ctx;
+        std::filesystem::remove(filename);
+    }
+
+    ArchArgs chipArgs;
+    Context *ctx = nullptr;
+    std::string filename;
+};
+
+TEST_F(CheckpointTest, placed_carry_chain)
+{
+    // A four LC carry chain, clustered and placed at the bottom of the first logic tile
+    BelId base_bel;
+    for (auto bel : ctx->getBels()) {
+        if (ctx->getBelType(bel) == id_ICESTORM_LC && ctx->getBelLocation(bel).z == 0) {
+            base_bel = bel;
+            break;
+        }
+    }
+    ASSERT_NE(base_bel, BelId());
+    Loc base_loc = ctx->getBelLocation(base_bel);
+
+    std::vector<CellInfo *> chain;
+    for (int i = 0; i < 4; i++) {
+        auto cell = create_ice_cell(ctx, id_ICESTORM_LC, "carry_" + std::to_string(i));
+        cell->params[id_CARRY_ENABLE] = Property::State::S1;
+        chain.push_back(cell.get());
+        ctx->cells[cell->name] = std::move(cell);
+    }
+    for (int i = 0; i < 3; i++) {
+        NetInfo *net = ctx->createNet(ctx->idf("carry_net_%d", i));
+        chain.at(i)->connectPort(id_COUT, net);
+        chain.at(i + 1)->connectPort(id_CIN, net);
+    }
+    chain.at(0)->cluster = chain.at(0)->name;
+    for (int i = 1; i < 4; i++) {
+        chain.at(i)->cluster = chain.at(0)->name;
+        chain.at(i)->constr_z = i;
+        chain.at(0)->constr_children.push_back(chain.at(i));
+    }
+    ctx->assignArchInfo();
+    for (int i = 0; i < 4; i++)
+        ctx->bindBel(ctx->getBelByLocation(Loc(base_loc.x, base_loc.y, i)), chain.at(i), STRENGTH_WEAK);
+
+    {
+        std::ofstream out(filename, std::ios::binary);
+        ctx->writeCheckpoint(out);
+    }
+    Context loaded(chipArgs);
+    loaded.readCheckpoint(filename);
+
+    for (int i = 0; i < 4; i++) {
+        CellInfo *ci = loaded.cells.at(chain.at(i)->name).get();
+        ASSERT_EQ(ci->bel, chain.at(i)->bel);
+        ASSERT_TRUE(ci->lcInfo.carryEnable);
+        ASSERT_EQ(ci->cluster, chain.at(0)->name);
+        ASSERT_EQ(ci->constr_z, chain.at(i)->constr_z);
+    }
+    ASSERT_EQ(loaded.cells.at(chain.at(0)->name)->constr_children.size(), 3U);
+    // Pips that may not be used next to a carry must be unavailable in the loaded design, as in the original
+    for (auto bel : ctx->getBels())
+        ASSERT_EQ(loaded.bel_carry[bel.index], ctx->bel_carry[bel.index]);
+    for (auto pip : ctx->getPips())
+        ASSERT_EQ(loaded.checkPipAvail(pip), ctx->checkPipAvail(pip));
+}
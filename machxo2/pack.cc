@@ -45,8 +45,9 @@ class MachXO2Packer
     void flush_cells()
     {
         for (auto pcell : packed_cells) {
-            ctx->cells.erase(pcell);
+            ctx->markCellForDeletion(pcell);
         }
+        ctx->flushDeletions();
         for (auto &ncell : new_cells) {
             ctx->cells[ncell->name] = std::move(ncell);
         }
@@ -962,8 +963,6 @@ class MachXO2Packer
         vcc_net->driver.port = id_Z;
         vcc_cell->ports.at(id_Z).net = vcc_net.get();
 
-        std::vector<IdString> dead_nets;
-
         bool gnd_used = false, vcc_used = false;
 
         for (auto &net : ctx->nets) {
@@ -972,16 +971,17 @@ class MachXO2Packer
                 IdString drv_cell = ni->driver.cell->name;
                 set_net_constant(ctx, ni, gnd_net.get(), false);
                 gnd_used = true;
-                dead_nets.push_back(net.first);
-                ctx->cells.erase(drv_cell);
+                ctx->markNetForDeletion(net.first);
+                ctx->markCellForDeletion(drv_cell);
             } else if (ni->driver.cell != nullptr && ni->driver.cell->type == id_VCC) {
                 IdString drv_cell = ni->driver.cell->name;
                 set_net_constant(ctx, ni, vcc_net.get(), true);
                 vcc_used = true;
-                dead_nets.push_back(net.first);
-                ctx->cells.erase(drv_cell);
+                ctx->markNetForDeletion(net.first);
+                ctx->markCellForDeletion(drv_cell);
             }
         }
+        ctx->flushDeletions();
 
         if (gnd_used) {
             ctx->cells[gnd_cell->name] = std::move(gnd_cell);
@@ -991,10 +991,6 @@ class MachXO2Packer
             ctx->cells[vcc_cell->name] = std::move(vcc_cell);
             ctx->nets[vcc_net->name] = std::move(vcc_net);
         }
-
-        for (auto dn : dead_nets) {
-            ctx->nets.erase(dn);
-        }
     }
 
     void autocreate_empty_port(CellInfo *cell, IdString port)
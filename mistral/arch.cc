@@ -185,12 +185,18 @@ IdStringList Arch::getBelName(BelId bel) const
 bool Arch::isBelLocationValid(BelId bel, bool explain_invalid) const
 {
     auto &data = bel_data(bel);
-    if (data.type.in(id_MISTRAL_COMB, id_MISTRAL_MCOMB)) {
-        return is_alm_legal(data.lab_data.lab, data.lab_data.alm) && check_lab_input_count(data.lab_data.lab) &&
-               check_mlab_groups(data.lab_data.lab);
-    } else if (data.type == id_MISTRAL_FF) {
-        return is_alm_legal(data.lab_data.lab, data.lab_data.alm) && check_lab_input_count(data.lab_data.lab) &&
-               is_lab_ctrlset_legal(data.lab_data.lab) && check_mlab_groups(data.lab_data.lab);
+    if (data.type.in(id_MISTRAL_COMB, id_MISTRAL_MCOMB, id_MISTRAL_FF)) {
+        uint32_t lab = data.lab_data.lab;
+        uint8_t alm = data.lab_data.alm;
+        const auto &lab_info = labs.at(lab);
+        if (!lab_info.alms.at(alm).legality.get(legality_stats, [&]() { return is_alm_legal(lab, alm); }))
+            return false;
+        if (!lab_info.lab_legality.get(legality_stats,
+                                       [&]() { return check_lab_input_count(lab) && check_mlab_groups(lab); }))
+            return false;
+        if (data.type == id_MISTRAL_FF &&
+            !lab_info.ctrlset_legality.get(legality_stats, [&]() { return is_lab_ctrlset_legal(lab); }))
+            return false;
     }
     return true;
 }
@@ -200,6 +206,10 @@ void Arch::update_bel(BelId bel)
     auto &data = bel_data(bel);
     if (data.type.in(id_MISTRAL_COMB, id_MISTRAL_MCOMB, id_MISTRAL_FF)) {
         update_alm_input_count(data.lab_data.lab, data.lab_data.alm);
+        auto &lab_info = labs.at(data.lab_data.lab);
+        lab_info.alms.at(data.lab_data.alm).legality.invalidate();
+        lab_info.lab_legality.invalidate();
+        lab_info.ctrlset_legality.invalidate();
     }
 }
 
@@ -433,6 +443,12 @@ void Arch::assignArchInfo()
             assign_ff_info(ci);
         assign_default_pinmap(ci);
     }
+    for (auto &lab_info : labs) {
+        for (auto &alm : lab_info.alms)
+            alm.legality.invalidate();
+        lab_info.lab_legality.invalidate();
+        lab_info.ctrlset_legality.invalidate();
+    }
 }
 
 BoundingBox Arch::getRouteBoundingBox(WireId src, WireId dst) const
@@ -55,6 +55,9 @@ struct ALMInfo
 
     // For keeping track of how many inputs are currently being used, for the LAB routeability check
     int unique_input_count = 0;
+
+    // Cached result of is_alm_legal
+    mutable CachedLegality legality;
 };
 
 struct LABInfo
@@ -68,6 +71,9 @@ struct LABInfo
     WireId sclr_wire, sload_wire;
     // TODO: LAB configuration (control set etc)
     std::array<bool, 2> aclr_used;
+
+    // Cached results of the LAB input count and MLAB checks; and of the control set check
+    mutable CachedLegality lab_legality, ctrlset_legality;
 };
 
 struct PinInfo
@@ -153,9 +153,10 @@ struct MistralPacker
         }
 
         for (IdString rem_net : trim_nets)
-            ctx->nets.erase(rem_net);
+            ctx->markNetForDeletion(rem_net);
         for (IdString rem_cell : trim_cells)
-            ctx->cells.erase(rem_cell);
+            ctx->markCellForDeletion(rem_cell);
+        ctx->flushDeletions();
     }
 
     void pack_constants()
@@ -247,8 +248,9 @@ struct MistralPacker
             // Now remove the nextpnr-inserted buffer
             ci->disconnectPort(id_I);
             ci->disconnectPort(id_O);
-            ctx->cells.erase(port.first);
+            ctx->markCellForDeletion(port.first);
         }
+        ctx->flushDeletions();
     }
 
     void pack_io()
@@ -896,14 +896,9 @@ struct Arch : BaseArch<ArchRanges>
     // Binding states
     struct LogicTileStatus
     {
-        struct SliceStatus
-        {
-            bool valid = true, dirty = true;
-        } slices[4];
-        struct HalfTileStatus
-        {
-            bool valid = true, dirty = true;
-        } halfs[2];
+        CachedLegality slices[4];
+        // Control set legality, for each half of the tile
+        CachedLegality halfs[2];
         CellInfo *cells[32];
     };
 
@@ -1471,16 +1466,18 @@ struct Arch : BaseArch<ArchRanges>
         case BEL_FF0:
         case BEL_FF1:
         case BEL_RAMW:
-            ts.halfs[(z >> 3) / 2].dirty = true;
+            ts.halfs[(z >> 3) / 2].invalidate();
         /* fall-through */
         case BEL_LUT0:
         case BEL_LUT1:
-            ts.slices[(z >> 3)].dirty = true;
+            ts.slices[(z >> 3)].invalidate();
             break;
         }
     }
 
     bool nexus_logic_tile_valid(LogicTileStatus &lts) const;
+    bool nexus_slice_valid(const LogicTileStatus &lts, int s) const;
+    bool nexus_half_valid(const LogicTileStatus &lts, int h) const;
 
     CellPinMux get_cell_pinmux(const CellInfo *cell, IdString pin) const;
     void set_cell_pinmux(CellInfo *cell, IdString pin, CellPinMux state);
@@ -398,9 +398,10 @@ struct NexusPacker
         }
 
         for (IdString rem_net : trim_nets)
-            ctx->nets.erase(rem_net);
+            ctx->markNetForDeletion(rem_net);
         for (IdString rem_cell : trim_cells)
-            ctx->cells.erase(rem_cell);
+            ctx->markCellForDeletion(rem_cell);
+        ctx->flushDeletions();
     }
 
     std::string remove_brackets(const std::string &name)
@@ -546,8 +547,9 @@ struct NexusPacker
             // Now remove the nextpnr-inserted buffer
             ci->disconnectPort(id_I);
             ci->disconnectPort(id_O);
-            ctx->cells.erase(port.first);
+            ctx->markCellForDeletion(port.first);
         }
+        ctx->flushDeletions();
     }
 
     BelId get_bel_attr(const CellInfo *ci)
@@ -2742,6 +2744,18 @@ void Arch::assignArchInfo()
     for (auto &cell : cells) {
         assignCellInfo(cell.second.get());
     }
+    // The packer only flags DSP clusters with the 9x9/18x18 placement, so recover that from the cluster for designs
+    // loaded from a checkpoint
+    for (auto &cell : cells) {
+        CellInfo *ci = cell.second.get();
+        if (ci->type != id_PREADD9_CORE || ci->cluster != ci->name)
+            continue;
+        int mult18_count = 0;
+        for (auto child : ci->constr_children)
+            if (child->type == id_MULT18_CORE)
+                mult18_count++;
+        ci->is_9x9_18x18 = (mult18_count <= 2);
+    }
 }
 
 const std::vector<std::string> dsp_bus_prefices = {